@@ -1,8 +1,27 @@
 #include "WeatherCSVReader.h"
+#include "CSVSchema.h"
+#include "CSVTokenizer.h"
 #include <iostream>
 #include <fstream>
-#include <sstream>
+#include <string_view>
 #include <map>
+#include <optional>
+
+namespace
+{
+    /** the columns of one line that readWeatherCSV uses */
+    struct WeatherRow
+    {
+        std::string_view timestamp;
+        std::vector<std::optional<double>> temperatures; // One per *temperature column, empty if not a number
+    };
+
+    constexpr char temperatureSuffix[] = "temperature";
+
+    using WeatherSchema = CSVSchema<WeatherRow,
+                                    CSVColumn<CSVAt<0>, &WeatherRow::timestamp>, // utc_timestamp
+                                    CSVOptional<CSVEndsWith<temperatureSuffix>, &WeatherRow::temperatures>>;
+}
 
 WeatherCSVReader::WeatherCSVReader()
 {
@@ -20,53 +39,38 @@ std::vector<WeatherData> WeatherCSVReader::readWeatherCSV(std::string csvFilenam
         return weatherRecords;
     }
     
-    // Read header line to find column indices
+    // Read header line and bind the schema's columns to it
     std::getline(csvFile, line);
-    std::vector<std::string> headers = tokenise(line, ',');
+    CSVRowParser<WeatherSchema> parser{line};
+    parser.setMinFields(CSVTokenizer::countFields(line)); // Lines shorter than the header are skipped
     
-    // Map country codes to their temperature column indices
-    std::map<std::string, int> countryColumns;
-    for (size_t i = 0; i < headers.size(); ++i)
+    // Map country codes to their position among the temperature columns
+    std::map<std::string, std::size_t> countryColumns;
+    const std::vector<std::string>& temperatureHeaders = parser.getHeaders(1);
+    for (std::size_t i = 0; i < temperatureHeaders.size(); ++i)
     {
-        std::string header = headers[i];
-        if (header.length() >= 12 && header.substr(header.length() - 11) == "temperature")
-        {
-            // Extract country code (e.g., "GB_temperature" -> "GB")
-            std::string countryCode = header.substr(0, 2);
-            countryColumns[countryCode] = static_cast<int>(i);
-        }
+        // Extract country code (e.g., "GB_temperature" -> "GB")
+        countryColumns[temperatureHeaders[i].substr(0, 2)] = i;
     }
     
     std::cout << "Found temperature data for " << countryColumns.size() << " countries." << std::endl;
     
     // Read data lines
+    WeatherRow row;
     int lineCount = 0;
     while (std::getline(csvFile, line) && lineCount < 10000) // Limit to first 10,000 records for testing
     {
         if (line.empty()) continue;
+        if (!parser.parse(line, row)) continue; // Short line
         
-        std::vector<std::string> tokens = tokenise(line, ',');
-        if (tokens.size() < headers.size()) continue;
-        
-        std::string timestamp = tokens[0]; // First column is utc_timestamp
-        
-        // Create WeatherData objects for each country in this timestamp
+        // Create WeatherData objects for each country in this timestamp, skipping invalid temperatures
+        std::string timestamp{row.timestamp};
         for (const auto& pair : countryColumns)
         {
-            std::string country = pair.first;
-            int columnIndex = pair.second;
-            
-            if (columnIndex < static_cast<int>(tokens.size()))
+            const std::optional<double>& temperature = row.temperatures[pair.second];
+            if (temperature)
             {
-                try
-                {
-                    double temperature = std::stod(tokens[columnIndex]);
-                    weatherRecords.emplace_back(timestamp, country, temperature);
-                }
-                catch (const std::exception& e)
-                {
-                    // Skip invalid temperature values
-                }
+                weatherRecords.emplace_back(timestamp, pair.first, *temperature);
             }
         }
         
@@ -84,12 +88,10 @@ std::vector<WeatherData> WeatherCSVReader::readWeatherCSV(std::string csvFilenam
 std::vector<std::string> WeatherCSVReader::tokenise(std::string csvLine, char separator)
 {
     std::vector<std::string> tokens;
-    std::stringstream ss(csvLine);
-    std::string token;
-    
-    while (std::getline(ss, token, separator))
+    CSVTokenizer fields{csvLine, separator};
+    while (fields.next())
     {
-        tokens.push_back(token);
+        tokens.push_back(fields.unquoted());
     }
     
     return tokens;
@@ -0,0 +1,166 @@
+#include "ArbitrageScanner.h"
+#include "CSVReader.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+ArbitrageScanner::ArbitrageScanner(const OrderBook& book, double fee) : book(book)
+{
+    feeFactor = (1 - fee) * (1 - fee) * (1 - fee);
+
+    std::map<std::string, std::size_t> currencyIds;
+    for (const std::string& product : book.getKnownProducts())
+    {
+        std::vector<std::string> currs = CSVReader::tokenise(product, '/');
+        if (currs.size() != 2) continue;
+        for (const std::string& c : currs)
+        {
+            if (currencyIds.count(c) == 0)
+            {
+                currencyIds[c] = currencies.size();
+                currencies.push_back(c);
+            }
+        }
+        productIds[product] = products.size();
+        products.push_back(product);
+        legFrom.push_back(currencyIds[currs[0]]); // Sell the base at the bid
+        legTo.push_back(currencyIds[currs[1]]);
+        legFrom.push_back(currencyIds[currs[1]]); // Buy the base at the ask
+        legTo.push_back(currencyIds[currs[0]]);
+    }
+    addCycles();
+
+    legRate.resize(legFrom.size());
+    legCapacity.resize(legFrom.size());
+    cycleRate.resize(leg0.size());
+    cycleAmount.resize(leg0.size());
+    productEdge.assign(products.size(), 0);
+}
+
+void ArbitrageScanner::addCycles()
+{
+    // leg out of each currency into each other one, if a product trades the pair
+    std::size_t n = currencies.size();
+    std::vector<int> legBetween(n * n, -1);
+    std::vector<std::vector<unsigned int>> legsFrom(n);
+    for (std::size_t l = 0; l < legFrom.size(); ++l)
+    {
+        if (legBetween[legFrom[l] * n + legTo[l]] >= 0) continue; // Two products for one pair, keep the first
+        legBetween[legFrom[l] * n + legTo[l]] = l;
+        legsFrom[legFrom[l]].push_back(l);
+    }
+
+    // every cycle starts from its lowest numbered currency so each is listed once per direction
+    for (std::size_t a = 0; a < n; ++a)
+    {
+        for (unsigned int first : legsFrom[a])
+        {
+            std::size_t b = legTo[first];
+            if (b < a) continue;
+            for (unsigned int second : legsFrom[b])
+            {
+                std::size_t c = legTo[second];
+                if (c < a || c == b) continue;
+                int third = legBetween[c * n + a];
+                if (third < 0) continue;
+                leg0.push_back(first);
+                leg1.push_back(second);
+                leg2.push_back(third);
+            }
+        }
+    }
+}
+
+std::vector<ArbitrageOpportunity> ArbitrageScanner::scan(const std::string& timestamp, double minEdge)
+{
+    // the best level of each book gives both of its legs
+    for (std::size_t p = 0; p < products.size(); ++p)
+    {
+        std::vector<PriceLevel> bid = book.getDepth(OrderBookType::bid, products[p], timestamp, 1);
+        std::vector<PriceLevel> ask = book.getDepth(OrderBookType::ask, products[p], timestamp, 1);
+        legRate[2 * p] = bid.empty() ? 0 : bid[0].price;
+        legCapacity[2 * p] = bid.empty() ? 0 : bid[0].amount; // In the base
+        legRate[2 * p + 1] = ask.empty() || ask[0].price <= 0 ? 0 : 1 / ask[0].price;
+        legCapacity[2 * p + 1] = ask.empty() ? 0 : ask[0].amount * ask[0].price; // In the quote
+    }
+
+    // straight loops over flat arrays, no branches, so the compiler can vectorise them
+    std::size_t cycles = leg0.size();
+    const double* rate = legRate.data();
+    const double* capacity = legCapacity.data();
+    for (std::size_t i = 0; i < cycles; ++i)
+    {
+        double r0 = rate[leg0[i]];
+        double r1 = rate[leg1[i]];
+        double r2 = rate[leg2[i]];
+        cycleRate[i] = r0 * r1 * r2 * feeFactor;
+        // start currency each leg can take, the later legs scaled back to the start
+        double a0 = capacity[leg0[i]];
+        double a1 = capacity[leg1[i]] / r0;
+        double a2 = capacity[leg2[i]] / (r0 * r1);
+        cycleAmount[i] = std::min(a0, std::min(a1, a2));
+    }
+
+    std::vector<ArbitrageOpportunity> found;
+    std::fill(productEdge.begin(), productEdge.end(), 0);
+    double threshold = 1 + minEdge;
+    for (std::size_t i = 0; i < cycles; ++i)
+    {
+        if (!(cycleRate[i] > threshold)) continue; // Also skips cycles with an empty side
+
+        unsigned int legs[3] = {leg0[i], leg1[i], leg2[i]};
+        ArbitrageOpportunity o;
+        o.path = currencies[legFrom[legs[0]]];
+        for (unsigned int l : legs)
+        {
+            o.path += " > " + currencies[legTo[l]];
+            o.products.push_back(products[l / 2]);
+            productEdge[l / 2] = std::max(productEdge[l / 2], cycleRate[i] - 1);
+        }
+        o.rate = cycleRate[i];
+        o.maxAmount = cycleAmount[i];
+        o.profit = o.maxAmount * (o.rate - 1);
+        found.push_back(o);
+    }
+    std::sort(found.begin(), found.end(), [](const ArbitrageOpportunity& a, const ArbitrageOpportunity& b)
+    {
+        return a.profit > b.profit;
+    });
+    return found;
+}
+
+double ArbitrageScanner::getEdge(const std::string& product) const
+{
+    auto it = productIds.find(product);
+    if (it == productIds.end()) return 0;
+    return productEdge[it->second];
+}
+
+MemoryUsage ArbitrageScanner::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.addStrings(products, usage.indexes);
+    usage.addStrings(currencies, usage.indexes);
+    usage.indexes += MemoryUsage::treeBytes(productIds);
+    for (const auto& p : productIds)
+    {
+        usage.strings += MemoryUsage::heapBytes(p.first);
+    }
+    usage.indexes += (legFrom.capacity() + legTo.capacity()) * sizeof(std::size_t);
+    usage.indexes += (leg0.capacity() + leg1.capacity() + leg2.capacity()) * sizeof(unsigned int);
+    usage.indexes += (legRate.capacity() + legCapacity.capacity() + cycleRate.capacity() +
+                      cycleAmount.capacity() + productEdge.capacity()) * sizeof(double);
+    return usage;
+}
+
+std::string ArbitrageScanner::formatOpportunities(const std::vector<ArbitrageOpportunity>& opportunities)
+{
+    std::ostringstream out;
+    for (const ArbitrageOpportunity& o : opportunities)
+    {
+        out << o.path << " rate: " << std::setprecision(8) << o.rate
+            << " up to: " << o.maxAmount
+            << " profit: " << o.profit << "\n";
+    }
+    return out.str();
+}
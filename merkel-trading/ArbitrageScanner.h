@@ -0,0 +1,71 @@
+#pragma once
+#include "OrderBook.h"
+#include <map>
+#include <string>
+#include <vector>
+
+/** One way round a triangle of currencies that pays more than it costs */
+struct ArbitrageOpportunity
+{
+    std::string path;                  // Currencies in trading order, eg "BTC > ETH > USDT > BTC"
+    std::vector<std::string> products; // The three books traded, in order
+    double rate;      // Start currency back per unit put in, after fees
+    double maxAmount; // Most start currency the best levels of the three books can carry
+    double profit;    // maxAmount * (rate - 1), in the start currency
+};
+
+/**
+ * Finds triangular arbitrage between the products of a book.
+ *
+ * The currency graph comes from getKnownProducts: a product BASE/QUOTE
+ * sells BASE for QUOTE at the best bid and buys BASE with QUOTE at the
+ * best ask. Every cycle of three currencies is listed once, in both
+ * directions, when the scanner is built. A scan then only fetches the best
+ * level of each product and evaluates all cycles over flat arrays, so its
+ * cost grows with the number of products and cycles, not with book depth.
+ */
+class ArbitrageScanner
+{
+    public:
+        /** fee is charged on every leg as a fraction of the amount received */
+        ArbitrageScanner(const OrderBook& book, double fee = 0);
+
+        std::size_t cycleCount() const { return leg0.size(); }
+
+        /** evaluate every cycle on the best levels of a frame. Returns the cycles
+         *  with rate above 1 + minEdge, most profitable first */
+        std::vector<ArbitrageOpportunity> scan(const std::string& timestamp, double minEdge = 0);
+
+        /** the best rate - 1 of any cycle through product in the last scan, 0 if none pays */
+        double getEdge(const std::string& product) const;
+
+        /** the currency graph, the cycles and the scan buffers */
+        MemoryUsage memoryUsage() const;
+
+        /** one line per opportunity */
+        static std::string formatOpportunities(const std::vector<ArbitrageOpportunity>& opportunities);
+
+    private:
+        /** legs are numbered 2 * product for selling the base and 2 * product + 1 for buying it */
+        void addCycles();
+
+        const OrderBook& book;
+        double feeFactor; // (1 - fee) ^ 3, the part of a cycle left after fees
+        std::vector<std::string> products;
+        std::map<std::string, std::size_t> productIds;
+        std::vector<std::string> currencies;
+        std::vector<std::size_t> legFrom; // Currency each leg spends
+        std::vector<std::size_t> legTo;   // Currency each leg receives
+
+        // the cycles, one entry per cycle in each array
+        std::vector<unsigned int> leg0;
+        std::vector<unsigned int> leg1;
+        std::vector<unsigned int> leg2;
+
+        // scan buffers, reused every frame
+        std::vector<double> legRate;     // Currency received per unit spent
+        std::vector<double> legCapacity; // Most currency the best level takes in
+        std::vector<double> cycleRate;
+        std::vector<double> cycleAmount;
+        std::vector<double> productEdge;
+};
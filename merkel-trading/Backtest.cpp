@@ -0,0 +1,256 @@
+#include "Backtest.h"
+#include "Channel.h"
+#include "CSVReader.h"
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+/** A frame fetched ahead of matching by the loader stage */
+struct FrameBatch
+{
+    unsigned int frame;
+    std::string timestamp;
+    double mid;
+    std::vector<OrderBookEntry> asks;
+    std::vector<OrderBookEntry> bids;
+};
+
+/** A matched frame waiting for the settle stage */
+struct FrameFills
+{
+    unsigned int frame;
+    std::string timestamp;
+    double mid; // The wallet is marked at it once the fills are settled
+    std::vector<OrderBookEntry> sales;
+};
+
+Backtest::Backtest(const OrderBook& book, StrategyConfig config, Wallet wallet)
+    : book(book),
+      config(config),
+      wallet(wallet),
+      bidId(0),
+      askId(0),
+      report(nullptr),
+      result{config, 0, 0, 0, 0, 0, 0, ""},
+      match(MatchingRules::select(config.allocation, config.tradePrice))
+{
+    if (config.arbitragePause > 0)
+    {
+        arbitrage.reset(new ArbitrageScanner{book});
+    }
+    std::vector<std::string> currs = CSVReader::tokenise(config.product, '/');
+    if (currs.size() == 2)
+    {
+        this->wallet.setReferenceCurrency(currs[1]);
+    }
+
+}
+
+BacktestResult Backtest::run()
+{
+    std::string start = book.getEarliestTime();
+    std::string timestamp = start;
+    double mid = book.getMidPrice(config.product, timestamp);
+    result.startValue = valueAt(mid);
+
+    do
+    {
+        double frameMid = book.getMidPrice(config.product, timestamp);
+        quote(timestamp, frameMid, wallet);
+        std::vector<OrderBookEntry> sales = book.matchAsksToBids(config.product, timestamp, overlay, match);
+        settle(sales);
+        wallet.markPrice(config.product, frameMid);
+        if (report != nullptr) report->wallet(timestamp, wallet.getValuation());
+
+        if (frameMid > 0) mid = frameMid;
+        result.frames++;
+        timestamp = book.getNextTime(timestamp);
+    } while (timestamp != start && !timestamp.empty());
+
+    result.endValue = valueAt(mid);
+    result.realizedPnl = wallet.getValuation().realized;
+    result.maxDrawdown = wallet.getValuation().maxDrawdown;
+    result.wallet = wallet.toString();
+    return result;
+}
+
+BacktestResult Backtest::runPipelined()
+{
+    std::string start = book.getEarliestTime();
+    result.startValue = valueAt(book.getMidPrice(config.product, start));
+
+    Channel<FrameBatch> loaded{2};
+    Channel<FrameFills> matched{2};
+
+    // Stage 1: fetch the orders and mid of each frame ahead of the matcher
+    std::thread loader{[&]()
+    {
+        std::string timestamp = start;
+        unsigned int frame = 0;
+        do
+        {
+            FrameBatch batch;
+            batch.frame = frame++;
+            batch.timestamp = timestamp;
+            batch.mid = book.getMidPrice(config.product, timestamp);
+            batch.asks = book.getOrders(OrderBookType::ask, config.product, timestamp);
+            batch.bids = book.getOrders(OrderBookType::bid, config.product, timestamp);
+            loaded.push(std::move(batch));
+            timestamp = book.getNextTime(timestamp);
+        } while (timestamp != start && !timestamp.empty());
+        loaded.close();
+    }};
+
+    // Wallet after the first k frames were settled, published by stage 3 for the quoting in stage 2
+    std::mutex snapshotMutex;
+    std::condition_variable snapshotReady;
+    std::map<unsigned int, Wallet> snapshots;
+    snapshots[0] = wallet;
+
+    // Stage 3: settle and report fills while the next frame is matched
+    std::thread settler{[&]()
+    {
+        FrameFills fills;
+        while (matched.pop(fills))
+        {
+            settle(fills.sales);
+            wallet.markPrice(config.product, fills.mid);
+            if (report != nullptr) report->wallet(fills.timestamp, wallet.getValuation());
+            std::lock_guard<std::mutex> lock{snapshotMutex};
+            snapshots[fills.frame + 1] = wallet;
+            snapshotReady.notify_all();
+        }
+    }};
+
+    // Stage 2: quote and match on this thread
+    double mid = 0;
+    std::vector<OrderBookEntry> unsettled; // Our fills of the frame before, still with the settler
+    FrameBatch batch;
+    while (loaded.pop(batch))
+    {
+        unsigned int settled = batch.frame > 0 ? batch.frame - 1 : 0;
+        Wallet funds;
+        {
+            std::unique_lock<std::mutex> lock{snapshotMutex};
+            snapshotReady.wait(lock, [&] { return snapshots.count(settled) > 0; });
+            funds = snapshots[settled];
+            snapshots.erase(snapshots.begin(), snapshots.find(settled)); // older ones are not needed again
+        }
+        // hold back what the unsettled fills will pay out, so none of them can be refused
+        unsigned int hold = 0;
+        for (OrderBookEntry owed : unsettled)
+        {
+            owed.orderType = owed.orderType == OrderBookType::bidsale ? OrderBookType::bid : OrderBookType::ask;
+            owed.id = ++hold;
+            funds.reserve(owed);
+        }
+
+        quote(batch.timestamp, batch.mid, funds);
+        std::vector<OrderBookEntry> userAsks = overlay.getOrders(OrderBookType::ask, config.product);
+        std::vector<OrderBookEntry> userBids = overlay.getOrders(OrderBookType::bid, config.product);
+        batch.asks.insert(batch.asks.end(), userAsks.begin(), userAsks.end());
+        batch.bids.insert(batch.bids.end(), userBids.begin(), userBids.end());
+
+        FrameFills fills;
+        fills.frame = batch.frame;
+        fills.timestamp = batch.timestamp;
+        fills.mid = batch.mid;
+        fills.sales = match(batch.asks, batch.bids, config.product, batch.timestamp, overlay);
+        unsettled.clear();
+        for (const OrderBookEntry& sale : fills.sales)
+        {
+            if (sale.username == "simuser" && sale.amount > 0) unsettled.push_back(sale);
+        }
+        matched.push(std::move(fills));
+
+        if (batch.mid > 0) mid = batch.mid;
+        result.frames++;
+    }
+    matched.close();
+    loader.join();
+    settler.join();
+
+    result.endValue = valueAt(mid);
+    result.realizedPnl = wallet.getValuation().realized;
+    result.maxDrawdown = wallet.getValuation().maxDrawdown;
+    result.wallet = wallet.toString();
+    return result;
+}
+
+void Backtest::setReport(ReportWriter* writer)
+{
+    report = writer;
+}
+
+MemoryUsage Backtest::memoryUsage() const
+{
+    MemoryUsage usage = wallet.memoryUsage();
+    usage += overlay.memoryUsage();
+    return usage;
+}
+
+void Backtest::settle(std::vector<OrderBookEntry>& sales)
+{
+    for (OrderBookEntry& sale : sales)
+    {
+        if (sale.username == "simuser" && sale.amount > 0)
+        {
+            if (!wallet.processSale(sale))
+            {
+                result.refusedFills++;
+                continue;
+            }
+            result.fills++;
+            result.volume += sale.amount;
+            if (report != nullptr) report->fill(sale);
+        }
+    }
+}
+
+void Backtest::quote(const std::string& timestamp, double mid, Wallet& funds)
+{
+    // Cancelling is cheap, so requote from scratch every frame
+    overlay.cancel(bidId);
+    overlay.cancel(askId);
+    bidId = 0;
+    askId = 0;
+
+    if (mid <= 0) return;
+
+    // cross-pair prices out of line mean quotes are likely to be picked off
+    if (arbitrage != nullptr &&
+        !arbitrage->scan(timestamp, config.arbitragePause).empty() &&
+        arbitrage->getEdge(config.product) > 0)
+    {
+        result.pausedFrames++;
+        return;
+    }
+
+    OrderBookEntry bid{mid * (1 - config.edge), config.orderSize, timestamp, config.product, OrderBookType::bid, "simuser"};
+    OrderBookEntry ask{mid * (1 + config.edge), config.orderSize, timestamp, config.product, OrderBookType::ask, "simuser"};
+
+    std::vector<std::string> currs = CSVReader::tokenise(config.product, '/');
+    if (currs.size() != 2) return;
+    // Each quote needs what it may spend free in funds: the balance less its reservations.
+    // run() passes the live wallet, which reserves nothing as last frame's quotes are gone.
+    // runPipelined() passes the wallet settled up to frame N-2 with the payouts of the
+    // unsettled frame N-1 fills reserved, so every fill of this frame can be paid for
+    if (funds.getAvailable(currs[1]) >= bid.amount * bid.price)
+    {
+        bidId = overlay.add(bid);
+        if (bidId != 0) result.ordersPlaced++;
+    }
+    if (funds.getAvailable(currs[0]) >= ask.amount)
+    {
+        askId = overlay.add(ask);
+        if (askId != 0) result.ordersPlaced++;
+    }
+}
+
+double Backtest::valueAt(double mid)
+{
+    std::vector<std::string> currs = CSVReader::tokenise(config.product, '/');
+    if (currs.size() != 2) return 0;
+    return wallet.getBalance(currs[0]) * mid + wallet.getBalance(currs[1]);
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "ArbitrageScanner.h"
+#include "MatchingEngine.h"
+#include "OrderBook.h"
+#include "ReportWriter.h"
+#include "RestingOrders.h"
+#include "Wallet.h"
+#include <memory>
+#include <string>
+
+/** Parameters of the built-in quoting strategy: every frame it quotes
+ *  one bid and one ask around the mid price of a product */
+struct StrategyConfig
+{
+    std::string name;
+    std::string product;
+    double edge;      // distance of the quotes from the mid, as a fraction of the mid. Negative crosses the spread
+    double orderSize; // amount of each quote
+    AllocationRule allocation = AllocationRule::fifo;     // how the venue shares a fill among a price level
+    TradePriceRule tradePrice = TradePriceRule::askPrice; // the price fills happen at
+    double arbitragePause = 0; // skip quoting while the product is on a triangle paying more than this, 0 never skips
+};
+
+/** What came out of one backtest run */
+struct BacktestResult
+{
+    StrategyConfig config;
+    unsigned int frames;
+    unsigned int ordersPlaced;
+    unsigned int fills;  // only the ones the wallet could pay for
+    double volume;       // amount traded in the product's base currency
+    double startValue;   // wallet valued in the quote currency at the first mid
+    double endValue;     // wallet valued in the quote currency at the last mid
+    std::string wallet;  // final balances
+    unsigned int pausedFrames = 0; // frames without quotes because of arbitrage
+    unsigned int refusedFills = 0; // fills the wallet could not pay for, left out of fills and volume
+    double realizedPnl = 0;  // in the quote currency, against the average cost of what was sold
+    double maxDrawdown = 0;  // largest fall of the wallet's value from its peak, marked at every frame's mid
+};
+
+/**
+ * Replays every frame of a shared, read-only order book with one strategy.
+ * The run keeps its own wallet and its own resting orders, so any number
+ * of runs can use the same book at once.
+ */
+class Backtest
+{
+    public:
+        Backtest(const OrderBook& book, StrategyConfig config, Wallet wallet);
+
+        /** replay from the earliest frame until the book wraps around */
+        BacktestResult run();
+
+        /** same replay as a three stage pipeline: a loader thread fetches frame N+1
+         *  while this thread quotes and matches frame N and a settle thread applies
+         *  and reports the fills of frame N-1. Quotes for frame N are sized against
+         *  the wallet as settled up to frame N-2, less what the fills of frame N-1 will
+         *  pay out, so results are repeatable but can differ from run() which settles
+         *  before every quote */
+        BacktestResult runPipelined();
+
+        /** write every fill of this run, and the wallet's valuation after each frame, to report.
+         *  nullptr for none */
+        void setReport(ReportWriter* report);
+
+        /** this run's wallet and resting orders */
+        MemoryUsage memoryUsage() const;
+
+    private:
+        /** cancel last frame's quotes and place new ones around the mid, each if funds has
+         *  what it may spend available */
+        void quote(const std::string& timestamp, double mid, Wallet& funds);
+        /** apply a frame's fills to the wallet and the report, counting the ones it refuses */
+        void settle(std::vector<OrderBookEntry>& sales);
+        /** wallet value in the quote currency of the product at this mid */
+        double valueAt(double mid);
+
+        const OrderBook& book;
+        StrategyConfig config;
+        Wallet wallet;
+        RestingOrders overlay; // this run's orders, the shared book never sees them
+        unsigned int bidId;
+        unsigned int askId;
+        ReportWriter* report;
+        BacktestResult result;
+        MatchFunction match; // picked once from the config's matching rules
+        std::unique_ptr<ArbitrageScanner> arbitrage; // only when the config pauses on arbitrage
+};
@@ -0,0 +1,164 @@
+#include "BookDelta.h"
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    /** a change as stored in the stream */
+    struct DeltaRecord
+    {
+        double price;
+        double amount;
+        std::int32_t orderCount;
+        std::uint8_t change;
+        std::uint8_t side; // 0 bid, 1 ask
+        std::uint8_t padding[2];
+    };
+    static_assert(sizeof(DeltaRecord) == 24, "DeltaRecord is a fixed 24 byte record");
+
+    void writeCount(std::ostream& out, std::uint32_t n)
+    {
+        out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    }
+
+    void writeString(std::ostream& out, const std::string& s)
+    {
+        writeCount(out, static_cast<std::uint32_t>(s.size()));
+        out.write(s.data(), s.size());
+    }
+
+    void readBytes(std::istream& in, char* data, std::size_t size)
+    {
+        if (!in.read(data, size))
+        {
+            throw std::runtime_error("BookDelta: stream ends in the middle of a frame");
+        }
+    }
+
+    std::uint32_t readCount(std::istream& in)
+    {
+        std::uint32_t n;
+        readBytes(in, reinterpret_cast<char*>(&n), sizeof(n));
+        return n;
+    }
+
+    std::string readString(std::istream& in)
+    {
+        std::string s(readCount(in), '\0');
+        readBytes(in, &s[0], s.size());
+        return s;
+    }
+}
+
+void BookDelta::diff(OrderBookType side,
+                     const std::vector<PriceLevel>& before,
+                     const std::vector<PriceLevel>& after,
+                     std::vector<LevelDelta>& out)
+{
+    std::size_t b = 0, a = 0;
+    while (b < before.size() || a < after.size())
+    {
+        if (a == after.size() || (b < before.size() && better(side, before[b].price, after[a].price)))
+        {
+            out.push_back(LevelDelta{LevelChange::remove, side, before[b].price, 0, 0});
+            ++b;
+        }
+        else if (b == before.size() || better(side, after[a].price, before[b].price))
+        {
+            out.push_back(LevelDelta{LevelChange::add, side, after[a].price, after[a].amount, after[a].orderCount});
+            ++a;
+        }
+        else
+        {
+            if (before[b].amount != after[a].amount || before[b].orderCount != after[a].orderCount)
+            {
+                out.push_back(LevelDelta{LevelChange::modify, side, after[a].price, after[a].amount, after[a].orderCount});
+            }
+            ++a;
+            ++b;
+        }
+    }
+}
+
+FrameDelta BookDelta::between(const OrderBook& book, const std::string& from, const std::string& to)
+{
+    const unsigned int all = std::numeric_limits<unsigned int>::max();
+    FrameDelta delta{from, to, {}};
+    for (const std::string& product : book.getKnownProducts())
+    {
+        ProductDelta p{product, {}};
+        for (OrderBookType side : {OrderBookType::bid, OrderBookType::ask})
+        {
+            diff(side, book.getDepth(side, product, from, all), book.getDepth(side, product, to, all), p.changes);
+        }
+        if (!p.changes.empty()) delta.products.push_back(std::move(p));
+    }
+    return delta;
+}
+
+void BookDelta::apply(std::vector<PriceLevel>& levels, OrderBookType side, const std::vector<LevelDelta>& changes)
+{
+    // the changes of a side come best first too, so this is another merge
+    std::vector<PriceLevel> merged;
+    merged.reserve(levels.size() + changes.size());
+    std::size_t l = 0;
+    for (const LevelDelta& c : changes)
+    {
+        if (c.side != side) continue;
+        while (l < levels.size() && better(side, levels[l].price, c.price))
+        {
+            merged.push_back(levels[l++]);
+        }
+        if (l < levels.size() && levels[l].price == c.price) ++l; // Replaced or removed
+        if (c.change != LevelChange::remove)
+        {
+            merged.push_back(PriceLevel{c.price, c.amount, c.orderCount});
+        }
+    }
+    merged.insert(merged.end(), levels.begin() + l, levels.end());
+    levels.swap(merged);
+}
+
+void BookDelta::write(std::ostream& out, const FrameDelta& delta)
+{
+    writeString(out, delta.from);
+    writeString(out, delta.to);
+    writeCount(out, static_cast<std::uint32_t>(delta.products.size()));
+    for (const ProductDelta& p : delta.products)
+    {
+        writeString(out, p.product);
+        writeCount(out, static_cast<std::uint32_t>(p.changes.size()));
+        for (const LevelDelta& c : p.changes)
+        {
+            DeltaRecord r{c.price, c.amount, c.orderCount, static_cast<std::uint8_t>(c.change),
+                          static_cast<std::uint8_t>(c.side == OrderBookType::bid ? 0 : 1), {0, 0}};
+            out.write(reinterpret_cast<const char*>(&r), sizeof(r));
+        }
+    }
+}
+
+bool BookDelta::read(std::istream& in, FrameDelta& delta)
+{
+    if (in.peek() == std::char_traits<char>::eof()) return false;
+    delta.from = readString(in);
+    delta.to = readString(in);
+    delta.products.resize(readCount(in));
+    for (ProductDelta& p : delta.products)
+    {
+        p.product = readString(in);
+        p.changes.resize(readCount(in));
+        for (LevelDelta& c : p.changes)
+        {
+            DeltaRecord r;
+            readBytes(in, reinterpret_cast<char*>(&r), sizeof(r));
+            if (r.change < 1 || r.change > 3 || r.side > 1)
+            {
+                throw std::runtime_error("BookDelta: bad change record");
+            }
+            c = LevelDelta{static_cast<LevelChange>(r.change), r.side == 0 ? OrderBookType::bid : OrderBookType::ask,
+                           r.price, r.amount, r.orderCount};
+        }
+    }
+    return true;
+}
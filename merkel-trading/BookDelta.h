@@ -0,0 +1,76 @@
+#pragma once
+#include "OrderBook.h"
+#include "OrderBookEntry.h"
+#include "PriceLevel.h"
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum class LevelChange : std::uint8_t
+{
+    add = 1,    // a price that had no level
+    modify = 2, // new amount or order count at a price
+    remove = 3  // the level is gone, amount and orderCount are 0
+};
+
+/** one changed price level */
+struct LevelDelta
+{
+    LevelChange change;
+    OrderBookType side;
+    double price;
+    double amount;  // The level's new total
+    int orderCount;
+};
+
+struct ProductDelta
+{
+    std::string product;
+    std::vector<LevelDelta> changes; // Bids best first, then asks best first
+};
+
+/** what changed in the book from one frame to the next */
+struct FrameDelta
+{
+    std::string from;
+    std::string to;
+    std::vector<ProductDelta> products; // Only products with a change
+};
+
+/**
+ * Level deltas between frames. Both frames' levels come best first, so the
+ * changes fall out of one merge pass over the two arrays per side instead
+ * of a comparison of every order.
+ *
+ * The stream form is a sequence of frames in host byte order:
+ * from, to, product count, then per product its name, change count and
+ * one 24 byte record per change. Strings are a 32 bit length and the bytes.
+ */
+class BookDelta
+{
+    public:
+        /** append the changes from before to after of one side, both best first */
+        static void diff(OrderBookType side,
+                         const std::vector<PriceLevel>& before,
+                         const std::vector<PriceLevel>& after,
+                         std::vector<LevelDelta>& out);
+
+        /** every level change of every product from frame from to frame to, resting orders included */
+        static FrameDelta between(const OrderBook& book, const std::string& from, const std::string& to);
+
+        /** bring the levels of one side up to date with changes, levels stay best first */
+        static void apply(std::vector<PriceLevel>& levels, OrderBookType side, const std::vector<LevelDelta>& changes);
+
+        static void write(std::ostream& out, const FrameDelta& delta);
+        /** read the next frame, false at the end of the stream. Throws std::runtime_error if it is cut short */
+        static bool read(std::istream& in, FrameDelta& delta);
+
+    private:
+        /** true if a is a better price than b on side */
+        static bool better(OrderBookType side, double a, double b)
+        {
+            return side == OrderBookType::bid ? a > b : a < b;
+        }
+};
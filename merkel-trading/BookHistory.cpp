@@ -0,0 +1,131 @@
+#include "BookHistory.h"
+#include <algorithm>
+
+BookHistory::BookHistory(const OrderBook& book, unsigned int checkpointInterval)
+    : book(book), interval(checkpointInterval == 0 ? 1 : checkpointInterval)
+{
+
+}
+
+void BookHistory::record(const std::string& timestamp)
+{
+    if (!times.empty() && timestamp <= times.back())
+    {
+        times.clear();
+        checkpoints.clear();
+        deltas.clear();
+        last.clear();
+    }
+
+    std::vector<OrderBookEntry> now = book.getRestingOrders(); // By id
+    if (times.size() % interval == 0)
+    {
+        checkpoints.push_back(now);
+        deltas.push_back(Delta{});
+    }
+    else
+    {
+        deltas.push_back(diff(last, now));
+    }
+    times.push_back(timestamp);
+    last.swap(now);
+}
+
+long BookHistory::frameAt(const std::string& timestamp) const
+{
+    return static_cast<long>(std::upper_bound(times.begin(), times.end(), timestamp) - times.begin()) - 1;
+}
+
+std::vector<OrderBookEntry> BookHistory::restore(std::size_t frame) const
+{
+    std::size_t checkpoint = frame / interval;
+    std::vector<OrderBookEntry> orders = checkpoints[checkpoint];
+    for (std::size_t f = checkpoint * interval + 1; f <= frame; ++f)
+    {
+        apply(orders, deltas[f]);
+    }
+    return orders;
+}
+
+std::vector<OrderBookEntry> BookHistory::getRestingAt(const std::string& timestamp) const
+{
+    long frame = frameAt(timestamp);
+    if (frame < 0) return {};
+    return restore(frame);
+}
+
+std::unique_ptr<const BookSnapshot> BookHistory::bookAt(const std::string& timestamp) const
+{
+    long frame = frameAt(timestamp);
+    if (frame < 0) return nullptr;
+    return book.makeSnapshot(times[frame], frame, restore(frame));
+}
+
+BookHistory::Delta BookHistory::diff(const std::vector<OrderBookEntry>& before, const std::vector<OrderBookEntry>& after)
+{
+    // both lists are by id, walk them together
+    Delta delta;
+    std::size_t b = 0, a = 0;
+    while (b < before.size() || a < after.size())
+    {
+        if (a == after.size() || (b < before.size() && before[b].id < after[a].id))
+        {
+            delta.removed.push_back(before[b++].id);
+        }
+        else if (b == before.size() || after[a].id < before[b].id)
+        {
+            delta.upserts.push_back(after[a++]);
+        }
+        else
+        {
+            if (before[b].price != after[a].price || before[b].amount != after[a].amount)
+            {
+                delta.upserts.push_back(after[a]);
+            }
+            ++a;
+            ++b;
+        }
+    }
+    return delta;
+}
+
+void BookHistory::apply(std::vector<OrderBookEntry>& orders, const Delta& delta)
+{
+    std::vector<OrderBookEntry> merged;
+    merged.reserve(orders.size() + delta.upserts.size());
+    std::size_t o = 0, u = 0, r = 0;
+    while (o < orders.size() || u < delta.upserts.size())
+    {
+        if (u == delta.upserts.size() || (o < orders.size() && orders[o].id < delta.upserts[u].id))
+        {
+            while (r < delta.removed.size() && delta.removed[r] < orders[o].id) ++r;
+            if (r == delta.removed.size() || delta.removed[r] != orders[o].id) merged.push_back(orders[o]);
+            ++o;
+        }
+        else
+        {
+            if (o < orders.size() && orders[o].id == delta.upserts[u].id) ++o; // Changed, the upsert replaces it
+            merged.push_back(delta.upserts[u++]);
+        }
+    }
+    orders.swap(merged);
+}
+
+MemoryUsage BookHistory::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.addStrings(times, usage.tape);
+    usage.addOrders(last, usage.tape);
+    usage.tape += checkpoints.capacity() * sizeof(checkpoints[0]);
+    for (const std::vector<OrderBookEntry>& c : checkpoints)
+    {
+        usage.addOrders(c, usage.tape);
+    }
+    usage.tape += deltas.capacity() * sizeof(Delta);
+    for (const Delta& d : deltas)
+    {
+        usage.addOrders(d.upserts, usage.tape);
+        usage.tape += d.removed.capacity() * sizeof(unsigned int);
+    }
+    return usage;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "BookSnapshot.h"
+#include "OrderBook.h"
+#include "OrderBookEntry.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Remembers how the book looked at the start of every frame, so any past
+ * frame can be looked at again without replaying from the earliest one.
+ *
+ * The dataset orders of a frame never change and are always at hand in the
+ * book's shards, so only the resting user orders are kept: a full copy
+ * every checkpointInterval frames and, for the frames in between, what
+ * changed since the frame before. bookAt restores the checkpoint at or
+ * before a frame and applies at most checkpointInterval - 1 deltas.
+ */
+class BookHistory
+{
+    public:
+        BookHistory(const OrderBook& book, unsigned int checkpointInterval = 16);
+
+        /** remember the book's resting orders as the state at the start of timestamp.
+         *  A timestamp not after the last one recorded means the replay started over,
+         *  the history is cleared first */
+        void record(const std::string& timestamp);
+
+        /** the book as it was at the start of the latest recorded frame at or before
+         *  timestamp, nullptr if timestamp is before the first one */
+        std::unique_ptr<const BookSnapshot> bookAt(const std::string& timestamp) const;
+
+        /** the resting orders at the start of that frame, by id, empty if there is none */
+        std::vector<OrderBookEntry> getRestingAt(const std::string& timestamp) const;
+
+        std::size_t frameCount() const { return times.size(); }
+        std::size_t checkpointCount() const { return checkpoints.size(); }
+        /** size of the checkpoints and deltas, all of it counted as tape with the strings apart */
+        MemoryUsage memoryUsage() const;
+
+    private:
+        /** what changed in the resting orders from one frame to the next */
+        struct Delta
+        {
+            std::vector<OrderBookEntry> upserts; // New orders and orders with a new price or amount
+            std::vector<unsigned int> removed;   // Filled or cancelled, by id
+        };
+
+        /** frame index of the latest frame at or before timestamp, -1 if none */
+        long frameAt(const std::string& timestamp) const;
+        /** the resting orders of a frame, rebuilt from its checkpoint */
+        std::vector<OrderBookEntry> restore(std::size_t frame) const;
+        static Delta diff(const std::vector<OrderBookEntry>& before, const std::vector<OrderBookEntry>& after);
+        static void apply(std::vector<OrderBookEntry>& orders, const Delta& delta);
+
+        const OrderBook& book;
+        unsigned int interval;
+        std::vector<std::string> times;                       // One per recorded frame, ascending
+        std::vector<std::vector<OrderBookEntry>> checkpoints; // Frames 0, interval, 2 * interval..., by id
+        std::vector<Delta> deltas;                            // One per frame, empty for checkpoint frames
+        std::vector<OrderBookEntry> last;                     // Resting orders of the latest frame, by id
+};
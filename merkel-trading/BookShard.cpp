@@ -0,0 +1,217 @@
+#include "BookShard.h"
+#include "CSVReader.h"
+#include "OrderArchive.h"
+#include <algorithm>
+
+BookShard::BookShard(std::vector<OrderBookEntry> entries) : orders(std::move(entries))
+{
+    // group every frame by product and side, keeping the file order inside each group
+    std::stable_sort(orders.begin(), orders.end(), [](const OrderBookEntry& a, const OrderBookEntry& b)
+    {
+        if (a.timestamp != b.timestamp) return a.timestamp < b.timestamp;
+        if (a.product != b.product) return a.product < b.product;
+        return a.orderType < b.orderType;
+    });
+
+    priceColumn.reserve(orders.size());
+    amountColumn.reserve(orders.size());
+    for (OrderBookEntry& e : orders)
+    {
+        priceColumn.push_back(e.price);
+        amountColumn.push_back(e.amount);
+    }
+
+    for (OrderBookEntry& e : orders)
+    {
+        productIds[e.product] = 0;
+    }
+    for (auto& p : productIds)
+    {
+        p.second = productNames.size();
+        productNames.push_back(p.first);
+    }
+
+    // orders are sorted by timestamp so every frame is a run of equal timestamps
+    std::size_t begin = 0;
+    while (begin < orders.size())
+    {
+        std::size_t end = begin;
+        while (end < orders.size() && orders[end].timestamp == orders[begin].timestamp)
+        {
+            ++end;
+        }
+        frameTimes.push_back(orders[begin].timestamp);
+        frameRanges.push_back(Range{static_cast<unsigned int>(begin), static_cast<unsigned int>(end)});
+        indexFrame(begin, end);
+        begin = end;
+    }
+    buildPrefixSums();
+}
+
+std::shared_ptr<const BookShard> BookShard::load(const std::string& filename)
+{
+    if (OrderArchive::isArchive(filename))
+    {
+        return std::make_shared<const BookShard>(OrderArchive::read(filename)); // Compressed columnar archive
+    }
+    return std::make_shared<const BookShard>(CSVReader::readCSV(filename));
+}
+
+int BookShard::frameIndex(const std::string& timestamp) const
+{
+    auto it = std::lower_bound(frameTimes.begin(), frameTimes.end(), timestamp);
+    if (it == frameTimes.end() || *it != timestamp)
+    {
+        return -1;
+    }
+    return static_cast<int>(it - frameTimes.begin());
+}
+
+int BookShard::productIndex(const std::string& product) const
+{
+    auto it = productIds.find(product);
+    if (it == productIds.end())
+    {
+        return -1;
+    }
+    return static_cast<int>(it->second);
+}
+
+BookShard::Slice BookShard::getSlice(std::size_t frame, std::size_t product, OrderBookType type) const
+{
+    if (type != OrderBookType::bid && type != OrderBookType::ask)
+    {
+        return Slice{nullptr, nullptr, nullptr, 0};
+    }
+    Range range = orderRanges[slot(frame, product, type)];
+    return Slice{orders.data() + range.begin,
+                 priceColumn.data() + range.begin,
+                 amountColumn.data() + range.begin,
+                 range.end - range.begin};
+}
+
+BookShard::LevelSpan BookShard::getLevels(std::size_t frame, std::size_t product, OrderBookType type) const
+{
+    if (type != OrderBookType::bid && type != OrderBookType::ask)
+    {
+        return LevelSpan{nullptr, nullptr};
+    }
+    Range range = levelRanges[slot(frame, product, type)];
+    return LevelSpan{levels.data() + range.begin, levels.data() + range.end};
+}
+
+BookShard::Slice BookShard::getFrame(std::size_t frame) const
+{
+    Range range = frameRanges[frame];
+    return Slice{orders.data() + range.begin,
+                 priceColumn.data() + range.begin,
+                 amountColumn.data() + range.begin,
+                 range.end - range.begin};
+}
+
+RangeSummary BookShard::sumFrames(std::size_t product, OrderBookType type, std::size_t first, std::size_t last) const
+{
+    if (first >= last || (type != OrderBookType::bid && type != OrderBookType::ask))
+    {
+        return RangeSummary{0, 0, 0};
+    }
+    const RangeSummary* running = &prefixSums[slot(0, product, type) * (frameTimes.size() + 1)];
+    return RangeSummary{running[last].volume - running[first].volume,
+                        running[last].notional - running[first].notional,
+                        running[last].count - running[first].count};
+}
+
+std::size_t BookShard::memoryBytes() const
+{
+    return sizeof(BookShard) + memoryUsage().total();
+}
+
+MemoryUsage BookShard::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.addOrders(orders, usage.entries);
+    usage.entries += (priceColumn.capacity() + amountColumn.capacity()) * sizeof(double);
+    usage.addStrings(frameTimes, usage.indexes);
+    usage.addStrings(productNames, usage.indexes);
+    usage.indexes += MemoryUsage::treeBytes(productIds);
+    for (const auto& p : productIds)
+    {
+        usage.strings += MemoryUsage::heapBytes(p.first);
+    }
+    usage.indexes += (frameRanges.capacity() + levelRanges.capacity() + orderRanges.capacity()) * sizeof(Range);
+    usage.indexes += levels.capacity() * sizeof(PriceLevel);
+    usage.indexes += prefixSums.capacity() * sizeof(RangeSummary);
+    return usage;
+}
+
+void BookShard::indexFrame(std::size_t begin, std::size_t end)
+{
+    std::size_t frame = frameTimes.size() - 1;
+    levelRanges.resize((frame + 1) * productNames.size() * 2);
+    orderRanges.resize((frame + 1) * productNames.size() * 2, Range{0, 0});
+
+    // the orders of one product and side are already next to each other
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        OrderBookEntry& e = orders[i];
+        if (e.orderType != OrderBookType::bid && e.orderType != OrderBookType::ask) continue;
+        Range& range = orderRanges[slot(frame, productIds[e.product], e.orderType)];
+        if (range.begin == range.end) range.begin = i;
+        range.end = i + 1;
+    }
+
+    // aggregate the orders of every product and side by price. Market, IOC and FOK
+    // orders only take liquidity, so they are not part of the depth
+    std::vector<std::map<double, PriceLevel>> sideLevels(productNames.size() * 2);
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        OrderBookEntry& e = orders[i];
+        if (e.orderType != OrderBookType::bid && e.orderType != OrderBookType::ask) continue;
+        if (e.execution != OrderExecution::limit) continue;
+        PriceLevel& level = sideLevels[slot(0, productIds[e.product], e.orderType)][e.price];
+        level.price = e.price;
+        level.amount += e.amount;
+        level.orderCount++;
+    }
+
+    for (std::size_t p = 0; p < productNames.size(); ++p)
+    {
+        Range& bids = levelRanges[slot(frame, p, OrderBookType::bid)];
+        std::map<double, PriceLevel>& bidLevels = sideLevels[slot(0, p, OrderBookType::bid)];
+        bids.begin = levels.size();
+        for (auto it = bidLevels.rbegin(); it != bidLevels.rend(); ++it) levels.push_back(it->second); // highest bid first
+        bids.end = levels.size();
+
+        Range& asks = levelRanges[slot(frame, p, OrderBookType::ask)];
+        std::map<double, PriceLevel>& askLevels = sideLevels[slot(0, p, OrderBookType::ask)];
+        asks.begin = levels.size();
+        for (auto it = askLevels.begin(); it != askLevels.end(); ++it) levels.push_back(it->second); // lowest ask first
+        asks.end = levels.size();
+    }
+}
+
+void BookShard::buildPrefixSums()
+{
+    std::size_t frames = frameTimes.size();
+    prefixSums.assign(productNames.size() * 2 * (frames + 1), RangeSummary{0, 0, 0});
+    for (std::size_t p = 0; p < productNames.size(); ++p)
+    {
+        for (OrderBookType type : {OrderBookType::bid, OrderBookType::ask})
+        {
+            RangeSummary* running = &prefixSums[slot(0, p, type) * (frames + 1)];
+            for (std::size_t f = 0; f < frames; ++f)
+            {
+                Slice s = getSlice(f, p, type);
+                PriceSummary frame = PriceStats::compute(s.prices, s.amounts, s.count);
+                running[f + 1].volume = running[f].volume + frame.amount;
+                running[f + 1].notional = running[f].notional + frame.notional;
+                running[f + 1].count = running[f].count + frame.count;
+            }
+        }
+    }
+}
+
+std::size_t BookShard::slot(std::size_t frame, std::size_t product, OrderBookType type) const
+{
+    return (frame * productNames.size() + product) * 2 + (type == OrderBookType::bid ? 0 : 1);
+}
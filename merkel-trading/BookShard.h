@@ -0,0 +1,88 @@
+#pragma once
+#include "MemoryUsage.h"
+#include "OrderBookEntry.h"
+#include "PriceLevel.h"
+#include "PriceStats.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * One time slice of the order book data, sorted and indexed once when it is
+ * loaded: frame times, a product dictionary, price/amount columns, per
+ * frame/product/side order runs and aggregated price levels, and prefix sums
+ * along the frames. A book read from a single file is one shard.
+ * A shard is never changed after construction, so threads can share it.
+ */
+class BookShard
+{
+    public:
+        /** contiguous orders of one frame/product/side with their price and amount columns */
+        struct Slice
+        {
+            const OrderBookEntry* orders;
+            const double* prices;
+            const double* amounts;
+            std::size_t count;
+        };
+
+        /** aggregated levels of one frame/product/side, best price first */
+        struct LevelSpan
+        {
+            const PriceLevel* begin;
+            const PriceLevel* end;
+        };
+
+        /** sort the orders by frame, product and side and index them */
+        BookShard(std::vector<OrderBookEntry> orders);
+
+        /** read a csv file or an OrderArchive (.mka) file into a shard */
+        static std::shared_ptr<const BookShard> load(const std::string& filename);
+
+        const std::vector<std::string>& getFrameTimes() const { return frameTimes; }
+        const std::vector<std::string>& getProducts() const { return productNames; }
+        std::size_t size() const { return orders.size(); }
+
+        /** position of timestamp in getFrameTimes or -1 */
+        int frameIndex(const std::string& timestamp) const;
+        /** position of product in getProducts or -1 */
+        int productIndex(const std::string& product) const;
+
+        /** bids or asks of one product in one frame */
+        Slice getSlice(std::size_t frame, std::size_t product, OrderBookType type) const;
+        LevelSpan getLevels(std::size_t frame, std::size_t product, OrderBookType type) const;
+        /** every order of one frame, whatever its product and type */
+        Slice getFrame(std::size_t frame) const;
+        /** totals of one product/side over frames [first, last) */
+        RangeSummary sumFrames(std::size_t product, OrderBookType type, std::size_t first, std::size_t last) const;
+
+        /** approximate bytes held by the shard, including string heap storage */
+        std::size_t memoryBytes() const;
+        /** the same split by category */
+        MemoryUsage memoryUsage() const;
+
+    private:
+        /** where the orders or levels of one frame/product/side sit in their vector */
+        struct Range
+        {
+            unsigned int begin;
+            unsigned int end;
+        };
+
+        void indexFrame(std::size_t begin, std::size_t end);
+        void buildPrefixSums();
+        std::size_t slot(std::size_t frame, std::size_t product, OrderBookType type) const;
+
+        std::vector<OrderBookEntry> orders;
+        std::vector<double> priceColumn; // Prices of orders, same positions as orders
+        std::vector<double> amountColumn; // Amounts of orders, same positions as orders
+        std::vector<std::string> frameTimes; // Every distinct timestamp, in order
+        std::vector<Range> frameRanges; // Orders of every frame
+        std::vector<std::string> productNames;
+        std::map<std::string, std::size_t> productIds;
+        std::vector<PriceLevel> levels; // Aggregated levels of every frame, best price first
+        std::vector<Range> levelRanges; // Indexed by slot
+        std::vector<Range> orderRanges; // Orders of every frame/product/side, indexed by slot
+        std::vector<RangeSummary> prefixSums; // Totals of frames [0, f) at (product * 2 + side) * (frames + 1) + f
+};
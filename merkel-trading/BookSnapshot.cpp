@@ -0,0 +1,122 @@
+#include "BookSnapshot.h"
+#include <algorithm>
+
+BookSnapshot::BookSnapshot(std::uint64_t version,
+                           std::string timestamp,
+                           std::vector<std::string> products,
+                           std::shared_ptr<const BookShard> shard,
+                           int frame,
+                           std::map<std::string, RestingSide> resting)
+    : version(version),
+      timestamp(std::move(timestamp)),
+      products(std::move(products)),
+      shard(std::move(shard)),
+      frame(frame),
+      resting(std::move(resting))
+{
+
+}
+
+std::string BookSnapshot::sideKey(OrderBookType type, const std::string& product)
+{
+    return product + (type == OrderBookType::bid ? "|bid" : "|ask");
+}
+
+const BookSnapshot::RestingSide* BookSnapshot::restingSide(OrderBookType type, const std::string& product) const
+{
+    auto it = resting.find(sideKey(type, product));
+    return it == resting.end() ? nullptr : &it->second;
+}
+
+std::vector<OrderBookEntry> BookSnapshot::getOrders(OrderBookType type, const std::string& product) const
+{
+    std::vector<OrderBookEntry> orders;
+    int pid = shard ? shard->productIndex(product) : -1;
+    if (frame >= 0 && pid >= 0)
+    {
+        BookShard::Slice slice = shard->getSlice(frame, pid, type);
+        orders.assign(slice.orders, slice.orders + slice.count);
+    }
+    if (const RestingSide* side = restingSide(type, product))
+    {
+        orders.insert(orders.end(), side->orders.begin(), side->orders.end());
+    }
+    return orders;
+}
+
+std::vector<PriceLevel> BookSnapshot::getDepth(OrderBookType type, const std::string& product, unsigned int n) const
+{
+    const PriceLevel* it = nullptr;
+    const PriceLevel* end = nullptr;
+    int pid = shard ? shard->productIndex(product) : -1;
+    if (frame >= 0 && pid >= 0)
+    {
+        BookShard::LevelSpan span = shard->getLevels(frame, pid, type);
+        it = span.begin;
+        end = span.end;
+    }
+    const RestingSide* side = restingSide(type, product);
+    const PriceLevel* rit = side ? side->levels.data() : nullptr;
+    const PriceLevel* rend = side ? side->levels.data() + side->levels.size() : nullptr;
+
+    // both lists are best first, merge them, adding up levels on the same price
+    auto better = [type](double a, double b) { return type == OrderBookType::bid ? a > b : a < b; };
+    std::vector<PriceLevel> depth;
+    while (depth.size() < n && (it != end || rit != rend))
+    {
+        if (rit == rend || (it != end && better(it->price, rit->price)))
+        {
+            depth.push_back(*it++);
+        }
+        else if (it == end || better(rit->price, it->price))
+        {
+            depth.push_back(*rit++);
+        }
+        else
+        {
+            depth.push_back(PriceLevel{it->price, it->amount + rit->amount, it->orderCount + rit->orderCount});
+            ++it;
+            ++rit;
+        }
+    }
+    return depth;
+}
+
+PriceSummary BookSnapshot::getPriceSummary(OrderBookType type, const std::string& product) const
+{
+    PriceSummary summary{0, 0, 0, 0, 0, 0};
+    int pid = shard ? shard->productIndex(product) : -1;
+    if (frame >= 0 && pid >= 0 && (type == OrderBookType::bid || type == OrderBookType::ask))
+    {
+        BookShard::Slice slice = shard->getSlice(frame, pid, type);
+        summary = PriceStats::compute(slice.prices, slice.amounts, slice.count);
+    }
+    const RestingSide* side = restingSide(type, product);
+    if (side != nullptr && !side->orders.empty())
+    {
+        std::vector<double> prices, amounts;
+        for (const OrderBookEntry& e : side->orders)
+        {
+            prices.push_back(e.price);
+            amounts.push_back(e.amount);
+        }
+        summary = PriceStats::merge(summary, PriceStats::compute(prices.data(), amounts.data(), prices.size()));
+    }
+    return summary;
+}
+
+double BookSnapshot::getSpread(const std::string& product) const
+{
+    std::vector<PriceLevel> bid = getDepth(OrderBookType::bid, product, 1);
+    std::vector<PriceLevel> ask = getDepth(OrderBookType::ask, product, 1);
+    if (bid.empty() || ask.empty()) return 0.0;
+    return ask[0].price - bid[0].price;
+}
+
+double BookSnapshot::getMidPrice(const std::string& product) const
+{
+    std::vector<PriceLevel> bid = getDepth(OrderBookType::bid, product, 1);
+    std::vector<PriceLevel> ask = getDepth(OrderBookType::ask, product, 1);
+    if (bid.empty() || ask.empty()) return 0.0;
+    return (bid[0].price + ask[0].price) / 2;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "BookShard.h"
+#include "OrderBookEntry.h"
+#include "PriceLevel.h"
+#include "PriceStats.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * A frozen view of the order book in one frame: the frame's dataset orders,
+ * through a pinned shard, plus a copy of the resting user orders as they
+ * were when the snapshot was taken. Nothing in it changes after
+ * construction, so any number of threads can query it while the book
+ * itself carries on matching. Built by OrderBook::makeSnapshot.
+ */
+class BookSnapshot
+{
+    public:
+        /** the resting orders of one side of one product, best first */
+        struct RestingSide
+        {
+            std::vector<OrderBookEntry> orders;
+            std::vector<PriceLevel> levels;
+        };
+
+        BookSnapshot(std::uint64_t version,
+                     std::string timestamp,
+                     std::vector<std::string> products,
+                     std::shared_ptr<const BookShard> shard,
+                     int frame,
+                     std::map<std::string, RestingSide> resting);
+
+        std::uint64_t getVersion() const { return version; }
+        const std::string& getTimestamp() const { return timestamp; }
+        const std::vector<std::string>& getKnownProducts() const { return products; }
+
+        /** same results as the OrderBook queries of the same name at the snapshot's frame */
+        std::vector<OrderBookEntry> getOrders(OrderBookType type, const std::string& product) const;
+        std::vector<PriceLevel> getDepth(OrderBookType type, const std::string& product, unsigned int n) const;
+        PriceSummary getPriceSummary(OrderBookType type, const std::string& product) const;
+        double getSpread(const std::string& product) const;
+        double getMidPrice(const std::string& product) const;
+
+        /** key of a product side in the resting map */
+        static std::string sideKey(OrderBookType type, const std::string& product);
+
+    private:
+        const RestingSide* restingSide(OrderBookType type, const std::string& product) const;
+
+        std::uint64_t version;
+        std::string timestamp;
+        std::vector<std::string> products;
+        std::shared_ptr<const BookShard> shard; // nullptr if the timestamp is in no shard
+        int frame;
+        std::map<std::string, RestingSide> resting; // Keyed by sideKey
+};
@@ -0,0 +1,62 @@
+#include "BookSnapshots.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+BookSnapshots::BookSnapshots() : current(nullptr), epoch(1)
+{
+
+}
+
+BookSnapshots::~BookSnapshots()
+{
+    // readers must be gone by now
+    delete current.load();
+    for (auto& r : retired)
+    {
+        delete r.second;
+    }
+}
+
+void BookSnapshots::publish(std::unique_ptr<const BookSnapshot> snapshot)
+{
+    const BookSnapshot* old = current.exchange(snapshot.release(), std::memory_order_seq_cst);
+    if (old != nullptr)
+    {
+        // a reader announcing a later epoch is sure to load the new pointer
+        retired.emplace_back(epoch.fetch_add(1, std::memory_order_seq_cst), old);
+    }
+    reclaim();
+}
+
+void BookSnapshots::reclaim()
+{
+    std::uint64_t oldest = epoch.load(std::memory_order_seq_cst);
+    for (const Slot& s : slots)
+    {
+        std::uint64_t e = s.epoch.load(std::memory_order_seq_cst);
+        if (e != 0) oldest = std::min(oldest, e);
+    }
+    auto stillVisible = std::remove_if(retired.begin(), retired.end(), [oldest](const std::pair<std::uint64_t, const BookSnapshot*>& r)
+    {
+        if (r.first >= oldest) return false; // A reader from that epoch may still hold it
+        delete r.second;
+        return true;
+    });
+    retired.erase(stillVisible, retired.end());
+}
+
+BookSnapshots::Reader::Reader(BookSnapshots& snapshots) : snapshots(snapshots)
+{
+    for (index = 0; index < maxReaders; ++index)
+    {
+        bool expected = false;
+        if (snapshots.slots[index].taken.compare_exchange_strong(expected, true)) return;
+    }
+    throw std::runtime_error("BookSnapshots: more than " + std::to_string(maxReaders) + " readers");
+}
+
+BookSnapshots::Reader::~Reader()
+{
+    snapshots.slots[index].taken.store(false, std::memory_order_release);
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "BookSnapshot.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * Hands the latest BookSnapshot from the matching thread to any number of
+ * reader threads, read-copy-update style with epoch based reclamation.
+ *
+ * The matching thread publishes a new snapshot once per frame with a single
+ * pointer swap. A reader announces the epoch it starts in, loads the
+ * pointer and clears its announcement when it is done; it never takes a
+ * lock and never waits for the writer, and the writer never waits for it.
+ * A replaced snapshot is deleted by a later publish once every reader that
+ * might still hold it has moved past its epoch, so a slow reader only
+ * delays the freeing of memory, never matching.
+ *
+ * publish is for one writer thread. Readers register through a Reader,
+ * each Reader is used by one thread.
+ */
+class BookSnapshots
+{
+    public:
+        static const unsigned int maxReaders = 64;
+
+        BookSnapshots();
+        ~BookSnapshots();
+        BookSnapshots(const BookSnapshots&) = delete;
+        BookSnapshots& operator=(const BookSnapshots&) = delete;
+
+        /** make snapshot the current one and free old snapshots no reader can see any more */
+        void publish(std::unique_ptr<const BookSnapshot> snapshot);
+
+        /** replaced snapshots still waiting for readers to move on, writer thread only */
+        std::size_t retiredCount() const { return retired.size(); }
+
+        /** a reader thread's registration. Throws std::runtime_error if all maxReaders slots are taken */
+        class Reader
+        {
+            public:
+                Reader(BookSnapshots& snapshots);
+                ~Reader();
+                Reader(const Reader&) = delete;
+                Reader& operator=(const Reader&) = delete;
+
+                /** call fn with the current snapshot, which stays valid until fn returns.
+                 *  Returns false without calling fn if nothing has been published yet */
+                template <typename Fn>
+                bool read(Fn fn)
+                {
+                    std::atomic<std::uint64_t>& slot = snapshots.slots[index].epoch;
+                    slot.store(snapshots.epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+                    const BookSnapshot* current = snapshots.current.load(std::memory_order_seq_cst);
+                    if (current != nullptr) fn(*current);
+                    slot.store(0, std::memory_order_release);
+                    return current != nullptr;
+                }
+
+            private:
+                BookSnapshots& snapshots;
+                unsigned int index;
+        };
+
+    private:
+        struct alignas(64) Slot // One cache line each so readers do not share lines
+        {
+            std::atomic<bool> taken{false};
+            std::atomic<std::uint64_t> epoch{0}; // Epoch the reader started in, 0 while idle
+        };
+
+        /** delete retired snapshots older than every active reader */
+        void reclaim();
+
+        std::atomic<const BookSnapshot*> current;
+        std::atomic<std::uint64_t> epoch; // Starts at 1 so 0 can mean idle
+        Slot slots[maxReaders];
+        std::vector<std::pair<std::uint64_t, const BookSnapshot*>> retired; // Epoch it was replaced in, snapshot
+};
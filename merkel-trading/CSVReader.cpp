@@ -1,4 +1,7 @@
 #include "CSVReader.h"
+#include "CSVSchema.h"
+#include "CSVTokenizer.h"
+#include "Log.h"
 #include <iostream>
 #include <fstream>
 #include <string> 
@@ -6,6 +9,47 @@
 #include <stdexcept> 
 #include <cstddef>   
 
+template <>
+struct CSVField<OrderBookType>
+{
+    static bool read(std::string_view text, OrderBookType& value)
+    {
+        value = text == "ask" ? OrderBookType::ask : text == "bid" ? OrderBookType::bid : OrderBookType::unknown;
+        return true; // Unknown types are kept, as stringToOrderBookType does
+    }
+};
+
+template <>
+struct CSVField<OrderExecution>
+{
+    static bool read(std::string_view text, OrderExecution& value)
+    {
+        try
+        {
+            value = OrderBookEntry::stringToOrderExecution(std::string(text));
+            return true;
+        }
+        catch (const std::invalid_argument&)
+        {
+            return false;
+        }
+    }
+};
+
+namespace
+{
+    typedef CSVReader::OrderRow OrderRow;
+
+    // timestamp,product,bid|ask,price,amount[,limit|market|ioc|fok]
+    using OrderSchema = CSVSchema<OrderRow,
+                                  CSVColumn<CSVAt<0>, &OrderRow::timestamp>,
+                                  CSVColumn<CSVAt<1>, &OrderRow::product>,
+                                  CSVColumn<CSVAt<2>, &OrderRow::type>,
+                                  CSVColumn<CSVAt<3>, &OrderRow::price>,
+                                  CSVColumn<CSVAt<4>, &OrderRow::amount>,
+                                  CSVOptional<CSVAt<5>, &OrderRow::execution>>;
+}
+
 CSVReader::CSVReader()
 {
 
@@ -26,86 +70,55 @@ std::vector<OrderBookEntry> CSVReader::readCSV(std::string csvFilename)
                 continue;
             }
             try {
-                OrderBookEntry obe = stringsToOBE(tokenise(line, ',')); // Tokenises the line
-                entries.push_back(obe); // Adds the OrderBookEntry to the vector
+                entries.push_back(lineToOBE(line)); // Reads the fields in place, no token copies
             } catch (const std::exception& e) {
-                // Log the error or the problematic line itself if desired
-                std::cerr << "Warning: Could not parse line: " << line << std::endl;
+                MERKEL_LOG_WARN("Could not parse line: " << line);
             }
         }//end of while
     }
-    std::cout << "CSVReader::readCSV read " << entries.size() << "entries" << std::endl; // Message for successful read
+    MERKEL_LOG_INFO("CSVReader::readCSV read " << entries.size() << " entries"); // Message for successful read
     return entries;
 }
 
 std::vector<std::string> CSVReader::tokenise(std::string csvLine, char separator)
 {
     std::vector<std::string> tokens;
-    std::string token;
-    std::string::size_type start, end;
-
-    // Find the beginning of the first token
-    start = csvLine.find_first_not_of(separator, 0);
-
-    // Loop while there are tokens to find
-    while (start != std::string::npos)
+    CSVTokenizer fields{csvLine, separator, true}; // Separators next to each other count as one
+    while (fields.next())
     {
-        // Find the end of the current token
-        end = csvLine.find_first_of(separator, start);
-
-        if (end == std::string::npos) // Last token in the line
-        {
-            token = csvLine.substr(start); // Get the rest of the string
-            tokens.push_back(token);
-            break; // No more tokens
-        }
-        else // Token found before a separator
-        {
-            token = csvLine.substr(start, end - start);
-            tokens.push_back(token);
-            // Find the beginning of the next token (skip over separators)
-            start = csvLine.find_first_not_of(separator, end);
-        }
+        tokens.push_back(fields.unquoted());
     }
     return tokens;
 }
 
-OrderBookEntry CSVReader::stringsToOBE(std::vector<std::string> tokens)
+bool CSVReader::readOrderRow(std::string_view line, OrderRow& row)
 {
-    double price, amount;
-
-    if (tokens.size() != 5) // Bad
-        {
-            std::cout << "Invalid line (received " << tokens.size() << " tokens): "; 
-            for (size_t i = 0; i < tokens.size(); ++i) {
-                std::cout << "[" << tokens[i] << "]";
-                if (i < tokens.size() - 1) {
-                    std::cout << ", ";
-                }
-            }
-            std::cout << std::endl; 
-            throw std::runtime_error("Invalid token count in CSV line"); // Throw a more specific exception
-        }
-
-        try { 
-            price = std::stod(tokens[3]); // Converts the 4th token to double
-            amount = std::stod(tokens[4]); // Converts the 5th token to double
+    // separators next to each other count as one, as they always have in these files
+    static const CSVRowParser<OrderSchema> parser = []()
+    {
+        CSVRowParser<OrderSchema> p{',', true};
+        p.setMaxFields(6);
+        return p;
+    }();
+    return parser.parse(line, row);
+}
 
-        } catch (const std::exception& e) {
-            std::cout << "CSVReader::stringsToOBE Bad float! " << tokens[3] << std::endl; // Message for bad float 3>>
-            std::cout << "CSVReader::stringsToOBE Bad float! " << tokens[4] << std::endl; // Message for bad float 4>>
-            throw;
-        } 
-            
+OrderBookEntry CSVReader::lineToOBE(std::string_view line)
+{
+    OrderRow row;
+    if (!readOrderRow(line, row))
+    {
+        throw std::runtime_error("CSVReader: not an order");
+    }
     OrderBookEntry obe
     {
-        price,
-        amount,
-        tokens[0], // timestamp
-        tokens[1], // product
-        OrderBookEntry::stringToOrderBookType(tokens[2]) // orderType
+        row.price,
+        row.amount,
+        std::string(row.timestamp),
+        std::string(row.product),
+        row.type
     };
-            
+    obe.execution = row.execution;
     return obe;
 }
 
@@ -121,8 +134,7 @@ OrderBookEntry CSVReader::stringsToOBE( std::string priceString,
         amount = std::stod(amountString); 
 
         } catch (const std::exception& e) {
-            std::cout << "CSVReader::stringsToOBE Bad float! " << priceString << std::endl; 
-            std::cout << "CSVReader::stringsToOBE Bad float! " << amountString << std::endl; 
+            MERKEL_LOG_WARN("CSVReader::stringsToOBE Bad float! " << priceString << " " << amountString);
             throw;
         }
     OrderBookEntry obe{price,
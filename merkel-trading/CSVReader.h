@@ -2,13 +2,28 @@
 #include "OrderBookEntry.h"
 #include <vector>
 #include <string>
+#include <string_view>
 
 class CSVReader
 {
     public:
     CSVReader();
 
+    /** the fields of one order book line, the strings point into the line */
+    struct OrderRow
+    {
+        std::string_view timestamp;
+        std::string_view product;
+        OrderBookType type;
+        double price;
+        double amount;
+        OrderExecution execution;
+    };
+
     static std::vector<OrderBookEntry> readCSV(std::string csvFile);
+    /** read one order book line in place, without building an OrderBookEntry.
+     *  False if the line does not hold an order */
+    static bool readOrderRow(std::string_view line, OrderRow& row);
     static std::vector<std::string> tokenise(std::string csvLine, char separator);
 
     static OrderBookEntry stringsToOBE( std::string price, 
@@ -18,5 +33,6 @@ class CSVReader
                                         std::string orderBookType);
 
     private:
-    static OrderBookEntry stringsToOBE(std::vector<std::string> strings);
+    /** one line of an order book file, throws if it does not hold an order */
+    static OrderBookEntry lineToOBE(std::string_view line);
 }; 
\ No newline at end of file
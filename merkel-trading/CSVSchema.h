@@ -0,0 +1,364 @@
+#pragma once
+#include "CSVTokenizer.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Row parsers generated from a description of a CSV file's columns.
+ *
+ * A schema lists which column goes into which member of a row struct:
+ *
+ *     struct PriceRow { std::string_view time; double price; std::optional<double> size; };
+ *     constexpr char timeColumn[] = "time";
+ *     using PriceSchema = CSVSchema<PriceRow,
+ *                                   CSVColumn<CSVNamed<timeColumn>, &PriceRow::time>,
+ *                                   CSVColumn<CSVAt<3>, &PriceRow::price>,
+ *                                   CSVOptional<CSVAt<4>, &PriceRow::size>>;
+ *
+ *     CSVRowParser<PriceSchema> parser{headerLine}; // Names are looked up here, once
+ *     PriceRow row;
+ *     while (std::getline(file, line))
+ *         if (parser.parse(line, row)) ...
+ *
+ * Columns are picked by position (CSVAt), by header name (CSVNamed) or, for
+ * a std::vector member, by every header that ends in a suffix (CSVEndsWith).
+ * The member's type picks the conversion through CSVField, which reads
+ * numbers with std::from_chars and can be specialised for new types. A
+ * std::optional member is left empty when its field does not convert
+ * instead of failing the row. string_view members point into the line and
+ * are only good until it changes.
+ *
+ * Binding the header sorts the columns by position once. parse then walks
+ * the line a single time and, at each bound position, calls the converter
+ * generated for that column through a table, stopping after the last one.
+ */
+
+/** the column at a fixed position, counting from 0 */
+template <std::size_t Index>
+struct CSVAt
+{
+};
+
+/** the column whose header is Name */
+template <const char* Name>
+struct CSVNamed
+{
+};
+
+/** every column whose header ends in Suffix, in header order, into a std::vector member */
+template <const char* Suffix>
+struct CSVEndsWith
+{
+};
+
+/** Key picks the column or columns, Member is the field of the row they are read into.
+ *  A row missing a required column does not parse */
+template <typename Key, auto Member, bool Required = true>
+struct CSVColumn
+{
+};
+
+template <typename Key, auto Member>
+using CSVOptional = CSVColumn<Key, Member, false>;
+
+template <typename Row, typename... Columns>
+struct CSVSchema
+{
+};
+
+/** how one field is read into a T, false if it cannot be. Specialise it for new types */
+template <typename T, typename Enable = void>
+struct CSVField;
+
+template <typename T>
+struct CSVField<T, typename std::enable_if<std::is_arithmetic<T>::value>::type>
+{
+    static bool read(std::string_view text, T& value) { return CSVTokenizer::parseNumber(text, value); }
+};
+
+template <>
+struct CSVField<std::string_view>
+{
+    static bool read(std::string_view text, std::string_view& value)
+    {
+        value = text;
+        return true;
+    }
+};
+
+template <>
+struct CSVField<std::string>
+{
+    static bool read(std::string_view text, std::string& value)
+    {
+        value.assign(text.data(), text.size());
+        return true;
+    }
+};
+
+template <typename T>
+struct CSVField<std::optional<T>>
+{
+    static bool read(std::string_view text, std::optional<T>& value)
+    {
+        T parsed{};
+        if (CSVField<T>::read(text, parsed)) value = parsed;
+        else value.reset();
+        return true;
+    }
+};
+
+namespace csvschema
+{
+    template <typename T>
+    struct MemberOf;
+
+    template <typename Row, typename T>
+    struct MemberOf<T Row::*>
+    {
+        using type = T;
+    };
+
+    template <typename T>
+    struct IsVector : std::false_type
+    {
+    };
+
+    template <typename T>
+    struct IsVector<std::vector<T>> : std::true_type
+    {
+    };
+
+    /** what one schema column knows about itself */
+    template <typename Column>
+    struct ColumnInfo;
+
+    template <typename Key, auto Member, bool Required>
+    struct ColumnInfo<CSVColumn<Key, Member, Required>>
+    {
+        using Type = typename MemberOf<decltype(Member)>::type;
+        static constexpr bool required = Required;
+        static constexpr bool many = false;
+
+        static void bind(const std::vector<std::string>& headers, std::vector<std::size_t>& positions)
+        {
+            locate(Key{}, headers, positions);
+        }
+
+        template <typename Row>
+        static void reset(Row& row)
+        {
+            if (!Required) row.*Member = Type{}; // Left so when the line is too short to have it
+        }
+
+        template <typename Row>
+        static bool read(std::string_view text, Row& row, std::size_t)
+        {
+            return CSVField<Type>::read(text, row.*Member);
+        }
+
+        template <std::size_t Index>
+        static void locate(CSVAt<Index>, const std::vector<std::string>&, std::vector<std::size_t>& positions)
+        {
+            positions.push_back(Index);
+        }
+
+        template <const char* Name>
+        static void locate(CSVNamed<Name>, const std::vector<std::string>& headers, std::vector<std::size_t>& positions)
+        {
+            auto it = std::find(headers.begin(), headers.end(), std::string_view{Name});
+            if (it != headers.end()) positions.push_back(it - headers.begin());
+        }
+    };
+
+    template <const char* Suffix, auto Member, bool Required>
+    struct ColumnInfo<CSVColumn<CSVEndsWith<Suffix>, Member, Required>>
+    {
+        using Type = typename MemberOf<decltype(Member)>::type;
+        static_assert(IsVector<Type>::value, "CSVEndsWith columns are read into a std::vector member");
+        using Element = typename Type::value_type;
+        static constexpr bool required = Required;
+        static constexpr bool many = true;
+
+        static void bind(const std::vector<std::string>& headers, std::vector<std::size_t>& positions)
+        {
+            std::string_view suffix{Suffix};
+            for (std::size_t i = 0; i < headers.size(); ++i)
+            {
+                const std::string& h = headers[i];
+                if (h.size() > suffix.size() && h.compare(h.size() - suffix.size(), suffix.size(), suffix) == 0)
+                {
+                    positions.push_back(i);
+                }
+            }
+        }
+
+        template <typename Row>
+        static void reset(Row& row, std::size_t count)
+        {
+            Type& values = row.*Member;
+            values.resize(count);
+            std::fill(values.begin(), values.end(), Element{});
+        }
+
+        template <typename Row>
+        static bool read(std::string_view text, Row& row, std::size_t slot)
+        {
+            return CSVField<Element>::read(text, (row.*Member)[slot]);
+        }
+    };
+}
+
+template <typename Schema>
+class CSVRowParser;
+
+template <typename Row, typename... Columns>
+class CSVRowParser<CSVSchema<Row, Columns...>>
+{
+    public:
+        static constexpr std::size_t columnCount = sizeof...(Columns);
+
+        /** a parser for a file without a header, columns can only be picked with CSVAt.
+         *  skipEmpty counts runs of separators as one, see CSVTokenizer */
+        explicit CSVRowParser(char separator = ',', bool skipEmpty = false)
+            : separator(separator), skipEmpty(skipEmpty), minFields(0), maxFields(0)
+        {
+            bind({});
+        }
+
+        /** a parser for the file with this header line. Throws std::runtime_error if
+         *  a required column is not in it, or two columns want the same field */
+        explicit CSVRowParser(std::string_view header, char separator = ',')
+            : separator(separator), skipEmpty(false), minFields(0), maxFields(0)
+        {
+            std::vector<std::string> headers;
+            CSVTokenizer fields{header, separator};
+            while (fields.next())
+            {
+                headers.push_back(fields.unquoted());
+            }
+            bind(headers);
+        }
+
+        /** rows with fewer than n fields do not parse, 0 (the default) for any number */
+        void setMinFields(std::size_t n) { minFields = n; }
+        /** rows with more than n fields do not parse, 0 (the default) for any number */
+        void setMaxFields(std::size_t n) { maxFields = n; }
+
+        /** read one line into row, false if a required column is missing or does not convert */
+        bool parse(std::string_view line, Row& row) const
+        {
+            resetRow(row, std::index_sequence_for<Columns...>{});
+            CSVTokenizer fields{line, separator, skipEmpty};
+            std::size_t b = 0;
+            while (b < bindings.size() && fields.next())
+            {
+                if (fields.index() != bindings[b].position) continue;
+                if (!bindings[b].read(fields.field(), row, bindings[b].slot)) return false;
+                ++b;
+            }
+            if (b < requiredBindings) return false; // Line ended before a required column
+            while (fields.index() + 1 < minFields) // index() + 1 is 0 before the first field
+            {
+                if (!fields.next()) return false;
+            }
+            if (maxFields > 0)
+            {
+                while (fields.next())
+                {
+                    if (fields.index() >= maxFields) return false;
+                }
+            }
+            return true;
+        }
+
+        /** the header names bound to column c of the schema, in field order */
+        const std::vector<std::string>& getHeaders(std::size_t column) const { return names[column]; }
+        /** number of fields bound to column c, more than one only for CSVEndsWith */
+        std::size_t getWidth(std::size_t column) const { return names[column].size(); }
+
+    private:
+        typedef bool (*ReadFn)(std::string_view, Row&, std::size_t);
+
+        /** one field of the line and where it goes */
+        struct Binding
+        {
+            std::size_t position;
+            ReadFn read;
+            std::size_t slot; // Element of a vector member
+            bool required;
+        };
+
+        void bind(const std::vector<std::string>& headers)
+        {
+            bindColumns(headers, std::index_sequence_for<Columns...>{});
+            std::sort(bindings.begin(), bindings.end(), [](const Binding& a, const Binding& b)
+            {
+                return a.position < b.position;
+            });
+            requiredBindings = 0;
+            for (std::size_t b = 0; b < bindings.size(); ++b)
+            {
+                if (b > 0 && bindings[b].position == bindings[b - 1].position)
+                {
+                    throw std::runtime_error("CSVRowParser: two columns read field " +
+                                             std::to_string(bindings[b].position));
+                }
+                if (bindings[b].required) requiredBindings = b + 1;
+            }
+        }
+
+        template <std::size_t... C>
+        void bindColumns(const std::vector<std::string>& headers, std::index_sequence<C...>)
+        {
+            (bindColumn<C, Columns>(headers), ...);
+        }
+
+        template <std::size_t C, typename Column>
+        void bindColumn(const std::vector<std::string>& headers)
+        {
+            using Info = csvschema::ColumnInfo<Column>;
+            std::vector<std::size_t> positions;
+            Info::bind(headers, positions);
+            if (positions.empty() && Info::required)
+            {
+                throw std::runtime_error("CSVRowParser: no field for column " + std::to_string(C) +
+                                         (headers.empty() ? std::string{" without a header"} : std::string{" in the header"}));
+            }
+            for (std::size_t slot = 0; slot < positions.size(); ++slot)
+            {
+                bindings.push_back(Binding{positions[slot], &Info::template read<Row>, slot, Info::required});
+                names[C].push_back(positions[slot] < headers.size() ? headers[positions[slot]] : std::string{});
+            }
+        }
+
+        template <std::size_t... C>
+        void resetRow(Row& row, std::index_sequence<C...>) const
+        {
+            (resetColumn<C, Columns>(row), ...);
+        }
+
+        template <std::size_t C, typename Column>
+        void resetColumn(Row& row) const
+        {
+            using Info = csvschema::ColumnInfo<Column>;
+            if constexpr (Info::many) Info::reset(row, names[C].size());
+            else Info::reset(row);
+        }
+
+        char separator;
+        bool skipEmpty;
+        std::size_t minFields;
+        std::size_t maxFields;
+        std::vector<Binding> bindings;  // By position
+        std::size_t requiredBindings;   // bindings up to the last required one
+        std::array<std::vector<std::string>, sizeof...(Columns)> names;
+};
@@ -0,0 +1,164 @@
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+/**
+ * Walks the fields of one CSV line in place, without copying or allocating.
+ *
+ * next() moves to the following field and field() views it inside the
+ * line, so the line must outlive the tokenizer. A field that starts with a
+ * double quote runs to the closing quote and may hold separators; field()
+ * is then the text between the quotes with any doubled quotes left as they
+ * are, unquoted() makes the copy that undoubles them. A trailing '\r' is
+ * ignored so files with Windows line ends read the same.
+ *
+ *     CSVTokenizer t{line};
+ *     double price;
+ *     while (t.next())
+ *     {
+ *         if (t.index() == 3 && !t.parse(price)) ...
+ *     }
+ *
+ * With skipEmpty set, runs of separators count as one and empty fields are
+ * never returned, the way CSVReader::tokenise has always split.
+ */
+class CSVTokenizer
+{
+    public:
+        explicit CSVTokenizer(std::string_view line, char separator = ',', bool skipEmpty = false)
+            : line(line), separator(separator), skipEmpty(skipEmpty), position(0), fieldIndex(npos),
+              isQuoted(false)
+        {
+            if (!this->line.empty() && this->line.back() == '\r') this->line.remove_suffix(1);
+        }
+
+        /** move to the next field, false once the line has no more */
+        bool next()
+        {
+            while (position <= line.size())
+            {
+                read();
+                if (!skipEmpty || !current.empty() || isQuoted)
+                {
+                    ++fieldIndex;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /** skip n fields, false if the line ran out first */
+        bool skip(std::size_t n)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                if (!next()) return false;
+            }
+            return true;
+        }
+
+        /** the current field, quotes removed */
+        std::string_view field() const { return current; }
+        /** position of the current field in the line, counting from 0 */
+        std::size_t index() const { return fieldIndex; }
+        bool quoted() const { return isQuoted; }
+
+        /** the current field as a string, doubled quotes in a quoted field made single */
+        std::string unquoted() const
+        {
+            if (!isQuoted) return std::string(current);
+            std::string s;
+            s.reserve(current.size());
+            for (std::size_t i = 0; i < current.size(); ++i)
+            {
+                s += current[i];
+                if (current[i] == '"' && i + 1 < current.size() && current[i + 1] == '"') ++i;
+            }
+            return s;
+        }
+
+        /** read the current field as a number with std::from_chars. Spaces around it are
+         *  allowed, anything else left over is not. value is only written on success */
+        template <typename T>
+        bool parse(T& value) const
+        {
+            static_assert(std::is_arithmetic<T>::value, "CSVTokenizer::parse reads numbers");
+            return parseNumber(current, value);
+        }
+
+        /** a whole field as a number, the same rules as parse */
+        template <typename T>
+        static bool parseNumber(std::string_view text, T& value)
+        {
+            while (!text.empty() && text.front() == ' ') text.remove_prefix(1);
+            while (!text.empty() && text.back() == ' ') text.remove_suffix(1);
+            if (!text.empty() && text.front() == '+') text.remove_prefix(1); // from_chars takes no sign but '-'
+            if (text.empty()) return false;
+            T parsed;
+            std::from_chars_result r = std::from_chars(text.data(), text.data() + text.size(), parsed);
+            if (r.ec != std::errc() || r.ptr != text.data() + text.size()) return false;
+            value = parsed;
+            return true;
+        }
+
+        /** number of fields in a line, with the same rules as next */
+        static std::size_t countFields(std::string_view line, char separator = ',', bool skipEmpty = false)
+        {
+            CSVTokenizer t{line, separator, skipEmpty};
+            std::size_t n = 0;
+            while (t.next()) ++n;
+            return n;
+        }
+
+    private:
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        /** set current to the field at position and move position past its separator,
+         *  to one past the end of the line after the last field */
+        void read()
+        {
+            isQuoted = position < line.size() && line[position] == '"';
+            if (!isQuoted)
+            {
+                std::size_t end = line.find(separator, position);
+                if (end == std::string_view::npos) end = line.size();
+                current = line.substr(position, end - position);
+                position = end + 1;
+                return;
+            }
+
+            // a quote ends the field unless another one follows it
+            std::size_t start = position + 1;
+            std::size_t end = start;
+            while (true)
+            {
+                end = line.find('"', end);
+                if (end == std::string_view::npos)
+                {
+                    end = line.size(); // No closing quote, take the rest of the line
+                    break;
+                }
+                if (end + 1 < line.size() && line[end + 1] == '"')
+                {
+                    end += 2;
+                    continue;
+                }
+                break;
+            }
+            current = line.substr(start, end - start);
+            std::size_t after = line.find(separator, end); // Anything between the quote and the separator is dropped
+            position = after == std::string_view::npos ? line.size() + 1 : after + 1;
+        }
+
+        std::string_view line;
+        char separator;
+        bool skipEmpty;
+        std::size_t position;   // Start of the next field, line.size() + 1 once every field is read
+        std::size_t fieldIndex; // npos before the first field
+        std::string_view current;
+        bool isQuoted;
+};
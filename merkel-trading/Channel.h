@@ -0,0 +1,54 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+/**
+ * A bounded queue that hands work from one pipeline stage to the next.
+ * push blocks while the queue is full, pop blocks while it is empty.
+ * After close, pop drains what is left and then returns false.
+ */
+template <typename T>
+class Channel
+{
+    public:
+        explicit Channel(std::size_t capacity) : capacity(capacity), closed(false) {}
+
+        void push(T item)
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            notFull.wait(lock, [this] { return items.size() < capacity || closed; });
+            if (closed) return;
+            items.push_back(std::move(item));
+            notEmpty.notify_one();
+        }
+
+        bool pop(T& item)
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            notEmpty.wait(lock, [this] { return !items.empty() || closed; });
+            if (items.empty()) return false; // closed and drained
+            item = std::move(items.front());
+            items.pop_front();
+            notFull.notify_one();
+            return true;
+        }
+
+        /** no more items will be pushed */
+        void close()
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            closed = true;
+            notEmpty.notify_all();
+            notFull.notify_all();
+        }
+
+    private:
+        std::size_t capacity;
+        bool closed;
+        std::deque<T> items;
+        std::mutex mutex;
+        std::condition_variable notEmpty;
+        std::condition_variable notFull;
+};
@@ -0,0 +1,260 @@
+#include "ChunkedAnalytics.h"
+#include "CSVReader.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+namespace
+{
+    /** prices and amounts of one product read from the current block, per side */
+    struct Batch
+    {
+        std::vector<double> prices[2];
+        std::vector<double> amounts[2];
+    };
+}
+
+ChunkedAnalytics::ChunkedAnalytics(const std::string& path, std::size_t chunkBytes, std::size_t blockBytes)
+    : blockBytes(blockBytes < 4096 ? 4096 : blockBytes)
+{
+    if (std::filesystem::is_directory(path))
+    {
+        for (const auto& entry : std::filesystem::directory_iterator(path))
+        {
+            if (entry.is_regular_file() && entry.path().extension() == ".csv") files.push_back(entry.path().string());
+        }
+        std::sort(files.begin(), files.end());
+    }
+    else if (std::filesystem::is_regular_file(path))
+    {
+        files.push_back(path);
+    }
+    if (files.empty())
+    {
+        throw std::runtime_error("ChunkedAnalytics: no csv files in " + path);
+    }
+
+    if (chunkBytes < this->blockBytes) chunkBytes = this->blockBytes;
+    for (std::size_t f = 0; f < files.size(); ++f)
+    {
+        std::size_t size = std::filesystem::file_size(files[f]);
+        for (std::size_t begin = 0; begin < size; begin += chunkBytes)
+        {
+            chunks.push_back(Chunk{f, begin, std::min(size, begin + chunkBytes)});
+        }
+    }
+}
+
+ChunkedResult ChunkedAnalytics::run(const std::string& from, const std::string& to, unsigned int threads) const
+{
+    std::vector<ChunkedResult> results(chunks.size());
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    if (threads > chunks.size()) threads = chunks.size();
+
+    // Each worker takes the next chunk until they are all done
+    std::atomic<std::size_t> next{0};
+    auto worker = [&]()
+    {
+        for (std::size_t i = next++; i < chunks.size(); i = next++)
+        {
+            results[i] = scan(chunks[i], from, to);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned int t = 1; t < threads; ++t)
+    {
+        pool.emplace_back(worker);
+    }
+    worker(); // This thread works too
+    for (std::thread& t : pool)
+    {
+        t.join();
+    }
+
+    // in file order, so the sums do not depend on which thread finished first
+    ChunkedResult total{{}, 0, 0, 0, chunks.size()};
+    for (const ChunkedResult& r : results)
+    {
+        merge(total, r);
+    }
+    return total;
+}
+
+ChunkedResult ChunkedAnalytics::scan(const Chunk& chunk, const std::string& from, const std::string& to) const
+{
+    ChunkedResult result{{}, 0, 0, 0, 1};
+    std::ifstream in{files[chunk.file], std::ios::binary};
+    if (!in.is_open()) return result;
+
+    // a chunk owns the lines that start inside it. If it starts mid line,
+    // that line belongs to the chunk before
+    bool skipFirst = false;
+    std::size_t offset = chunk.begin; // File offset of the next byte to split into lines
+    if (chunk.begin > 0)
+    {
+        in.seekg(chunk.begin - 1);
+        char before = '\n';
+        in.get(before);
+        skipFirst = before != '\n';
+    }
+
+    std::map<std::string, Batch, std::less<>> batches;
+    std::string_view lastProduct;
+    Batch* last = nullptr;
+    auto handle = [&](std::string_view line)
+    {
+        if (line.empty() || line == "\r") return;
+        CSVReader::OrderRow row;
+        if (!CSVReader::readOrderRow(line, row))
+        {
+            ++result.rejected;
+            return;
+        }
+        if (row.type != OrderBookType::bid && row.type != OrderBookType::ask) return;
+        if ((!from.empty() && row.timestamp < from) || (!to.empty() && row.timestamp > to)) return;
+        ++result.rows;
+
+        if (last == nullptr || row.product != lastProduct)
+        {
+            auto it = batches.find(row.product);
+            if (it == batches.end()) it = batches.emplace(std::string(row.product), Batch{}).first;
+            last = &it->second;
+            lastProduct = it->first; // Points at the key, which outlives the line
+        }
+        int side = row.type == OrderBookType::bid ? 0 : 1;
+        last->prices[side].push_back(row.price);
+        last->amounts[side].push_back(row.amount);
+    };
+    auto summarise = [&]()
+    {
+        for (auto& b : batches)
+        {
+            ProductStats& stats = result.products[b.first];
+            PriceSummary* sides[2] = {&stats.bids, &stats.asks};
+            for (int side = 0; side < 2; ++side)
+            {
+                std::vector<double>& prices = b.second.prices[side];
+                std::vector<double>& amounts = b.second.amounts[side];
+                if (prices.empty()) continue;
+                *sides[side] = PriceStats::merge(*sides[side],
+                                                 PriceStats::compute(prices.data(), amounts.data(), prices.size()));
+                prices.clear();
+                amounts.clear();
+            }
+        }
+    };
+
+    std::vector<char> block(blockBytes);
+    std::string carry; // Start of a line cut off by the end of a block
+    while (true)
+    {
+        if (offset >= chunk.end)
+        {
+            // only a line that starts inside the chunk and runs over its end is left,
+            // read up to its line break rather than another whole block
+            if (!carry.empty())
+            {
+                std::string tail;
+                std::getline(in, tail);
+                result.bytes += tail.size() + (in.eof() ? 0 : 1); // And the line break, if there was one
+                carry += tail;
+                if (!skipFirst) handle(carry);
+            }
+            break;
+        }
+
+        // blocks stop at the chunk's end, every line split out of one starts inside the chunk
+        in.read(block.data(), std::min(block.size(), chunk.end - offset));
+        std::size_t got = in.gcount();
+        if (got == 0)
+        {
+            if (!carry.empty() && !skipFirst) handle(carry); // The file is shorter than it was
+            break;
+        }
+        result.bytes += got;
+
+        const char* p = block.data();
+        const char* e = p + got;
+        while (p < e)
+        {
+            const char* nl = static_cast<const char*>(std::memchr(p, '\n', e - p));
+            if (nl == nullptr)
+            {
+                carry.append(p, e);
+                break;
+            }
+            std::string_view line{p, static_cast<std::size_t>(nl - p)};
+            if (!carry.empty())
+            {
+                carry.append(p, nl);
+                line = carry;
+            }
+            if (skipFirst)
+            {
+                skipFirst = false;
+            }
+            else
+            {
+                handle(line);
+            }
+            offset += nl + 1 - p;
+            p = nl + 1;
+            carry.clear();
+        }
+        offset += e - p; // The bytes put into carry
+        summarise(); // Keeps the batches to one block's worth
+    }
+    summarise();
+    return result;
+}
+
+void ChunkedAnalytics::merge(ChunkedResult& a, const ChunkedResult& b)
+{
+    for (const auto& p : b.products)
+    {
+        ProductStats& stats = a.products[p.first];
+        stats.bids = PriceStats::merge(stats.bids, p.second.bids);
+        stats.asks = PriceStats::merge(stats.asks, p.second.asks);
+    }
+    a.rows += b.rows;
+    a.rejected += b.rejected;
+    a.bytes += b.bytes;
+}
+
+std::string ChunkedAnalytics::formatResult(const ChunkedResult& result)
+{
+    std::ostringstream out;
+    out << std::left << std::setw(12) << "Product" << std::setw(6) << "Side"
+        << std::right << std::setw(12) << "Orders"
+        << std::setw(18) << "Volume"
+        << std::setw(16) << "VWAP"
+        << std::setw(16) << "Low"
+        << std::setw(16) << "High" << "\n";
+    for (const auto& p : result.products)
+    {
+        const PriceSummary* sides[2] = {&p.second.bids, &p.second.asks};
+        const char* names[2] = {"bid", "ask"};
+        for (int side = 0; side < 2; ++side)
+        {
+            const PriceSummary& s = *sides[side];
+            out << std::left << std::setw(12) << p.first << std::setw(6) << names[side]
+                << std::right << std::setw(12) << s.count
+                << std::setw(18) << s.amount
+                << std::setw(16) << s.vwap()
+                << std::setw(16) << s.low
+                << std::setw(16) << s.high << "\n";
+        }
+    }
+    out << result.rows << " orders, " << result.rejected << " lines skipped, "
+        << result.bytes << " bytes in " << result.chunks << " chunks\n";
+    return out.str();
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "PriceStats.h"
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+/** Statistics of both sides of one product */
+struct ProductStats
+{
+    PriceSummary bids;
+    PriceSummary asks;
+};
+
+/** What a pass over a dataset found */
+struct ChunkedResult
+{
+    std::map<std::string, ProductStats> products;
+    std::size_t rows;     // orders inside the time range
+    std::size_t rejected; // lines that do not hold an order, headers included
+    std::size_t bytes;    // bytes read
+    std::size_t chunks;
+};
+
+/**
+ * Per product statistics over order book csv files of any size.
+ *
+ * The files are never loaded whole. Each is cut into chunks of about
+ * chunkBytes, ending at line breaks, and worker threads take chunks in turn.
+ * A worker reads its chunk blockBytes at a time, parses the lines in place
+ * with CSVReader::readOrderRow and hands each block's prices and amounts to
+ * the PriceStats kernels, so memory stays near threads * blockBytes whatever
+ * the dataset's size. Chunk results are merged in file order, which makes
+ * a pass give the same answer with any number of threads.
+ *
+ * The totals are those of OrderBook::getPriceSummary and getRangeSummary
+ * over the same orders. They are summed in a different order, so they can
+ * differ from the in-memory ones in the last bits.
+ */
+class ChunkedAnalytics
+{
+    public:
+        /** a csv file, or a directory whose csv files are read in name order.
+         *  Throws std::runtime_error if there is nothing to read */
+        ChunkedAnalytics(const std::string& path,
+                         std::size_t chunkBytes = 64 << 20,
+                         std::size_t blockBytes = 1 << 20);
+
+        /** every order with from <= timestamp <= to, an empty bound leaves that end open.
+         *  threads 0 uses one per core */
+        ChunkedResult run(const std::string& from = "", const std::string& to = "", unsigned int threads = 0) const;
+
+        std::size_t chunkCount() const { return chunks.size(); }
+
+        /** one line per product and side: count, volume, vwap, low, high */
+        static std::string formatResult(const ChunkedResult& result);
+
+    private:
+        /** the lines starting in [begin, end) of one file */
+        struct Chunk
+        {
+            std::size_t file;
+            std::size_t begin;
+            std::size_t end;
+        };
+
+        ChunkedResult scan(const Chunk& chunk, const std::string& from, const std::string& to) const;
+        /** fold b into a, products of b that a lacks are added */
+        static void merge(ChunkedResult& a, const ChunkedResult& b);
+
+        std::vector<std::string> files;
+        std::vector<Chunk> chunks;
+        std::size_t blockBytes;
+};
@@ -0,0 +1,29 @@
+#include "EventScheduler.h"
+#include <algorithm>
+
+EventScheduler::EventScheduler(std::size_t capacity) : nextSequence(0)
+{
+    heap.reserve(capacity);
+}
+
+void EventScheduler::push(SimEvent event)
+{
+    if (heap.size() == heap.capacity()) grow();
+    event.sequence = nextSequence++;
+    heap.push_back(event); // Never reallocates, there is room
+    std::push_heap(heap.begin(), heap.end(), later);
+}
+
+void EventScheduler::grow()
+{
+    heap.reserve(std::max<std::size_t>(heap.capacity() * 2, 64));
+}
+
+bool EventScheduler::pop(SimEvent& event)
+{
+    if (heap.empty()) return false;
+    std::pop_heap(heap.begin(), heap.end(), later);
+    event = heap.back();
+    heap.pop_back();
+    return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/** What a scheduled event does, see EventSimulator */
+enum class SimEventKind : std::uint8_t
+{
+    datasetOrder, // ref is the index of a dataset order
+    agentOrder,   // ref is a pending order slot
+    expire,       // ref is the id of a resting order
+    wakeup,       // agent's timer
+    fill          // ref is a pending fill slot for agent
+};
+
+/** One scheduled event, a plain 24 byte record */
+struct SimEvent
+{
+    std::int64_t time;      // Microseconds since the epoch
+    std::uint64_t sequence; // Set by push, events at the same time run in push order
+    std::uint32_t ref;
+    std::uint16_t agent;
+    SimEventKind kind;
+};
+
+/**
+ * Time ordered queue of SimEvents: a binary heap in storage reserved up
+ * front, so pushing and popping do not allocate while the queue stays
+ * within the capacity it was made with. Past that the storage doubles,
+ * which a caller that sized it well never pays for. Ties on time are
+ * broken by push order, which keeps a replay deterministic.
+ */
+class EventScheduler
+{
+    public:
+        /** room for capacity events waiting at once before the storage has to grow */
+        EventScheduler(std::size_t capacity);
+
+        /** queue an event */
+        void push(SimEvent event);
+        /** take the earliest event, returns false if there is none */
+        bool pop(SimEvent& event);
+        /** time of the earliest event, the queue must not be empty */
+        std::int64_t nextTime() const { return heap.front().time; }
+
+        bool empty() const { return heap.empty(); }
+        std::size_t size() const { return heap.size(); }
+        std::size_t capacity() const { return heap.capacity(); }
+        void clear() { heap.clear(); }
+
+    private:
+        static bool later(const SimEvent& a, const SimEvent& b)
+        {
+            return a.time != b.time ? a.time > b.time : a.sequence > b.sequence;
+        }
+
+        /** double the storage, kept out of push so the common path stays small */
+        void grow();
+
+        std::vector<SimEvent> heap; // Earliest at the front
+        std::uint64_t nextSequence;
+};
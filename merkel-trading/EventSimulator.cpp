@@ -0,0 +1,301 @@
+#include "EventSimulator.h"
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+
+namespace
+{
+    const double DUST = 1e-12; // Amounts below this count as filled
+
+    // days between 1970-01-01 and a civil date, and back
+    std::int64_t daysFromCivil(std::int64_t y, unsigned int m, unsigned int d)
+    {
+        y -= m <= 2;
+        std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+        unsigned int yoe = static_cast<unsigned int>(y - era * 400);
+        unsigned int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        unsigned int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+    }
+
+    void civilFromDays(std::int64_t z, int& y, unsigned int& m, unsigned int& d)
+    {
+        z += 719468;
+        std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+        unsigned int doe = static_cast<unsigned int>(z - era * 146097);
+        unsigned int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        unsigned int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        unsigned int mp = (5 * doy + 2) / 153;
+        d = doy - (153 * mp + 2) / 5 + 1;
+        m = mp < 10 ? mp + 3 : mp - 9;
+        y = static_cast<int>(yoe + era * 400 + (m <= 2));
+    }
+
+    /** digits of s from pos, n of them */
+    int digits(const std::string& s, std::size_t pos, std::size_t n)
+    {
+        int value = 0;
+        for (std::size_t i = pos; i < pos + n; ++i)
+        {
+            if (i >= s.size() || s[i] < '0' || s[i] > '9')
+            {
+                throw std::invalid_argument("EventSimulator: bad timestamp " + s);
+            }
+            value = value * 10 + (s[i] - '0');
+        }
+        return value;
+    }
+}
+
+EventSimulator::EventSimulator(const std::vector<OrderBookEntry>& orders,
+                               std::int64_t datasetLifetime,
+                               std::size_t capacity)
+    : orders(orders),
+      datasetLifetime(datasetLifetime),
+      endTime(0),
+      scheduler(capacity + 1 + (datasetLifetime > 0 ? orders.size() : 0)), // Every dataset order may wait to expire
+      slots(capacity, OrderBookEntry{0, 0, "", "", OrderBookType::unknown}),
+      slotLifetime(capacity, 0),
+      clock(0)
+{
+    times.reserve(orders.size());
+    replayOrder.reserve(orders.size());
+    for (std::size_t i = 0; i < orders.size(); ++i)
+    {
+        times.push_back(toMicros(orders[i].timestamp));
+        replayOrder.push_back(static_cast<std::uint32_t>(i));
+    }
+    std::stable_sort(replayOrder.begin(), replayOrder.end(), [this](std::uint32_t a, std::uint32_t b)
+    {
+        return times[a] < times[b];
+    });
+
+    endTime = replayOrder.empty() ? 0 : times[replayOrder.back()];
+
+    freeSlots.reserve(capacity);
+    for (std::size_t s = capacity; s > 0; --s)
+    {
+        freeSlots.push_back(static_cast<std::uint32_t>(s - 1));
+    }
+}
+
+unsigned int EventSimulator::addAgent(SimAgent& agent, std::int64_t latency)
+{
+    agents.push_back(Agent{&agent, latency});
+    return agents.size() - 1;
+}
+
+std::uint32_t EventSimulator::takeSlot()
+{
+    if (freeSlots.empty())
+    {
+        throw std::length_error("EventSimulator: more than " + std::to_string(slots.size()) + " orders in flight");
+    }
+    std::uint32_t slot = freeSlots.back();
+    freeSlots.pop_back();
+    return slot;
+}
+
+void EventSimulator::schedule(std::int64_t time, SimEventKind kind, std::uint32_t ref, std::uint16_t agent)
+{
+    SimEvent event;
+    event.time = time;
+    event.sequence = 0;
+    event.ref = ref;
+    event.agent = agent;
+    event.kind = kind;
+    scheduler.push(event);
+}
+
+void EventSimulator::submit(unsigned int agent, const OrderBookEntry& order, std::int64_t lifetime)
+{
+    std::uint32_t slot = takeSlot();
+    std::int64_t arrival = clock + agents[agent].latency;
+    slots[slot] = order;
+    slots[slot].timestamp = toTimestamp(arrival);
+    slotLifetime[slot] = lifetime;
+    schedule(arrival, SimEventKind::agentOrder, slot, static_cast<std::uint16_t>(agent + 1));
+}
+
+void EventSimulator::wakeAt(unsigned int agent, std::int64_t time)
+{
+    if (time > endTime) return;
+    schedule(std::max(time, clock), SimEventKind::wakeup, 0, static_cast<std::uint16_t>(agent + 1));
+}
+
+bool EventSimulator::bestPrice(OrderBookType type, const std::string& product, double& price) const
+{
+    const std::map<double, RestingLevel>* side = book.getLevels(type, product);
+    if (side == nullptr || side->empty()) return false;
+    price = type == OrderBookType::bid ? side->rbegin()->first : side->begin()->first;
+    return true;
+}
+
+SimulationResult EventSimulator::run(std::function<void(const OrderBookEntry&)> onTrade)
+{
+    result = SimulationResult{};
+    tradeSink = onTrade;
+    clock = times.empty() ? 0 : times[replayOrder[0]];
+    result.start = clock;
+
+    std::size_t next = 0; // Next dataset order to feed in, only one is ever queued
+    if (!replayOrder.empty()) schedule(times[replayOrder[0]], SimEventKind::datasetOrder, replayOrder[0], 0);
+    for (std::size_t a = 0; a < agents.size(); ++a)
+    {
+        wakeAt(a, clock);
+    }
+
+    SimEvent event;
+    while (scheduler.pop(event))
+    {
+        clock = event.time;
+        result.events++;
+        switch (event.kind)
+        {
+            case SimEventKind::datasetOrder:
+            {
+                OrderBookEntry order = orders[event.ref];
+                arrive(order, 0, datasetLifetime);
+                if (++next < replayOrder.size())
+                {
+                    schedule(times[replayOrder[next]], SimEventKind::datasetOrder, replayOrder[next], 0);
+                }
+                break;
+            }
+            case SimEventKind::agentOrder:
+                arrive(slots[event.ref], event.agent, slotLifetime[event.ref]);
+                freeSlots.push_back(event.ref);
+                break;
+            case SimEventKind::expire:
+                if (book.cancel(event.ref)) result.expired++;
+                break;
+            case SimEventKind::wakeup:
+                agents[event.agent - 1].agent->onWakeup(*this, event.agent - 1);
+                break;
+            case SimEventKind::fill:
+                agents[event.agent - 1].agent->onFill(*this, event.agent - 1, slots[event.ref]);
+                freeSlots.push_back(event.ref);
+                break;
+        }
+    }
+    result.end = clock;
+    tradeSink = nullptr;
+    return result;
+}
+
+void EventSimulator::arrive(OrderBookEntry& order, std::uint16_t agent, std::int64_t lifetime)
+{
+    bool buy = order.orderType == OrderBookType::bid;
+    if (!buy && order.orderType != OrderBookType::ask) return; // Sales in the data are history, not orders
+    OrderBookType opposite = buy ? OrderBookType::ask : OrderBookType::bid;
+    bool market = order.execution == OrderExecution::market;
+    auto crosses = [&](double price) { return market || (buy ? price <= order.price : price >= order.price); };
+
+    const std::map<double, RestingLevel>* side = book.getLevels(opposite, order.product);
+    if (order.execution == OrderExecution::fok)
+    {
+        double available = 0;
+        if (side != nullptr)
+        {
+            for (auto it = side->begin(); it != side->end(); ++it)
+            {
+                if (crosses(it->first)) available += it->second.amount;
+            }
+        }
+        if (available < order.amount)
+        {
+            result.dropped++;
+            return;
+        }
+    }
+
+    // take the best level's oldest order until the order is filled or stops crossing
+    while (order.amount > 0 && side != nullptr && !side->empty())
+    {
+        const RestingLevel& level = buy ? side->begin()->second : side->rbegin()->second;
+        if (!crosses(level.price)) break;
+        const OrderBookEntry& resting = level.head->order;
+        double amount = std::min(resting.amount, order.amount);
+        trade(order, agent, resting, amount);
+        order.amount -= amount;
+        if (order.amount < DUST) order.amount = 0;
+        double left = resting.amount - amount;
+        book.updateAmount(resting.id, left < DUST ? 0 : left); // Can remove the level
+        side = book.getLevels(opposite, order.product);
+    }
+
+    if (order.amount <= 0) return;
+    if (order.execution != OrderExecution::limit)
+    {
+        result.dropped++;
+        return;
+    }
+    unsigned int id = book.add(order);
+    if (id == 0)
+    {
+        result.dropped++; // A price or amount no book can hold
+        return;
+    }
+    if (owners.size() <= id) owners.resize(id + 1 + owners.size() / 2, 0);
+    owners[id] = agent;
+    if (lifetime > 0) schedule(clock + lifetime, SimEventKind::expire, id, agent);
+}
+
+void EventSimulator::trade(const OrderBookEntry& incoming, std::uint16_t incomingAgent,
+                           const OrderBookEntry& resting, double amount)
+{
+    OrderBookEntry sale{resting.price, amount, incoming.timestamp, incoming.product, OrderBookType::asksale};
+    result.trades++;
+    result.volume += amount;
+    if (tradeSink) tradeSink(sale);
+
+    bool buy = incoming.orderType == OrderBookType::bid;
+    std::uint16_t restingAgent = resting.id < owners.size() ? owners[resting.id] : 0;
+    if (incomingAgent != 0) notify(incomingAgent, sale, incoming, buy ? OrderBookType::bidsale : OrderBookType::asksale);
+    if (restingAgent != 0) notify(restingAgent, sale, resting, buy ? OrderBookType::asksale : OrderBookType::bidsale);
+}
+
+void EventSimulator::notify(std::uint16_t agent, const OrderBookEntry& sale, const OrderBookEntry& order, OrderBookType type)
+{
+    std::uint32_t slot = takeSlot();
+    slots[slot] = sale;
+    slots[slot].orderType = type;
+    slots[slot].username = order.username;
+    schedule(clock + agents[agent - 1].latency, SimEventKind::fill, slot, agent);
+}
+
+std::int64_t EventSimulator::toMicros(const std::string& timestamp)
+{
+    // YYYY/MM/DD HH:MM:SS[.ffffff]
+    if (timestamp.size() < 19 || timestamp[4] != '/' || timestamp[7] != '/' ||
+        timestamp[10] != ' ' || timestamp[13] != ':' || timestamp[16] != ':')
+    {
+        throw std::invalid_argument("EventSimulator: bad timestamp " + timestamp);
+    }
+    std::int64_t days = daysFromCivil(digits(timestamp, 0, 4), digits(timestamp, 5, 2), digits(timestamp, 8, 2));
+    std::int64_t seconds = days * 86400 + digits(timestamp, 11, 2) * 3600 +
+                           digits(timestamp, 14, 2) * 60 + digits(timestamp, 17, 2);
+    std::int64_t micros = 0;
+    if (timestamp.size() > 20 && timestamp[19] == '.')
+    {
+        std::size_t n = std::min<std::size_t>(timestamp.size() - 20, 6);
+        micros = digits(timestamp, 20, n);
+        for (std::size_t i = n; i < 6; ++i) micros *= 10;
+    }
+    return seconds * 1000000 + micros;
+}
+
+std::string EventSimulator::toTimestamp(std::int64_t micros)
+{
+    std::int64_t seconds = micros >= 0 ? micros / 1000000 : (micros - 999999) / 1000000;
+    std::int64_t days = seconds >= 0 ? seconds / 86400 : (seconds - 86399) / 86400;
+    std::int64_t rest = seconds - days * 86400;
+    int y;
+    unsigned int m, d;
+    civilFromDays(days, y, m, d);
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%04d/%02u/%02u %02d:%02d:%02d.%06d",
+                  y, m, d, static_cast<int>(rest / 3600), static_cast<int>(rest / 60 % 60),
+                  static_cast<int>(rest % 60), static_cast<int>(micros - seconds * 1000000));
+    return buffer;
+}
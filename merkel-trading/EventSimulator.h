@@ -0,0 +1,129 @@
+#pragma once
+#include "EventScheduler.h"
+#include "OrderBookEntry.h"
+#include "RestingOrders.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class EventSimulator;
+
+/** A trader inside a continuous time simulation */
+class SimAgent
+{
+    public:
+        virtual ~SimAgent() {}
+        /** called once when the run starts and again at every time asked for with wakeAt */
+        virtual void onWakeup(EventSimulator& sim, unsigned int agent) = 0;
+        /** one of the agent's orders traded, heard of the agent's latency after the trade.
+         *  fill is the sale with the username of the agent's order, as a bidsale or an asksale */
+        virtual void onFill(EventSimulator& sim, unsigned int agent, const OrderBookEntry& fill)
+        {
+            (void)sim; (void)agent; (void)fill;
+        }
+};
+
+/** What came out of one continuous run */
+struct SimulationResult
+{
+    std::uint64_t events = 0;
+    std::uint64_t trades = 0;
+    double volume = 0;         // sum of the trade amounts over all products
+    std::uint64_t expired = 0; // resting orders taken out when their lifetime ran out
+    std::uint64_t dropped = 0; // unfilled market, IOC and FOK orders, and orders the book refuses
+    std::int64_t start = 0;    // time of the first and last event, in microseconds
+    std::int64_t end = 0;
+};
+
+/**
+ * Continuous time replay. Instead of gathering the orders of a timestamp
+ * into a frame and running a call auction, every order arrives on its own
+ * at its own microsecond timestamp and trades straight away against the
+ * resting orders of the other side, best price first and oldest first on a
+ * level, at the resting order's price. What is left of a limit order rests,
+ * what is left of a market, IOC or FOK order is dropped.
+ *
+ * Everything that happens is an event in an EventScheduler. Dataset orders
+ * are fed in one at a time as the clock reaches them, and SimAgents submit
+ * orders that arrive, and hear of their fills, their latency later. Events
+ * and the slots holding orders in flight are allocated up front, the loop
+ * itself only allocates when the book grows, or when agents leave more
+ * expiries waiting than the scheduler was sized for.
+ */
+class EventSimulator
+{
+    public:
+        /** orders is kept by reference and replayed in timestamp order, file order within a
+         *  timestamp. Dataset limit orders rest until filled, or for datasetLifetime microseconds
+         *  when that is above 0. capacity bounds the agent orders and fills in flight, the
+         *  scheduler gets room for those, the next dataset order and one expiry per dataset
+         *  order up front and only grows if agent expiries pile up beyond that */
+        EventSimulator(const std::vector<OrderBookEntry>& orders,
+                       std::int64_t datasetLifetime = 0,
+                       std::size_t capacity = 1 << 16);
+
+        /** add an agent, its orders arrive latency microseconds after they are submitted.
+         *  Returns the agent's number. Call before run() */
+        unsigned int addAgent(SimAgent& agent, std::int64_t latency);
+
+        /** replay until no events are left, calling onTrade with every trade */
+        SimulationResult run(std::function<void(const OrderBookEntry&)> onTrade = nullptr);
+
+        /** for agents: the simulation time in microseconds since the epoch */
+        std::int64_t now() const { return clock; }
+        /** for agents: send an order, it arrives after the agent's latency. A limit order
+         *  left resting is taken out after lifetime microseconds if that is above 0 */
+        void submit(unsigned int agent, const OrderBookEntry& order, std::int64_t lifetime = 0);
+        /** for agents: call onWakeup again at time. Times after the last dataset order are
+         *  ignored, so agents that keep asking still let the run end */
+        void wakeAt(unsigned int agent, std::int64_t time);
+        /** arrival time of the last dataset order */
+        std::int64_t getEndTime() const { return endTime; }
+        /** the resting orders of every product */
+        const RestingOrders& getBook() const { return book; }
+        /** best price on one side of a product, false if that side is empty */
+        bool bestPrice(OrderBookType type, const std::string& product, double& price) const;
+
+        /** "2020/03/17 17:01:24.884492" to microseconds since the epoch, throws
+         *  std::invalid_argument if it is not in that form */
+        static std::int64_t toMicros(const std::string& timestamp);
+        /** microseconds since the epoch in the dataset's timestamp form */
+        static std::string toTimestamp(std::int64_t micros);
+
+    private:
+        struct Agent
+        {
+            SimAgent* agent;
+            std::int64_t latency;
+        };
+
+        /** a free slot for an order or fill in flight. Throws std::length_error if none is left */
+        std::uint32_t takeSlot();
+        void schedule(std::int64_t time, SimEventKind kind, std::uint32_t ref, std::uint16_t agent);
+        /** match an order as it arrives, then rest what is left of it. agent is 0 for the dataset,
+         *  agent number + 1 otherwise */
+        void arrive(OrderBookEntry& order, std::uint16_t agent, std::int64_t lifetime);
+        void trade(const OrderBookEntry& incoming, std::uint16_t incomingAgent,
+                   const OrderBookEntry& resting, double amount);
+        /** queue a fill of order for its agent */
+        void notify(std::uint16_t agent, const OrderBookEntry& sale, const OrderBookEntry& order, OrderBookType type);
+
+        const std::vector<OrderBookEntry>& orders;
+        std::vector<std::int64_t> times;        // Arrival time of each dataset order
+        std::vector<std::uint32_t> replayOrder; // Dataset order indices by arrival
+        std::int64_t datasetLifetime;
+        std::int64_t endTime;
+
+        EventScheduler scheduler;
+        std::vector<OrderBookEntry> slots; // Agent orders and fills in flight
+        std::vector<std::int64_t> slotLifetime;
+        std::vector<std::uint32_t> freeSlots;
+
+        std::vector<Agent> agents;
+        RestingOrders book;
+        std::vector<std::uint16_t> owners; // Agent number + 1 by resting order id, 0 for the dataset
+        std::int64_t clock;
+        SimulationResult result;
+        std::function<void(const OrderBookEntry&)> tradeSink;
+};
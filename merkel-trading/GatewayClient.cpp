@@ -0,0 +1,115 @@
+#include "GatewayClient.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+GatewayClient::GatewayClient(const std::string& socketPath)
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path))
+    {
+        throw std::runtime_error("GatewayClient: socket path too long: " + socketPath);
+    }
+    std::strcpy(addr.sun_path, socketPath.c_str());
+    fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+    {
+        std::string error = std::strerror(errno);
+        if (fd >= 0) ::close(fd);
+        throw std::runtime_error("GatewayClient: cannot connect to " + socketPath + ": " + error);
+    }
+}
+
+GatewayClient::~GatewayClient()
+{
+    ::close(fd);
+}
+
+void GatewayClient::newOrder(std::uint32_t clientTag, const std::string& product, bool bid,
+                             double price, double amount, std::uint8_t execution)
+{
+    GatewayMessage m{};
+    m.type = GatewayMessageType::newOrder;
+    m.side = bid ? 0 : 1;
+    m.execution = execution;
+    m.clientTag = clientTag;
+    m.setProduct(product);
+    m.price = price;
+    m.amount = amount;
+    queue(m);
+}
+
+void GatewayClient::cancel(std::uint32_t clientTag, std::uint32_t orderId)
+{
+    GatewayMessage m{};
+    m.type = GatewayMessageType::cancel;
+    m.clientTag = clientTag;
+    m.orderId = orderId;
+    queue(m);
+}
+
+void GatewayClient::replace(std::uint32_t clientTag, std::uint32_t orderId, double price, double amount)
+{
+    GatewayMessage m{};
+    m.type = GatewayMessageType::replace;
+    m.clientTag = clientTag;
+    m.orderId = orderId;
+    m.price = price;
+    m.amount = amount;
+    queue(m);
+}
+
+void GatewayClient::nextFrame()
+{
+    GatewayMessage m{};
+    m.type = GatewayMessageType::nextFrame;
+    queue(m);
+}
+
+void GatewayClient::queue(const GatewayMessage& m)
+{
+    const char* bytes = reinterpret_cast<const char*>(&m);
+    pending.insert(pending.end(), bytes, bytes + sizeof(m));
+}
+
+void GatewayClient::flush()
+{
+    std::size_t sent = 0;
+    while (sent < pending.size())
+    {
+        ssize_t n = ::write(fd, pending.data() + sent, pending.size() - sent);
+        if (n < 0)
+        {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("GatewayClient: write failed: ") + std::strerror(errno));
+        }
+        sent += n;
+    }
+    pending.clear();
+}
+
+bool GatewayClient::receive(std::vector<GatewayMessage>& out)
+{
+    char buffer[64 * 1024];
+    while (true)
+    {
+        ssize_t got = ::read(fd, buffer, sizeof(buffer));
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+
+        partial.insert(partial.end(), buffer, buffer + got);
+        std::size_t whole = partial.size() / sizeof(GatewayMessage);
+        for (std::size_t i = 0; i < whole; ++i)
+        {
+            GatewayMessage m;
+            std::memcpy(&m, partial.data() + i * sizeof(GatewayMessage), sizeof(GatewayMessage));
+            out.push_back(m);
+        }
+        partial.erase(partial.begin(), partial.begin() + whole * sizeof(GatewayMessage));
+        if (whole > 0) return true;
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "GatewayProtocol.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Blocking client side of the order gateway, for strategy processes.
+ * Messages are buffered and only written on flush(), so a client can
+ * send thousands of orders with one system call.
+ */
+class GatewayClient
+{
+    public:
+        /** connect to a gateway socket, throws std::runtime_error on failure */
+        GatewayClient(const std::string& socketPath);
+        ~GatewayClient();
+        GatewayClient(const GatewayClient&) = delete;
+        GatewayClient& operator=(const GatewayClient&) = delete;
+
+        void newOrder(std::uint32_t clientTag, const std::string& product, bool bid,
+                      double price, double amount, std::uint8_t execution = 0);
+        void cancel(std::uint32_t clientTag, std::uint32_t orderId);
+        void replace(std::uint32_t clientTag, std::uint32_t orderId, double price, double amount);
+        void nextFrame();
+
+        /** write everything queued so far */
+        void flush();
+
+        /** append whatever messages have arrived to out, waiting for at least one.
+         *  Returns false once the gateway has closed the connection */
+        bool receive(std::vector<GatewayMessage>& out);
+
+    private:
+        void queue(const GatewayMessage& m);
+
+        int fd;
+        std::vector<char> pending; // Written on flush
+        std::vector<char> partial; // Start of a message not fully read yet
+};
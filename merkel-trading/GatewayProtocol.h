@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+/**
+ * Wire format of the order gateway. Every message in both directions is one
+ * fixed size GatewayMessage in host byte order, the socket only ever
+ * connects processes on the same machine.
+ *
+ * Client to gateway:
+ *  - newOrder: side, execution, product, price, amount, clientTag
+ *  - cancel:   orderId
+ *  - replace:  orderId, price, amount
+ *  - nextFrame: match the current frame and move the book to the next one
+ *
+ * Gateway to client:
+ *  - ack:    the request with clientTag was accepted, orderId is set for new orders
+ *  - reject: the request with clientTag was refused, reason says why
+ *  - fill:   orderId traded amount at price
+ *  - frame:  the book moved on, orderId holds the new frame number
+ */
+enum class GatewayMessageType : std::uint8_t
+{
+    newOrder = 1,
+    cancel = 2,
+    replace = 3,
+    nextFrame = 4,
+    ack = 16,
+    reject = 17,
+    fill = 18,
+    frame = 19,
+    disconnect = 255 // Never on the wire, tells the matching side a client went away
+};
+
+enum class GatewayReject : std::uint8_t
+{
+    none = 0,
+    unknownOrder = 1,
+    badMessage = 2 // Bad side or execution, unknown product, price or amount not finite or not above zero
+};
+
+struct GatewayMessage
+{
+    GatewayMessageType type;
+    std::uint8_t side;       // 0 bid, 1 ask
+    std::uint8_t execution;  // OrderExecution as a number
+    GatewayReject reason;
+    std::uint32_t clientTag; // Chosen by the client, echoed in the ack or reject
+    std::uint32_t orderId;
+    std::uint32_t reserved;
+    char product[16];        // Zero padded, not always terminated
+    double price;
+    double amount;
+
+    std::string getProduct() const { return std::string(product, strnlen(product, sizeof(product))); }
+    void setProduct(const std::string& name)
+    {
+        std::memset(product, 0, sizeof(product));
+        std::memcpy(product, name.data(), name.size() < sizeof(product) ? name.size() : sizeof(product));
+    }
+};
+
+static_assert(sizeof(GatewayMessage) == 48, "GatewayMessage is a fixed 48 byte record");
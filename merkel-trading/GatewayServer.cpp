@@ -0,0 +1,216 @@
+#include "GatewayServer.h"
+#include "MatchingEngine.h"
+#include <cmath>
+#include <thread>
+
+namespace
+{
+    /** price and amount a resting order can have. NaN fails every comparison,
+     *  so it would pass a plain amount <= 0 test and then key a price level */
+    bool validPriceAndAmount(double price, double amount)
+    {
+        return std::isfinite(price) && std::isfinite(amount) && price > 0 && amount > 0;
+    }
+
+    GatewayResponse respond(std::uint32_t connection, GatewayMessageType type, const GatewayMessage& request)
+    {
+        GatewayResponse r{connection, request};
+        r.message.type = type;
+        r.message.reason = GatewayReject::none;
+        return r;
+    }
+
+    /** matching hook that turns every fill of a gateway order into a fill message for its owner */
+    struct GatewayFills
+    {
+        const std::unordered_map<unsigned int, std::uint32_t>* owners;
+        std::vector<GatewayResponse>* out;
+
+        bool watches(const OrderBookEntry& order) const { return owners->count(order.id) > 0; }
+        void onFill(OrderBookEntry& sale, const OrderBookEntry& order, OrderBookType)
+        {
+            GatewayResponse r{};
+            r.connection = owners->at(order.id);
+            r.message.type = GatewayMessageType::fill;
+            r.message.side = order.orderType == OrderBookType::bid ? 0 : 1;
+            r.message.execution = static_cast<std::uint8_t>(order.execution);
+            r.message.orderId = order.id;
+            r.message.setProduct(sale.product);
+            r.message.price = sale.price;
+            r.message.amount = sale.amount;
+            out->push_back(r);
+        }
+    };
+}
+
+GatewayServer::GatewayServer(OrderBook& book, const std::string& socketPath)
+    : book(book), gateway(socketPath), batches(64), frameNumber(0), publisher(nullptr), publishDepth(10), snapshots(nullptr)
+{
+    currentTime = book.getEarliestTime();
+    std::vector<std::string> known = book.getKnownProducts();
+    products.insert(known.begin(), known.end());
+}
+
+void GatewayServer::setPublisher(MarketDataPublisher* feed, unsigned int depth)
+{
+    publisher = feed;
+    publishDepth = depth;
+    if (publisher != nullptr) publishFrame();
+}
+
+void GatewayServer::setSnapshots(BookSnapshots* target)
+{
+    snapshots = target;
+    if (snapshots != nullptr) snapshots->publish(book.makeSnapshot(currentTime, frameNumber));
+}
+
+void GatewayServer::publishFrame()
+{
+    publisher->frameStart(frameNumber, currentTime);
+    for (const std::string& product : book.getKnownProducts())
+    {
+        publisher->levels(frameNumber, product, OrderBookType::bid,
+                          book.getDepth(OrderBookType::bid, product, currentTime, publishDepth));
+        publisher->levels(frameNumber, product, OrderBookType::ask,
+                          book.getDepth(OrderBookType::ask, product, currentTime, publishDepth));
+    }
+}
+
+void GatewayServer::run()
+{
+    std::thread matcher{[this]()
+    {
+        std::vector<GatewayRequest> batch;
+        std::vector<GatewayResponse> out;
+        while (batches.pop(batch))
+        {
+            out.clear();
+            process(batch, out);
+            gateway.send(out);
+        }
+    }};
+
+    gateway.run([this](std::vector<GatewayRequest>& batch)
+    {
+        batches.push(std::move(batch)); // Blocks when matching falls behind
+        batch.clear();
+    });
+    batches.close();
+    matcher.join();
+}
+
+void GatewayServer::stop()
+{
+    gateway.stop();
+}
+
+void GatewayServer::process(std::vector<GatewayRequest>& batch, std::vector<GatewayResponse>& out)
+{
+    for (GatewayRequest& request : batch)
+    {
+        const GatewayMessage& m = request.message;
+        clients.insert(request.connection);
+        switch (m.type)
+        {
+            case GatewayMessageType::newOrder:
+            {
+                // market orders take any price, the rest need one they can rest at
+                bool market = m.execution == static_cast<std::uint8_t>(OrderExecution::market);
+                bool valid = market ? std::isfinite(m.price) && std::isfinite(m.amount) && m.amount > 0
+                                    : validPriceAndAmount(m.price, m.amount);
+                if (m.side > 1 || m.execution > static_cast<std::uint8_t>(OrderExecution::fok) || !valid ||
+                    products.count(m.getProduct()) == 0)
+                {
+                    GatewayResponse r = respond(request.connection, GatewayMessageType::reject, m);
+                    r.message.reason = GatewayReject::badMessage;
+                    out.push_back(r);
+                    break;
+                }
+                OrderBookEntry order{m.price, m.amount, currentTime, m.getProduct(),
+                                     m.side == 0 ? OrderBookType::bid : OrderBookType::ask, "gateway"};
+                order.execution = static_cast<OrderExecution>(m.execution);
+                unsigned int id = book.insertOrder(order);
+                owners[id] = request.connection;
+                GatewayResponse r = respond(request.connection, GatewayMessageType::ack, m);
+                r.message.orderId = id;
+                out.push_back(r);
+                break;
+            }
+            case GatewayMessageType::cancel:
+            case GatewayMessageType::replace:
+            {
+                if (m.type == GatewayMessageType::replace && !validPriceAndAmount(m.price, m.amount))
+                {
+                    GatewayResponse r = respond(request.connection, GatewayMessageType::reject, m);
+                    r.message.reason = GatewayReject::badMessage;
+                    out.push_back(r);
+                    break;
+                }
+                // only the owner may touch an order
+                auto owner = owners.find(m.orderId);
+                bool done = owner != owners.end() && owner->second == request.connection &&
+                            (m.type == GatewayMessageType::cancel ? book.cancelOrder(m.orderId)
+                                                                  : book.replaceOrder(m.orderId, m.price, m.amount));
+                if (done && m.type == GatewayMessageType::cancel) owners.erase(owner);
+                GatewayResponse r = respond(request.connection, done ? GatewayMessageType::ack : GatewayMessageType::reject, m);
+                if (!done) r.message.reason = GatewayReject::unknownOrder;
+                out.push_back(r);
+                break;
+            }
+            case GatewayMessageType::nextFrame:
+                nextFrame(out);
+                break;
+            case GatewayMessageType::disconnect:
+            {
+                clients.erase(request.connection);
+                for (auto it = owners.begin(); it != owners.end();)
+                {
+                    if (it->second == request.connection)
+                    {
+                        book.cancelOrder(it->first);
+                        it = owners.erase(it);
+                    }
+                    else ++it;
+                }
+                break;
+            }
+            default:
+            {
+                GatewayResponse r = respond(request.connection, GatewayMessageType::reject, m);
+                r.message.reason = GatewayReject::badMessage;
+                out.push_back(r);
+            }
+        }
+    }
+}
+
+void GatewayServer::nextFrame(std::vector<GatewayResponse>& out)
+{
+    MatchingEngine<FifoAllocation, AskPrice, GatewayFills> engine{GatewayFills{&owners, &out}};
+    for (const std::string& product : book.getKnownProducts())
+    {
+        std::vector<OrderBookEntry> sales = book.matchWithEngine(product, currentTime, engine);
+        if (publisher != nullptr) publisher->trades(frameNumber, sales);
+    }
+    if (publisher != nullptr) publisher->frameEnd(frameNumber);
+
+    // forget orders that are filled, or takers that had their chance
+    for (auto it = owners.begin(); it != owners.end();)
+    {
+        if (book.findOrder(it->first) == nullptr) it = owners.erase(it);
+        else ++it;
+    }
+
+    currentTime = book.getNextTime(currentTime);
+    frameNumber++;
+    if (publisher != nullptr) publishFrame();
+    if (snapshots != nullptr) snapshots->publish(book.makeSnapshot(currentTime, frameNumber));
+    for (std::uint32_t client : clients)
+    {
+        GatewayResponse r{};
+        r.connection = client;
+        r.message.type = GatewayMessageType::frame;
+        r.message.orderId = frameNumber;
+        out.push_back(r);
+    }
+}
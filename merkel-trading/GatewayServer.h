@@ -0,0 +1,58 @@
+#pragma once
+#include "BookSnapshots.h"
+#include "Channel.h"
+#include "MarketDataPublisher.h"
+#include "OrderBook.h"
+#include "OrderGateway.h"
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Drives an order book from gateway clients. The calling thread runs the
+ * OrderGateway reactor, each batch it reads goes through a Channel to a
+ * matching thread that owns the book. That thread enters, cancels and
+ * replaces orders, matches a frame on nextFrame and sends back acks,
+ * rejects, fills and frame messages. Orders of a client that disconnects
+ * are cancelled. Trades and book levels can also go to a market data feed,
+ * and a snapshot of the book to BookSnapshots for in-process readers.
+ */
+class GatewayServer
+{
+    public:
+        GatewayServer(OrderBook& book, const std::string& socketPath);
+
+        /** serve clients until stop() */
+        void run();
+        /** safe from any thread */
+        void stop();
+
+        /** publish trades and the top depth levels of every frame to a market data feed,
+         *  nullptr for none. Call before run() */
+        void setPublisher(MarketDataPublisher* publisher, unsigned int depth = 10);
+        /** publish a snapshot of the book at the start of every frame, the version is the
+         *  frame number. nullptr for none. Call before run() */
+        void setSnapshots(BookSnapshots* snapshots);
+
+    private:
+        /** apply one batch of requests on the matching thread */
+        void process(std::vector<GatewayRequest>& batch, std::vector<GatewayResponse>& out);
+        /** match every product in the current frame, then move to the next one */
+        void nextFrame(std::vector<GatewayResponse>& out);
+        /** frame start and the levels of every product in the current frame */
+        void publishFrame();
+
+        OrderBook& book;
+        OrderGateway gateway;
+        Channel<std::vector<GatewayRequest>> batches;
+        std::string currentTime;
+        std::uint32_t frameNumber;
+        std::unordered_map<unsigned int, std::uint32_t> owners; // Order id to connection
+        std::set<std::uint32_t> clients;
+        std::set<std::string> products; // Known when the book opened, nothing else is traded
+        MarketDataPublisher* publisher;
+        unsigned int publishDepth;
+        BookSnapshots* snapshots;
+};
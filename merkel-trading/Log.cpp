@@ -0,0 +1,138 @@
+#include "Log.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    /** collects messages and writes them out on its own thread */
+    class LogSink
+    {
+        public:
+            LogSink() : stopping(false), busy(false)
+            {
+                writer = std::thread{[this]() { run(); }};
+            }
+
+            ~LogSink()
+            {
+                {
+                    std::lock_guard<std::mutex> lock{mutex};
+                    stopping = true;
+                }
+                wake.notify_one();
+                writer.join();
+            }
+
+            void append(const char* level, const std::string& message)
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                pending += '[';
+                pending += level;
+                pending += "] ";
+                pending += message;
+                pending += '\n';
+                if (pending.size() > 64 * 1024) wake.notify_one(); // Otherwise the writer comes by on its own
+            }
+
+            void flush()
+            {
+                std::unique_lock<std::mutex> lock{mutex};
+                wake.notify_one();
+                idle.wait(lock, [this] { return pending.empty() && !busy; });
+            }
+
+        private:
+            void run()
+            {
+                std::string writing;
+                std::unique_lock<std::mutex> lock{mutex};
+                while (true)
+                {
+                    wake.wait_for(lock, std::chrono::milliseconds(50), [this] { return !pending.empty() || stopping; });
+                    if (pending.empty())
+                    {
+                        idle.notify_all();
+                        if (stopping) return;
+                        continue;
+                    }
+                    writing.swap(pending);
+                    busy = true;
+                    lock.unlock();
+                    std::cerr.write(writing.data(), writing.size());
+                    std::cerr.flush();
+                    writing.clear();
+                    lock.lock();
+                    busy = false;
+                    idle.notify_all();
+                }
+            }
+
+            std::mutex mutex;
+            std::condition_variable wake;
+            std::condition_variable idle;
+            std::string pending;
+            bool stopping;
+            bool busy;
+            std::thread writer;
+    };
+
+    LogSink& sink()
+    {
+        static LogSink instance; // Started on the first message, drained at exit
+        return instance;
+    }
+
+    int initialLevel()
+    {
+        const char* name = std::getenv("MERKEL_LOG");
+        if (name == nullptr) return static_cast<int>(LogLevel::info);
+        try
+        {
+            return static_cast<int>(Log::parseLevel(name));
+        }
+        catch (const std::invalid_argument&)
+        {
+            return static_cast<int>(LogLevel::info);
+        }
+    }
+}
+
+std::atomic<int> Log::threshold{initialLevel()};
+
+LogLevel Log::parseLevel(const std::string& name)
+{
+    for (int l = 0; l <= static_cast<int>(LogLevel::off); ++l)
+    {
+        if (name == levelName(static_cast<LogLevel>(l))) return static_cast<LogLevel>(l);
+    }
+    throw std::invalid_argument("Log: unknown level " + name);
+}
+
+const char* Log::levelName(LogLevel level)
+{
+    switch (level)
+    {
+        case LogLevel::trace: return "trace";
+        case LogLevel::debug: return "debug";
+        case LogLevel::info: return "info";
+        case LogLevel::warn: return "warn";
+        case LogLevel::error: return "error";
+        case LogLevel::off: return "off";
+    }
+    return "off";
+}
+
+void Log::write(LogLevel level, const std::string& message)
+{
+    sink().append(levelName(level), message);
+}
+
+void Log::flush()
+{
+    sink().flush();
+}
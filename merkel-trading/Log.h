@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <sstream>
+#include <string>
+
+enum class LogLevel
+{
+    trace = 0,
+    debug = 1,
+    info = 2,
+    warn = 3,
+    error = 4,
+    off = 5
+};
+
+/** Messages below this level are compiled out, eg -DMERKEL_LOG_MIN_LEVEL=3 keeps warn and error */
+#ifndef MERKEL_LOG_MIN_LEVEL
+#define MERKEL_LOG_MIN_LEVEL 0
+#endif
+
+/**
+ * Leveled diagnostics through an asynchronous buffered sink.
+ *
+ * Use the MERKEL_LOG macros: the message is only formatted when its level
+ * passes both the compile time floor and the runtime level, so a message
+ * that is filtered out costs one branch. Messages that pass are appended
+ * to a buffer that a background thread writes to stderr, so callers never
+ * wait on the console. The runtime level starts at info, or at the level
+ * named by the MERKEL_LOG environment variable.
+ */
+class Log
+{
+    public:
+        static bool enabled(LogLevel level)
+        {
+            return static_cast<int>(level) >= MERKEL_LOG_MIN_LEVEL &&
+                   static_cast<int>(level) >= threshold.load(std::memory_order_relaxed);
+        }
+
+        static void setLevel(LogLevel level) { threshold.store(static_cast<int>(level), std::memory_order_relaxed); }
+        static LogLevel getLevel() { return static_cast<LogLevel>(threshold.load(std::memory_order_relaxed)); }
+
+        /** "trace", "debug", "info", "warn", "error" or "off", throws std::invalid_argument for anything else */
+        static LogLevel parseLevel(const std::string& name);
+        static const char* levelName(LogLevel level);
+
+        /** queue one message for the sink, use the macros instead */
+        static void write(LogLevel level, const std::string& message);
+        /** wait until everything queued has been written */
+        static void flush();
+
+    private:
+        static std::atomic<int> threshold;
+};
+
+#define MERKEL_LOG(level, message) \
+    do \
+    { \
+        if (Log::enabled(level)) \
+        { \
+            std::ostringstream merkelLogText; \
+            merkelLogText << message; \
+            Log::write(level, merkelLogText.str()); \
+        } \
+    } while (false)
+
+#define MERKEL_LOG_TRACE(message) MERKEL_LOG(LogLevel::trace, message)
+#define MERKEL_LOG_DEBUG(message) MERKEL_LOG(LogLevel::debug, message)
+#define MERKEL_LOG_INFO(message) MERKEL_LOG(LogLevel::info, message)
+#define MERKEL_LOG_WARN(message) MERKEL_LOG(LogLevel::warn, message)
+#define MERKEL_LOG_ERROR(message) MERKEL_LOG(LogLevel::error, message)
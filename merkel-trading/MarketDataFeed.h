@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+/**
+ * Layout of the shared memory market data ring, shared by
+ * MarketDataPublisher and MarketDataReader.
+ *
+ * One publisher appends fixed size records, any number of readers follow
+ * it without telling the publisher they exist. Record n lives in slot
+ * n % capacity and carries n in its sequence field once it is complete,
+ * and ~0 while it is being written. A reader that falls a whole ring
+ * behind finds newer sequence numbers in its slots and skips ahead,
+ * counting what it lost.
+ */
+enum class MarketDataKind : std::uint8_t
+{
+    frameStart = 1, // text holds the frame timestamp
+    level = 2,      // one price level of a product, depth 0 is the best
+    trade = 3,      // a sale, side is the side of the order that was filled second
+    frameEnd = 4    // every level and trade of the frame has been published
+};
+
+struct MarketDataRecord
+{
+    std::atomic<std::uint64_t> sequence;
+    std::uint32_t frame;
+    MarketDataKind kind;
+    std::uint8_t side;   // 0 bid, 1 ask
+    std::uint16_t depth;
+    std::int32_t orderCount;
+    char text[28];       // Product, or the timestamp for frameStart. Zero padded
+    double price;
+    double amount;
+
+    std::string getText() const { return std::string(text, strnlen(text, sizeof(text))); }
+};
+
+static_assert(sizeof(MarketDataRecord) == 64, "one record per cache line");
+
+struct MarketDataHeader
+{
+    char magic[8];           // "MKFEED1"
+    std::uint64_t capacity;  // Records in the ring, a power of two
+    alignas(64) std::atomic<std::uint64_t> published; // Records written so far
+};
+
+/** the records follow the header at this offset */
+const std::size_t MARKET_DATA_RECORDS_OFFSET = 128;
+static_assert(sizeof(MarketDataHeader) <= MARKET_DATA_RECORDS_OFFSET, "header fits before the records");
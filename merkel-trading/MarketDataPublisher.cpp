@@ -0,0 +1,135 @@
+#include "MarketDataPublisher.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+MarketDataPublisher::MarketDataPublisher(const std::string& name, std::size_t capacity)
+    : name(name), memory(nullptr), next(0)
+{
+    std::size_t slots = 1;
+    while (slots < capacity) slots <<= 1;
+    mask = slots - 1;
+    bytes = MARKET_DATA_RECORDS_OFFSET + slots * sizeof(MarketDataRecord);
+
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0 || ::ftruncate(fd, 0) < 0 || ::ftruncate(fd, bytes) < 0)
+    {
+        std::string error = std::strerror(errno);
+        if (fd >= 0) ::close(fd);
+        throw std::runtime_error("MarketDataPublisher: cannot create " + name + ": " + error);
+    }
+    memory = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED)
+    {
+        throw std::runtime_error("MarketDataPublisher: cannot map " + name + ": " + std::strerror(errno));
+    }
+
+    // the object was truncated to zero first, so every slot starts empty
+    header = static_cast<MarketDataHeader*>(memory);
+    records = reinterpret_cast<MarketDataRecord*>(static_cast<char*>(memory) + MARKET_DATA_RECORDS_OFFSET);
+    header->capacity = slots;
+    header->published.store(0, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < slots; ++i)
+    {
+        records[i].sequence.store(~0ull, std::memory_order_relaxed);
+    }
+    std::memcpy(header->magic, "MKFEED1", 8); // Last, readers check it before anything else
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+MarketDataPublisher::~MarketDataPublisher()
+{
+    ::munmap(memory, bytes);
+    ::shm_unlink(name.c_str());
+}
+
+template <typename Fill>
+void MarketDataPublisher::publish(Fill fill)
+{
+    MarketDataRecord& r = records[next & mask];
+    r.sequence.store(~0ull, std::memory_order_relaxed); // Mark it as being written
+    std::atomic_thread_fence(std::memory_order_release);
+    fill(r);
+    r.sequence.store(next, std::memory_order_release);
+    ++next;
+    header->published.store(next, std::memory_order_release);
+}
+
+void MarketDataPublisher::frameStart(std::uint32_t frame, const std::string& timestamp)
+{
+    publish([&](MarketDataRecord& r)
+    {
+        r.frame = frame;
+        r.kind = MarketDataKind::frameStart;
+        r.side = 0;
+        r.depth = 0;
+        r.orderCount = 0;
+        std::memset(r.text, 0, sizeof(r.text));
+        std::memcpy(r.text, timestamp.data(), std::min(timestamp.size(), sizeof(r.text)));
+        r.price = 0;
+        r.amount = 0;
+    });
+}
+
+void MarketDataPublisher::levels(std::uint32_t frame, const std::string& product, OrderBookType side,
+                                 const std::vector<PriceLevel>& levels)
+{
+    for (std::size_t i = 0; i < levels.size(); ++i)
+    {
+        publish([&](MarketDataRecord& r)
+        {
+            r.frame = frame;
+            r.kind = MarketDataKind::level;
+            r.side = side == OrderBookType::bid ? 0 : 1;
+            r.depth = static_cast<std::uint16_t>(i);
+            r.orderCount = levels[i].orderCount;
+            std::memset(r.text, 0, sizeof(r.text));
+            std::memcpy(r.text, product.data(), std::min(product.size(), sizeof(r.text)));
+            r.price = levels[i].price;
+            r.amount = levels[i].amount;
+        });
+    }
+}
+
+void MarketDataPublisher::trades(std::uint32_t frame, const std::vector<OrderBookEntry>& sales)
+{
+    for (const OrderBookEntry& sale : sales)
+    {
+        publish([&](MarketDataRecord& r)
+        {
+            r.frame = frame;
+            r.kind = MarketDataKind::trade;
+            r.side = sale.orderType == OrderBookType::bidsale ? 0 : 1;
+            r.depth = 0;
+            r.orderCount = 1;
+            std::memset(r.text, 0, sizeof(r.text));
+            std::memcpy(r.text, sale.product.data(), std::min(sale.product.size(), sizeof(r.text)));
+            r.price = sale.price;
+            r.amount = sale.amount;
+        });
+    }
+}
+
+void MarketDataPublisher::frameEnd(std::uint32_t frame)
+{
+    publish([&](MarketDataRecord& r)
+    {
+        r.frame = frame;
+        r.kind = MarketDataKind::frameEnd;
+        r.side = 0;
+        r.depth = 0;
+        r.orderCount = 0;
+        std::memset(r.text, 0, sizeof(r.text));
+        r.price = 0;
+        r.amount = 0;
+    });
+}
+
+std::uint64_t MarketDataPublisher::getPublished() const
+{
+    return next;
+}
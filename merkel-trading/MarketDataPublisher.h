@@ -0,0 +1,46 @@
+#pragma once
+#include "MarketDataFeed.h"
+#include "OrderBookEntry.h"
+#include "PriceLevel.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Writes market data into a POSIX shared memory ring for readers in other
+ * processes. Publishing is a few stores into mapped memory, no system
+ * call and no lock, and it never waits for readers.
+ */
+class MarketDataPublisher
+{
+    public:
+        /** create (or take over) shared memory object name, eg "/merkel-feed".
+         *  capacity is rounded up to a power of two. Throws std::runtime_error on failure */
+        MarketDataPublisher(const std::string& name, std::size_t capacity = 1 << 16);
+        ~MarketDataPublisher();
+        MarketDataPublisher(const MarketDataPublisher&) = delete;
+        MarketDataPublisher& operator=(const MarketDataPublisher&) = delete;
+
+        void frameStart(std::uint32_t frame, const std::string& timestamp);
+        /** the levels of one side of a product, best first */
+        void levels(std::uint32_t frame, const std::string& product, OrderBookType side,
+                    const std::vector<PriceLevel>& levels);
+        /** every sale of a frame */
+        void trades(std::uint32_t frame, const std::vector<OrderBookEntry>& sales);
+        void frameEnd(std::uint32_t frame);
+
+        std::uint64_t getPublished() const;
+
+    private:
+        /** claim the next slot, fill it with fill(record) and make it visible */
+        template <typename Fill>
+        void publish(Fill fill);
+
+        std::string name;
+        void* memory;
+        std::size_t bytes;
+        MarketDataHeader* header;
+        MarketDataRecord* records;
+        std::uint64_t mask;
+        std::uint64_t next; // Only this process writes, so a plain counter
+};
@@ -0,0 +1,79 @@
+#include "MarketDataReader.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MarketDataReader::MarketDataReader(const std::string& name, bool fromStart) : position(0), dropped(0)
+{
+    int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    struct stat info;
+    if (fd < 0 || ::fstat(fd, &info) < 0 || static_cast<std::size_t>(info.st_size) < MARKET_DATA_RECORDS_OFFSET)
+    {
+        if (fd >= 0) ::close(fd);
+        throw std::runtime_error("MarketDataReader: no market data feed " + name);
+    }
+    bytes = info.st_size;
+    memory = ::mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED)
+    {
+        throw std::runtime_error("MarketDataReader: cannot map " + name + ": " + std::strerror(errno));
+    }
+
+    header = static_cast<const MarketDataHeader*>(memory);
+    records = reinterpret_cast<const MarketDataRecord*>(static_cast<const char*>(memory) + MARKET_DATA_RECORDS_OFFSET);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (std::memcmp(header->magic, "MKFEED1", 8) != 0 ||
+        MARKET_DATA_RECORDS_OFFSET + header->capacity * sizeof(MarketDataRecord) > bytes)
+    {
+        ::munmap(memory, bytes);
+        throw std::runtime_error("MarketDataReader: " + name + " is not a market data feed");
+    }
+    mask = header->capacity - 1;
+
+    std::uint64_t published = header->published.load(std::memory_order_acquire);
+    if (!fromStart) position = published;
+    else position = published > header->capacity ? published - header->capacity : 0;
+}
+
+MarketDataReader::~MarketDataReader()
+{
+    ::munmap(memory, bytes);
+}
+
+bool MarketDataReader::next(MarketDataRecord& out)
+{
+    // a record lost to the publisher is skipped, try the one after it
+    while (true)
+    {
+        std::uint64_t expected = position;
+        PollResult result = poll([&](const MarketDataRecord& r)
+        {
+            out.frame = r.frame;
+            out.kind = r.kind;
+            out.side = r.side;
+            out.depth = r.depth;
+            out.orderCount = r.orderCount;
+            std::memcpy(out.text, r.text, sizeof(out.text));
+            out.price = r.price;
+            out.amount = r.amount;
+            out.sequence.store(expected, std::memory_order_relaxed);
+        });
+        if (result == PollResult::none) return false;
+        if (result == PollResult::read) return true;
+    }
+}
+
+void MarketDataReader::skipAhead()
+{
+    // leave some room, the publisher is still going
+    std::uint64_t published = header->published.load(std::memory_order_acquire);
+    std::uint64_t oldest = published > header->capacity / 2 ? published - header->capacity / 2 : 0;
+    if (oldest <= position) oldest = position + 1;
+    dropped += oldest - position;
+    position = oldest;
+}
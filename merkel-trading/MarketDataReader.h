@@ -0,0 +1,69 @@
+#pragma once
+#include "MarketDataFeed.h"
+#include <cstdint>
+#include <string>
+
+/**
+ * Follows a MarketDataPublisher ring from another process. Records are
+ * read in place in the shared memory, nothing is copied through the
+ * kernel. Readers never write to the ring, so any number can attach
+ * without the publisher noticing.
+ */
+class MarketDataReader
+{
+    public:
+        /** attach to a ring. fromStart reads everything still in the ring, otherwise only
+         *  records published from now on. Throws std::runtime_error if the ring is missing */
+        MarketDataReader(const std::string& name, bool fromStart = false);
+        ~MarketDataReader();
+        MarketDataReader(const MarketDataReader&) = delete;
+        MarketDataReader& operator=(const MarketDataReader&) = delete;
+
+        enum class PollResult
+        {
+            none, // Nothing new has been published
+            read, // fn saw a complete record
+            lost  // The publisher overwrote the record, whatever fn did with it must be thrown away
+        };
+
+        /** call fn(const MarketDataRecord&) on the next record in place. After a loss the
+         *  reader skips ahead and counts the records it missed in getDropped() */
+        template <typename Fn>
+        PollResult poll(Fn fn)
+        {
+            if (header->published.load(std::memory_order_acquire) <= position) return PollResult::none;
+            const MarketDataRecord& r = records[position & mask];
+            if (r.sequence.load(std::memory_order_acquire) != position)
+            {
+                skipAhead();
+                return PollResult::lost;
+            }
+            fn(r);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (r.sequence.load(std::memory_order_relaxed) != position)
+            {
+                skipAhead(); // Overwritten while fn was reading it
+                return PollResult::lost;
+            }
+            ++position;
+            return PollResult::read;
+        }
+
+        /** copy the next record out, false if nothing new has been published */
+        bool next(MarketDataRecord& out);
+
+        std::uint64_t getPosition() const { return position; }
+        std::uint64_t getDropped() const { return dropped; }
+
+    private:
+        /** lapped by the publisher: jump to the oldest record still in the ring */
+        void skipAhead();
+
+        void* memory;
+        std::size_t bytes;
+        const MarketDataHeader* header;
+        const MarketDataRecord* records;
+        std::uint64_t mask;
+        std::uint64_t position;
+        std::uint64_t dropped;
+};
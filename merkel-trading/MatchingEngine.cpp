@@ -0,0 +1,57 @@
+#include "MatchingEngine.h"
+
+namespace
+{
+    template <typename Allocation>
+    MatchFunction selectPrice(TradePriceRule price)
+    {
+        switch (price)
+        {
+            case TradePriceRule::bidPrice: return &MatchingEngine<Allocation, BidPrice>::matchFrame;
+            case TradePriceRule::midPrice: return &MatchingEngine<Allocation, MidPrice>::matchFrame;
+            default: return &MatchingEngine<Allocation, AskPrice>::matchFrame;
+        }
+    }
+}
+
+MatchFunction MatchingRules::select(AllocationRule allocation, TradePriceRule price)
+{
+    switch (allocation)
+    {
+        case AllocationRule::proRata: return selectPrice<ProRataAllocation>(price);
+        case AllocationRule::sizePriority: return selectPrice<SizePriorityAllocation>(price);
+        default: return selectPrice<FifoAllocation>(price);
+    }
+}
+
+bool MatchingRules::parse(const std::string& text, AllocationRule& allocation, TradePriceRule& price)
+{
+    std::string::size_type slash = text.find('/');
+    std::string a = text.substr(0, slash);
+    std::string p = slash == std::string::npos ? "ask" : text.substr(slash + 1);
+
+    AllocationRule newAllocation;
+    if (a == "fifo") newAllocation = AllocationRule::fifo;
+    else if (a == "prorata") newAllocation = AllocationRule::proRata;
+    else if (a == "size") newAllocation = AllocationRule::sizePriority;
+    else return false;
+
+    TradePriceRule newPrice;
+    if (p == "ask") newPrice = TradePriceRule::askPrice;
+    else if (p == "bid") newPrice = TradePriceRule::bidPrice;
+    else if (p == "mid") newPrice = TradePriceRule::midPrice;
+    else return false;
+
+    allocation = newAllocation;
+    price = newPrice;
+    return true;
+}
+
+std::string MatchingRules::toString(AllocationRule allocation, TradePriceRule price)
+{
+    std::string text = allocation == AllocationRule::proRata ? "prorata"
+                     : allocation == AllocationRule::sizePriority ? "size" : "fifo";
+    text += price == TradePriceRule::bidPrice ? "/bid"
+          : price == TradePriceRule::midPrice ? "/mid" : "/ask";
+    return text;
+}
@@ -0,0 +1,340 @@
+#pragma once
+#include "OrderBookEntry.h"
+#include "RestingOrders.h"
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Matching of one frame, specialised at compile time on three policies:
+ *
+ *  - Allocation: how an ask is shared out among the bids of the best price
+ *    level. Has allocate(level, count, remaining, fill) which calls
+ *    fill(i, amount) for every bid i of the level that takes part.
+ *  - TradePrice: static price(ask, bid), the price a fill happens at.
+ *  - Notify: which orders want to hear about their fills. watches(order)
+ *    is asked once per order before matching, onFill(sale, order, type) is
+ *    called for every fill of a watched order and may relabel the sale.
+ *
+ * Each combination is its own loop, no policy is looked up per fill.
+ * Market, IOC and FOK orders sweep the book first, then asks are taken
+ * lowest price first, each one against the best bid level until it is
+ * filled or nothing crosses.
+ */
+
+/** price-time priority, the first order on a level is filled first */
+struct FifoAllocation
+{
+    template <typename Fill>
+    void allocate(OrderBookEntry* level, std::size_t count, double remaining, Fill fill)
+    {
+        for (std::size_t i = 0; i < count && remaining > 0; ++i)
+        {
+            if (level[i].amount <= 0) continue;
+            double take = std::min(level[i].amount, remaining);
+            remaining -= take;
+            fill(i, take);
+        }
+    }
+};
+
+/** every order on a level gets a share of the ask in proportion to its size */
+struct ProRataAllocation
+{
+    template <typename Fill>
+    void allocate(OrderBookEntry* level, std::size_t count, double remaining, Fill fill)
+    {
+        double total = 0;
+        std::size_t last = count;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (level[i].amount <= 0) continue;
+            total += level[i].amount;
+            last = i;
+        }
+        if (total <= 0) return;
+        double share = remaining < total ? remaining / total : 1.0;
+        for (std::size_t i = 0; i < count && remaining > 0; ++i)
+        {
+            if (level[i].amount <= 0) continue;
+            // the last order takes what is left so rounding does not strand any amount
+            double take = i == last ? std::min(level[i].amount, remaining)
+                                    : std::min(level[i].amount * share, remaining);
+            if (take <= 0) continue;
+            remaining -= take;
+            fill(i, take);
+        }
+    }
+};
+
+/** the largest order on a level is filled first, ties keep time priority */
+struct SizePriorityAllocation
+{
+    template <typename Fill>
+    void allocate(OrderBookEntry* level, std::size_t count, double remaining, Fill fill)
+    {
+        order.clear();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (level[i].amount > 0) order.push_back(i);
+        }
+        std::stable_sort(order.begin(), order.end(), [level](std::size_t a, std::size_t b)
+        {
+            return level[a].amount > level[b].amount;
+        });
+        for (std::size_t i : order)
+        {
+            if (remaining <= 0) break;
+            double take = std::min(level[i].amount, remaining);
+            remaining -= take;
+            fill(i, take);
+        }
+    }
+
+    std::vector<std::size_t> order; // Reused between levels
+};
+
+/** trade at the resting ask */
+struct AskPrice
+{
+    static double price(const OrderBookEntry& ask, const OrderBookEntry&) { return ask.price; }
+};
+
+/** trade at the bid */
+struct BidPrice
+{
+    static double price(const OrderBookEntry&, const OrderBookEntry& bid) { return bid.price; }
+};
+
+/** trade halfway between the ask and the bid */
+struct MidPrice
+{
+    static double price(const OrderBookEntry& ask, const OrderBookEntry& bid) { return (ask.price + bid.price) / 2; }
+};
+
+/** marks the fills of the simulated user, as bidsale or asksale with the user's name.
+ *  When the user is on both sides the sale counts as an asksale */
+struct UserSales
+{
+    bool watches(const OrderBookEntry& order) const { return order.username == "simuser"; }
+    void onFill(OrderBookEntry& sale, const OrderBookEntry& order, OrderBookType type)
+    {
+        sale.username = order.username;
+        sale.orderType = type;
+    }
+};
+
+/** nobody is told, every fill is a plain asksale */
+struct NoNotify
+{
+    bool watches(const OrderBookEntry&) const { return false; }
+    void onFill(OrderBookEntry&, const OrderBookEntry&, OrderBookType) {}
+};
+
+template <typename Allocation, typename TradePrice, typename Notify = UserSales>
+class MatchingEngine
+{
+    public:
+        explicit MatchingEngine(Notify notify = Notify{}) : notify(notify) {}
+
+        /** match the asks and bids of one frame and return the sales. Resting orders among
+         *  them (id != 0) get their remaining amount written back to overlay.
+         *  Market, IOC and FOK orders are taken out first and sweep the limit orders
+         *  at the resting prices, dataset takers first, then user takers by id. They
+         *  never join the auction and whatever is left of them is dropped */
+        std::vector<OrderBookEntry> match(std::vector<OrderBookEntry>& asks,
+                                          std::vector<OrderBookEntry>& bids,
+                                          const std::string& product,
+                                          const std::string& timestamp,
+                                          RestingOrders& overlay)
+        {
+            std::vector<OrderBookEntry> sales;
+
+            std::vector<OrderBookEntry> takers;
+            takeTakers(bids, takers);
+            takeTakers(asks, takers);
+
+            // stable so that orders on the same price keep their time priority
+            std::stable_sort(asks.begin(), asks.end(), OrderBookEntry::compareByPriceAsc);
+            std::stable_sort(bids.begin(), bids.end(), OrderBookEntry::compareByPriceDesc);
+
+            // who is told about a fill is decided once per order, not once per fill
+            std::vector<char> askWatched(asks.size()), bidWatched(bids.size());
+            for (std::size_t a = 0; a < asks.size(); ++a) askWatched[a] = notify.watches(asks[a]);
+            for (std::size_t b = 0; b < bids.size(); ++b) bidWatched[b] = notify.watches(bids[b]);
+
+            std::size_t firstAsk = 0; // Orders before these are used up
+            std::size_t firstBid = 0;
+            if (!takers.empty())
+            {
+                std::stable_sort(takers.begin(), takers.end(), [](const OrderBookEntry& a, const OrderBookEntry& b)
+                {
+                    return a.id < b.id;
+                });
+                for (OrderBookEntry& taker : takers)
+                {
+                    bool watched = notify.watches(taker);
+                    bool market = taker.execution == OrderExecution::market;
+                    if (taker.orderType == OrderBookType::bid)
+                    {
+                        auto crosses = [&](double price) { return market || price <= taker.price; };
+                        if (taker.execution == OrderExecution::fok && available(asks, firstAsk, crosses) < taker.amount) continue;
+                        sweep(asks, firstAsk, taker.amount, crosses, [&](std::size_t a, double amount)
+                        {
+                            record(sales, asks[a], askWatched[a], taker, watched, asks[a].price, amount, product, timestamp);
+                        });
+                    }
+                    else
+                    {
+                        auto crosses = [&](double price) { return market || price >= taker.price; };
+                        if (taker.execution == OrderExecution::fok && available(bids, firstBid, crosses) < taker.amount) continue;
+                        sweep(bids, firstBid, taker.amount, crosses, [&](std::size_t b, double amount)
+                        {
+                            record(sales, taker, watched, bids[b], bidWatched[b], bids[b].price, amount, product, timestamp);
+                        });
+                    }
+                }
+            }
+
+            // then the call auction: asks lowest first, each against the best bids that cross it
+            firstBid = 0;
+            for (std::size_t a = firstAsk; a < asks.size(); ++a)
+            {
+                OrderBookEntry& ask = asks[a];
+                if (ask.amount <= 0) continue;
+                auto crosses = [&](double price) { return price >= ask.price; };
+                sweep(bids, firstBid, ask.amount, crosses, [&](std::size_t b, double amount)
+                {
+                    record(sales, ask, askWatched[a], bids[b], bidWatched[b],
+                           TradePrice::price(ask, bids[b]), amount, product, timestamp);
+                });
+            }
+
+            // Write what is left of the resting orders back to the book
+            for (OrderBookEntry& ask : asks)
+            {
+                if (ask.id != 0) overlay.updateAmount(ask.id, ask.amount);
+            }
+            for (OrderBookEntry& bid : bids)
+            {
+                if (bid.id != 0) overlay.updateAmount(bid.id, bid.amount);
+            }
+            for (OrderBookEntry& taker : takers)
+            {
+                if (taker.id != 0) overlay.updateAmount(taker.id, 0); // Takers never rest
+            }
+            return sales;
+        }
+
+        /** match with a default constructed engine, usable as a MatchFunction */
+        static std::vector<OrderBookEntry> matchFrame(std::vector<OrderBookEntry>& asks,
+                                                      std::vector<OrderBookEntry>& bids,
+                                                      const std::string& product,
+                                                      const std::string& timestamp,
+                                                      RestingOrders& overlay)
+        {
+            MatchingEngine engine;
+            return engine.match(asks, bids, product, timestamp, overlay);
+        }
+
+        Notify& getNotify() { return notify; }
+
+    private:
+        /** move the market, IOC and FOK orders out of orders */
+        static void takeTakers(std::vector<OrderBookEntry>& orders, std::vector<OrderBookEntry>& takers)
+        {
+            auto limits = std::stable_partition(orders.begin(), orders.end(), [](const OrderBookEntry& e)
+            {
+                return e.execution == OrderExecution::limit;
+            });
+            takers.insert(takers.end(), limits, orders.end());
+            orders.erase(limits, orders.end());
+        }
+
+        /** amount on a sorted side at prices that cross */
+        template <typename Crosses>
+        static double available(const std::vector<OrderBookEntry>& side, std::size_t first, Crosses crosses)
+        {
+            double total = 0;
+            for (std::size_t i = first; i < side.size() && crosses(side[i].price); ++i)
+            {
+                if (side[i].amount > 0) total += side[i].amount;
+            }
+            return total;
+        }
+
+        /** fill amount from a sorted side, one price level at a time, until it is used up
+         *  or the next level does not cross. fill(i, amount) is told about every fill */
+        template <typename Crosses, typename Fill>
+        void sweep(std::vector<OrderBookEntry>& side, std::size_t& first, double& amount, Crosses crosses, Fill fill)
+        {
+            while (amount > 0)
+            {
+                while (first < side.size() && side[first].amount <= 0) ++first;
+                if (first == side.size() || !crosses(side[first].price)) break; // Nothing crosses
+
+                // the best level is every order on the best price
+                std::size_t levelEnd = first + 1;
+                while (levelEnd < side.size() && side[levelEnd].price == side[first].price) ++levelEnd;
+
+                std::size_t levelBegin = first;
+                allocation.allocate(side.data() + levelBegin, levelEnd - levelBegin, amount,
+                                    [&](std::size_t i, double take)
+                {
+                    fill(levelBegin + i, take);
+                    side[levelBegin + i].amount -= take;
+                    amount -= take;
+                });
+                if (amount < 1e-12) amount = 0; // Pro-rata shares can leave dust
+            }
+        }
+
+        void record(std::vector<OrderBookEntry>& sales,
+                    const OrderBookEntry& ask, bool askWatched,
+                    const OrderBookEntry& bid, bool bidWatched,
+                    double price, double amount,
+                    const std::string& product, const std::string& timestamp)
+        {
+            OrderBookEntry sale{price, amount, timestamp, product, OrderBookType::asksale};
+            if (bidWatched) notify.onFill(sale, bid, OrderBookType::bidsale);
+            if (askWatched) notify.onFill(sale, ask, OrderBookType::asksale);
+            sales.push_back(sale);
+        }
+
+        Allocation allocation;
+        Notify notify;
+};
+
+enum class AllocationRule
+{
+    fifo,
+    proRata,
+    sizePriority
+};
+
+enum class TradePriceRule
+{
+    askPrice,
+    bidPrice,
+    midPrice
+};
+
+/** a matching engine chosen at run time, one call per frame */
+typedef std::vector<OrderBookEntry> (*MatchFunction)(std::vector<OrderBookEntry>& asks,
+                                                     std::vector<OrderBookEntry>& bids,
+                                                     const std::string& product,
+                                                     const std::string& timestamp,
+                                                     RestingOrders& overlay);
+
+/** picks the specialised engine for a pair of rules, all with UserSales notification */
+class MatchingRules
+{
+    public:
+        static MatchFunction select(AllocationRule allocation, TradePriceRule price);
+
+        /** parse "allocation/price" such as "fifo/ask", "prorata/mid" or "size/bid".
+         *  Returns false and leaves the rules alone if the text is not understood */
+        static bool parse(const std::string& text, AllocationRule& allocation, TradePriceRule& price);
+        static std::string toString(AllocationRule allocation, TradePriceRule price);
+};
@@ -0,0 +1,88 @@
+#include "MemoryReport.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#ifdef __linux__
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    /** bytes in KB with one decimal, the unit the rows are printed in */
+    std::string kb(std::size_t bytes)
+    {
+        std::ostringstream s;
+        s << std::fixed << std::setprecision(1) << bytes / 1024.0;
+        return s.str();
+    }
+}
+
+void MemoryReport::add(const std::string& name, const MemoryUsage& usage)
+{
+    rows.emplace_back(name, usage);
+}
+
+MemoryUsage MemoryReport::total() const
+{
+    MemoryUsage sum;
+    for (const auto& row : rows)
+    {
+        sum += row.second;
+    }
+    return sum;
+}
+
+std::string MemoryReport::toString() const
+{
+    std::ostringstream out;
+    out << std::left << std::setw(16) << "Memory (KB)" << std::right
+        << std::setw(12) << "Entries"
+        << std::setw(12) << "Strings"
+        << std::setw(12) << "Indexes"
+        << std::setw(12) << "Tape"
+        << std::setw(12) << "Total" << "\n";
+
+    std::vector<std::pair<std::string, MemoryUsage>> all = rows;
+    all.emplace_back("total", total());
+    for (const auto& row : all)
+    {
+        const MemoryUsage& u = row.second;
+        out << std::left << std::setw(16) << row.first << std::right
+            << std::setw(12) << kb(u.entries)
+            << std::setw(12) << kb(u.strings)
+            << std::setw(12) << kb(u.indexes)
+            << std::setw(12) << kb(u.tape)
+            << std::setw(12) << kb(u.total()) << "\n";
+    }
+    std::size_t now = currentRssBytes();
+    std::size_t peak = std::max(peakRssBytes(), now); // The two are sampled differently, keep them consistent
+    out << "Resident now: " << kb(now) << " KB, peak: " << kb(peak) << " KB\n";
+    return out.str();
+}
+
+std::size_t MemoryReport::peakRssBytes()
+{
+#ifdef __linux__
+    rusage usage{};
+    if (::getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return static_cast<std::size_t>(usage.ru_maxrss) * 1024; // KB on Linux
+#else
+    return 0;
+#endif
+}
+
+std::size_t MemoryReport::currentRssBytes()
+{
+#ifdef __linux__
+    // second field of statm is the resident page count
+    std::ifstream statm{"/proc/self/statm"};
+    std::size_t pages = 0;
+    std::size_t resident = 0;
+    if (!(statm >> pages >> resident)) return 0;
+    return resident * static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
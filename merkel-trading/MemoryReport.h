@@ -0,0 +1,32 @@
+#pragma once
+#include "MemoryUsage.h"
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * A table of what each part of the simulator holds, by MemoryUsage
+ * category, with the process's resident set size under it so the
+ * estimates can be checked against what the system sees.
+ */
+class MemoryReport
+{
+    public:
+        /** one row of the table */
+        void add(const std::string& name, const MemoryUsage& usage);
+
+        /** the sum of every row */
+        MemoryUsage total() const;
+
+        /** the table, one row per add, a total row and the resident set sizes */
+        std::string toString() const;
+
+        /** highest resident set size of the process so far, 0 if unknown */
+        static std::size_t peakRssBytes();
+        /** resident set size of the process now, 0 if unknown */
+        static std::size_t currentRssBytes();
+
+    private:
+        std::vector<std::pair<std::string, MemoryUsage>> rows;
+};
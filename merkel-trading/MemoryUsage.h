@@ -0,0 +1,70 @@
+#pragma once
+#include "OrderBookEntry.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Bytes held by a structure, split by what they hold. Sizes are estimates
+ * for libstdc++: strings of up to 15 characters live inside the string,
+ * a std::map node carries 32 bytes of links and an unordered_map node 8,
+ * plus a pointer per bucket. Unused vector capacity is counted.
+ */
+struct MemoryUsage
+{
+    std::size_t entries = 0; // Order records and their price and amount columns
+    std::size_t strings = 0; // Heap storage of strings too long to be kept in place
+    std::size_t indexes = 0; // Maps, ranges, levels and sums used to find and total orders
+    std::size_t tape = 0;    // What is kept after the fact: report buffers, recorded history
+
+    std::size_t total() const { return entries + strings + indexes + tape; }
+
+    MemoryUsage& operator+=(const MemoryUsage& other)
+    {
+        entries += other.entries;
+        strings += other.strings;
+        indexes += other.indexes;
+        tape += other.tape;
+        return *this;
+    }
+
+    /** heap bytes behind a string, 0 while it fits the small string buffer */
+    static std::size_t heapBytes(const std::string& s) { return s.capacity() > 15 ? s.capacity() + 1 : 0; }
+
+    /** the heap bytes of an order's strings, its own bytes are counted with its container */
+    static std::size_t heapBytes(const OrderBookEntry& e)
+    {
+        return heapBytes(e.timestamp) + heapBytes(e.product) + heapBytes(e.username);
+    }
+
+    /** a vector of orders, with its strings */
+    void addOrders(const std::vector<OrderBookEntry>& orders, std::size_t& into)
+    {
+        into += orders.capacity() * sizeof(OrderBookEntry);
+        for (const OrderBookEntry& e : orders)
+        {
+            strings += heapBytes(e);
+        }
+    }
+
+    /** a vector of strings, with their heap storage */
+    void addStrings(const std::vector<std::string>& names, std::size_t& into)
+    {
+        into += names.capacity() * sizeof(std::string);
+        for (const std::string& s : names)
+        {
+            strings += heapBytes(s);
+        }
+    }
+
+    /** nodes of a std::map or std::set, not what their values own */
+    template <typename Map>
+    static std::size_t treeBytes(const Map& map) { return map.size() * (sizeof(typename Map::value_type) + 32); }
+
+    /** nodes and buckets of a std::unordered_map, not what its values own */
+    template <typename Map>
+    static std::size_t hashBytes(const Map& map)
+    {
+        return map.size() * (sizeof(typename Map::value_type) + 8) + map.bucket_count() * sizeof(void*);
+    }
+};
@@ -1,9 +1,11 @@
 #include "MerkelMain.h"
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include <limits>
 #include "OrderBookEntry.h"
 #include "CSVReader.h"
+#include "ReportWriter.h"
 
 MerkelMain::MerkelMain()
 {
@@ -14,8 +16,16 @@ void MerkelMain::init()
 {
     int input; 
     currentTime = orderBook.getEarliestTime(); // Get the earliest time from the order book
+    history.record(currentTime);
 
     wallet.insertCurrency("BTC", 10.);
+    std::vector<std::string> products = orderBook.getKnownProducts();
+    if (!products.empty())
+    {
+        std::vector<std::string> currs = CSVReader::tokenise(products[0], '/');
+        wallet.setReferenceCurrency(currs.back()); // Valued in the quote currency of the first product
+    }
+    markWallet();
 
     while (true)
     {
@@ -36,8 +46,8 @@ void MerkelMain::init()
     void MerkelMain::printMenu()
 {
     std::cout << "Current time is: " << currentTime << std::endl; // Moved here
-    std::cout << "1: Print help\n2: Print exchange stats\n3: Make an Ask\n4: Make a bid\n5: Print wallet\n6: Continue\nType 'exit' to quit the program\n";
-    std::cout << "========= \nType in 1-6 or 'exit': ";
+    std::cout << "1: Print help\n2: Print exchange stats\n3: Make an Ask\n4: Make a bid\n5: Print wallet\n6: Continue\n7: Cancel an order\n8: Modify an order\n9: Look back at an earlier time\n10: Memory report\nType 'exit' to quit the program\n";
+    std::cout << "========= \nType in 1-10 or 'exit': ";
 }
 
 void MerkelMain::printHelp()
@@ -50,23 +60,49 @@ void MerkelMain::printMarketStats()
     for (std::string const& p : orderBook.getKnownProducts())
     {
         std::cout << "Product: " << p << std::endl;
-        std::vector<OrderBookEntry> entries = orderBook.getOrders(OrderBookType::ask, 
-                                                                    p, currentTime); // Changed "currentTime" to currentTime
+        PriceSummary asks = orderBook.getPriceSummary(OrderBookType::ask, 
+                                                      p, currentTime); // One pass over the asks of this frame
 
-        std::cout << "Asks seen: " << entries.size() << std::endl;
-        if (!entries.empty()) // Check if entries is not empty before accessing price data
+        std::cout << "Asks seen: " << asks.count << std::endl;
+        if (asks.count > 0) // Check there are asks before printing price data
         {
-            std::cout << "Max ask: " << OrderBook::getHighPrice(entries) << std::endl;
-            std::cout << "Min ask: " << OrderBook::getLowPrice(entries) << std::endl;   
-            std::cout << "Avg ask: " << OrderBook::getAveragePrice(entries) << std::endl; // Added average price                                                       
+            std::cout << "Max ask: " << asks.high << std::endl;
+            std::cout << "Min ask: " << asks.low << std::endl;   
+            std::cout << "Avg ask: " << asks.average() << std::endl; // Added average price                                                       
+            std::cout << "VWAP ask: " << asks.vwap() << std::endl;
         }
         else
         {
             std::cout << "No asks found for this time frame." << std::endl;
         }
+
+        RangeSummary recentBids = orderBook.getRecentSummary(OrderBookType::bid, p, currentTime, 10);
+        RangeSummary recentAsks = orderBook.getRecentSummary(OrderBookType::ask, p, currentTime, 10);
+        std::cout << "Last 10 frames - bid volume: " << recentBids.volume << " VWAP: " << recentBids.vwap()
+                  << " ask volume: " << recentAsks.volume << " VWAP: " << recentAsks.vwap() << std::endl;
+        std::cout << "Spread: " << orderBook.getSpread(p, currentTime)
+                  << " Mid: " << orderBook.getMidPrice(p, currentTime)
+                  << " Microprice: " << orderBook.getMicroPrice(p, currentTime) << std::endl;
+        std::vector<PriceLevel> bidLevels = orderBook.getDepth(OrderBookType::bid, p, currentTime, 5);
+        std::vector<PriceLevel> askLevels = orderBook.getDepth(OrderBookType::ask, p, currentTime, 5);
+        for (std::size_t i = 0; i < bidLevels.size() || i < askLevels.size(); ++i)
+        {
+            // one row per level: bid amount @ bid price | ask price @ ask amount
+            if (i < bidLevels.size()) std::cout << bidLevels[i].amount << " @ " << bidLevels[i].price;
+            else std::cout << "-";
+            std::cout << " | ";
+            if (i < askLevels.size()) std::cout << askLevels[i].price << " @ " << askLevels[i].amount;
+            else std::cout << "-";
+            std::cout << std::endl;
+        }
                                                          
     }
 
+    std::vector<ArbitrageOpportunity> cycles = arbitrage.scan(currentTime);
+    std::cout << "Triangular arbitrage: " << cycles.size() << " of " << arbitrage.cycleCount() << " cycles pay" << std::endl;
+    if (cycles.size() > 5) cycles.resize(5);
+    std::cout << ArbitrageScanner::formatOpportunities(cycles);
+
 /*     std::cout << "OrderBook contains : " << orders.size() << " entries" << std::endl;
     unsigned int bids = 0;
     unsigned int asks = 0;
@@ -89,14 +125,15 @@ void MerkelMain::printMarketStats()
 void MerkelMain::enterAsk()
 {
     std::cout << "Make an ask - enter the amount: product, price, amount eg ETH/BTC,200,0.5." << std::endl;
+    std::cout << "Add ,market ,ioc or ,fok to trade right away instead of resting (market ignores the price)." << std::endl;
     std::string input;
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); 
     std::getline(std::cin, input);
 
     std::vector<std::string> tokens = CSVReader::tokenise(input, ',');
-    if (tokens.size() != 3)
+    if (tokens.size() != 3 && tokens.size() != 4)
     {
-        std::cout << "Invalid input format. Please enter in the format: product,price,amount." << std::endl;
+        std::cout << "Invalid input format. Please enter in the format: product,price,amount[,market|ioc|fok]." << std::endl;
     }
     else 
     {
@@ -107,6 +144,21 @@ void MerkelMain::enterAsk()
                                                               currentTime, 
                                                               tokens[0], 
                                                               "ask");
+            if (tokens.size() == 4)
+            {
+                newOrder.execution = OrderBookEntry::stringToOrderExecution(tokens[3]);
+            }
+            if (newOrder.execution == OrderExecution::market)
+            {
+                // size the wallet check by the worst price the order would reach now
+                newOrder.price = orderBook.estimateFill(OrderBookType::bid, tokens[0], currentTime, newOrder.amount).worstPrice;
+            }
+
+            if (!isKnownProduct(tokens[0]))
+            {
+                std::cout << "Unknown product " << tokens[0] << ", it is never matched." << std::endl;
+                return;
+            }
 
             std::cout << "Created ask order: " << tokens[0] << " price: " << tokens[1] << " amount: " << tokens[2] << std::endl;
 
@@ -115,7 +167,18 @@ void MerkelMain::enterAsk()
             if (wallet.canFulfillOrder(newOrder)) // Check if the wallet can fulfill the order
             {
                 std::cout << "Wallet looks good. " << std::endl;
-                orderBook.insertOrder(newOrder); // Insert the new order into the order book
+                unsigned int id = orderBook.insertOrder(newOrder); // Insert the new order into the order book
+                if (id == 0)
+                {
+                    std::cout << "Price and amount must be numbers above zero." << std::endl;
+                    return;
+                }
+                wallet.reserve(newOrder); // Held back until it fills or is cancelled
+                std::cout << "Order id: " << id << std::endl;
+                if (newOrder.execution != OrderExecution::limit)
+                {
+                    std::cout << "It trades when this time frame is matched, what is left is cancelled." << std::endl;
+                }
             }
             else
             {
@@ -124,7 +187,7 @@ void MerkelMain::enterAsk()
         }
         catch (const std::exception& e)
         {
-            std::cout << "Error: Invalid price or amount format." << std::endl;
+            std::cout << "Error: Invalid price, amount or order type." << std::endl;
         }
     }
 
@@ -134,14 +197,15 @@ void MerkelMain::enterAsk()
 void MerkelMain::enterBid()
 {
     std::cout << "Make a bid - enter the amount: product, price, amount eg ETH/BTC,200,0.5." << std::endl;
+    std::cout << "Add ,market ,ioc or ,fok to trade right away instead of resting (market ignores the price)." << std::endl;
     std::string input;
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); 
     std::getline(std::cin, input);
 
     std::vector<std::string> tokens = CSVReader::tokenise(input, ',');
-    if (tokens.size() != 3)
+    if (tokens.size() != 3 && tokens.size() != 4)
     {
-        std::cout << "Invalid input format. Please enter in the format: product,price,amount." << std::endl;
+        std::cout << "Invalid input format. Please enter in the format: product,price,amount[,market|ioc|fok]." << std::endl;
     }
     else 
     {
@@ -152,6 +216,21 @@ void MerkelMain::enterBid()
                                                               currentTime, 
                                                               tokens[0], 
                                                               "bid");
+            if (tokens.size() == 4)
+            {
+                newOrder.execution = OrderBookEntry::stringToOrderExecution(tokens[3]);
+            }
+            if (newOrder.execution == OrderExecution::market)
+            {
+                // size the wallet check by the worst price the order would reach now
+                newOrder.price = orderBook.estimateFill(OrderBookType::ask, tokens[0], currentTime, newOrder.amount).worstPrice;
+            }
+
+            if (!isKnownProduct(tokens[0]))
+            {
+                std::cout << "Unknown product " << tokens[0] << ", it is never matched." << std::endl;
+                return;
+            }
 
             std::cout << "Created bid order: " << tokens[0] << " price: " << tokens[1] << " amount: " << tokens[2] << std::endl;
 
@@ -160,7 +239,18 @@ void MerkelMain::enterBid()
             if (wallet.canFulfillOrder(newOrder)) // Check if the wallet can fulfill the order
             {
                 std::cout << "Wallet looks good. " << std::endl;
-                orderBook.insertOrder(newOrder); // Insert the new order into the order book
+                unsigned int id = orderBook.insertOrder(newOrder); // Insert the new order into the order book
+                if (id == 0)
+                {
+                    std::cout << "Price and amount must be numbers above zero." << std::endl;
+                    return;
+                }
+                wallet.reserve(newOrder); // Held back until it fills or is cancelled
+                std::cout << "Order id: " << id << std::endl;
+                if (newOrder.execution != OrderExecution::limit)
+                {
+                    std::cout << "It trades when this time frame is matched, what is left is cancelled." << std::endl;
+                }
             }
             else
             {
@@ -169,12 +259,167 @@ void MerkelMain::enterBid()
         }
         catch (const std::exception& e)
         {
-            std::cout << "Error: Invalid price or amount format." << std::endl;
+            std::cout << "Error: Invalid price, amount or order type." << std::endl;
         }
     }
 
     std::cout << "You entered: " << input << std::endl;}
 
+void MerkelMain::printRestingOrders()
+{
+    std::vector<OrderBookEntry> resting = orderBook.getRestingOrders();
+    if (resting.empty())
+    {
+        std::cout << "You have no open orders." << std::endl;
+        return;
+    }
+    for (OrderBookEntry& e : resting)
+    {
+        std::cout << "Order " << e.id << ": " << e.product
+                  << (e.orderType == OrderBookType::bid ? " bid " : " ask ")
+                  << "price: " << e.price << " amount: " << e.amount;
+        if (e.execution != OrderExecution::limit)
+        {
+            std::cout << " (" << OrderBookEntry::orderExecutionToString(e.execution) << ", pending)";
+        }
+        std::cout << std::endl;
+    }
+}
+
+void MerkelMain::cancelOrder()
+{
+    printRestingOrders();
+    std::cout << "Cancel an order - enter the order id." << std::endl;
+    std::string input;
+    std::cin >> input;
+    try
+    {
+        unsigned int id = std::stoul(input);
+        if (orderBook.cancelOrder(id))
+        {
+            wallet.release(id);
+            std::cout << "Cancelled order " << id << std::endl;
+        }
+        else
+        {
+            std::cout << "No open order with id " << id << std::endl;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << "Error: Invalid order id." << std::endl;
+    }
+}
+
+void MerkelMain::modifyOrder()
+{
+    printRestingOrders();
+    std::cout << "Modify an order - enter: id, price, amount eg 1,200,0.5." << std::endl;
+    std::string input;
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); 
+    std::getline(std::cin, input);
+
+    std::vector<std::string> tokens = CSVReader::tokenise(input, ',');
+    if (tokens.size() != 3)
+    {
+        std::cout << "Invalid input format. Please enter in the format: id,price,amount." << std::endl;
+        return;
+    }
+    try
+    {
+        unsigned int id = std::stoul(tokens[0]);
+        const OrderBookEntry* current = orderBook.findOrder(id);
+        if (current == nullptr)
+        {
+            std::cout << "No open order with id " << id << std::endl;
+            return;
+        }
+        OrderBookEntry changed = *current;
+        changed.price = std::stod(tokens[1]);
+        changed.amount = std::stod(tokens[2]);
+
+        if (!wallet.canFulfillOrder(changed))
+        {
+            std::cout << "Not enough funds in wallet to fulfill this order." << std::endl;
+        }
+        else if (orderBook.replaceOrder(id, changed.price, changed.amount))
+        {
+            wallet.reserve(changed);
+            std::cout << "Modified order " << id << std::endl;
+        }
+        else
+        {
+            std::cout << "Could not modify order " << id << std::endl;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << "Error: Invalid id, price or amount format." << std::endl;
+    }
+}
+
+void MerkelMain::lookBack()
+{
+    std::cout << "Look back - enter a time you have been through, eg " << orderBook.getEarliestTime() << std::endl;
+    std::string input;
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    std::getline(std::cin, input);
+
+    std::unique_ptr<const BookSnapshot> book = history.bookAt(input);
+    if (!book)
+    {
+        std::cout << "No frame seen at or before " << input << std::endl;
+        return;
+    }
+    std::cout << "Book at the start of " << book->getTimestamp() << std::endl;
+    for (const std::string& p : book->getKnownProducts())
+    {
+        std::vector<PriceLevel> bid = book->getDepth(OrderBookType::bid, p, 1);
+        std::vector<PriceLevel> ask = book->getDepth(OrderBookType::ask, p, 1);
+        std::cout << p << " best bid: " << (bid.empty() ? 0 : bid[0].price)
+                  << " best ask: " << (ask.empty() ? 0 : ask[0].price)
+                  << " mid: " << book->getMidPrice(p) << std::endl;
+    }
+    std::cout << "Your orders then: " << history.getRestingAt(input).size() << std::endl;
+}
+
+void MerkelMain::markWallet()
+{
+    if (marked.empty())
+    {
+        for (const std::string& p : orderBook.getKnownProducts())
+        {
+            std::vector<std::string> currs = CSVReader::tokenise(p, '/');
+            if (currs.size() == 2) marked.push_back(MarkedProduct{p, currs[0], currs[1], 0});
+        }
+    }
+    for (MarkedProduct& m : marked)
+    {
+        // an unmoved mid still reprices a held currency whose other side moved, otherwise
+        // marking it again would change nothing
+        double mid = orderBook.getMidPrice(m.product, currentTime);
+        if (mid == m.mid && wallet.getBalance(m.base) <= 0 && wallet.getBalance(m.quote) <= 0) continue;
+        // only the base or quote is revalued. A mid that priced nothing is tried again next time
+        m.mid = wallet.markPrice(m.base, m.quote, mid) ? mid : 0;
+    }
+}
+
+bool MerkelMain::isKnownProduct(const std::string& product)
+{
+    std::vector<std::string> products = orderBook.getKnownProducts();
+    return std::find(products.begin(), products.end(), product) != products.end();
+}
+
+void MerkelMain::printMemoryReport()
+{
+    MemoryReport report;
+    orderBook.reportMemory(report);
+    report.add("history", history.memoryUsage());
+    report.add("arbitrage", arbitrage.memoryUsage());
+    report.add("wallet", wallet.memoryUsage());
+    std::cout << report.toString() << std::endl;
+}
+
 void MerkelMain::printWallet()
 {
     std::cout << wallet.toString() << std::endl; 
@@ -198,7 +443,7 @@ int MerkelMain::getUserOption()
     }
     catch (...)
     {
-        std::cout << "Invalid input. Please enter a number between 1-6 or 'exit'." << std::endl;
+        std::cout << "Invalid input. Please enter a number between 1-10 or 'exit'." << std::endl;
         return -1;
     }
 
@@ -219,23 +464,49 @@ void MerkelMain::processUserOption(int userOption)
         {
             std::cout << "Going to next time frame..." << std::endl;
 
-            std::vector<OrderBookEntry> sales = orderBook.matchAsksToBids("ETH/BTC", currentTime); // Matches asks to bids for the current time
+            std::vector<OrderBookEntry> sales;
+            for (const std::string& p : orderBook.getKnownProducts())
+            {
+                // every product, so pending takers on any of them get their one chance
+                std::vector<OrderBookEntry> productSales = orderBook.matchAsksToBids(p, currentTime);
+                sales.insert(sales.end(), productSales.begin(), productSales.end());
+            }
             std::cout << "Sales: " << sales.size() << std::endl;
-            for (OrderBookEntry& sale : sales)
+            unsigned int refused = 0;
             {
-                std::cout << "Sale price: " << sale.price << " amount " << sale.amount << std::endl;
-                if (sale.username == "simuser")
+                ReportWriter report{std::cout}; // One write for all the lines, when it goes out of scope
+                for (OrderBookEntry& sale : sales)
                 {
-                    wallet.processSale(sale); // Process the sale in the wallet
+                    if (sale.username == "simuser")
+                    {
+                        if (wallet.processSale(sale)) report.fill(sale); // Only fills the wallet could pay for
+                        else refused++;
+                    }
+                    else
+                    {
+                        report.trade(sale);
+                    }
                 }
             }
+            if (refused > 0)
+            {
+                std::cout << refused << " fills refused, the wallet could not pay for them." << std::endl;
+            }
+
+            wallet.keepReserved(orderBook.getRestingOrders()); // Filled orders give back what they held
 
             currentTime = orderBook.getNextTime(currentTime); // Update current time to the next time frame
+            history.record(currentTime);
+            markWallet();
             break;
         }
+    case 7: cancelOrder(); break;
+    case 8: modifyOrder(); break;
+    case 9: lookBack(); break;
+    case 10: printMemoryReport(); break;
 
     default: 
-        std::cout << "Invalid choice. Please select a number between 1-6." << std::endl;
+        std::cout << "Invalid choice. Please select a number between 1-10." << std::endl;
         break; // Added break for default case as good practice
     }
 }
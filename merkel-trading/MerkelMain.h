@@ -3,6 +3,8 @@
 #include <string>
 #include "OrderBookEntry.h"
 #include "OrderBook.h"
+#include "ArbitrageScanner.h"
+#include "BookHistory.h"
 #include "Wallet.h"
 
 class MerkelMain
@@ -19,12 +21,33 @@ private:
     void enterAsk();
     void enterBid();
     void printWallet();
+    void printRestingOrders();
+    void cancelOrder();
+    void modifyOrder();
+    void lookBack();
+    void printMemoryReport();
+    /** value the wallet at the mid prices of the current frame */
+    void markWallet();
+    /** true if the dataset trades product, orders on anything else would never be matched */
+    bool isKnownProduct(const std::string& product);
     int getUserOption();
     void processUserOption(int userOption);
 
+    /** a product split into its currencies once, and the mid it was last marked at */
+    struct MarkedProduct
+    {
+        std::string product;
+        std::string base;
+        std::string quote;
+        double mid;
+    };
+
     std::string currentTime;
+    std::vector<MarkedProduct> marked; // Every known product, filled by the first markWallet
 
     OrderBook orderBook{"test.csv"}; // Holds the order book
+    ArbitrageScanner arbitrage{orderBook}; // Cycles between the book's products, listed once
+    BookHistory history{orderBook}; // The book at the start of every frame seen so far
 
     Wallet wallet;
 
@@ -0,0 +1,644 @@
+#include "OrderArchive.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+namespace
+{
+    const char MAGIC[4] = {'M', 'K', 'A', '2'};
+    const char MAGIC_V1[4] = {'M', 'K', 'A', '1'}; // Per row time deltas, read back with six fraction digits
+    const int MAX_DECIMALS = 12;
+
+    /** appends little-endian values to a byte buffer (the archive assumes a little-endian host) */
+    class ByteWriter
+    {
+        public:
+            template <typename T>
+            void put(T value)
+            {
+                unsigned char bytes[sizeof(T)];
+                std::memcpy(bytes, &value, sizeof(T));
+                buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+            }
+
+            void putString(const std::string& s)
+            {
+                put<std::uint32_t>(s.size());
+                buffer.insert(buffer.end(), s.begin(), s.end());
+            }
+
+            std::vector<unsigned char> buffer;
+    };
+
+    /** reads what ByteWriter wrote, throwing if the block is cut short */
+    class ByteReader
+    {
+        public:
+            ByteReader(const unsigned char* data, std::size_t size) : pos(data), end(data + size) {}
+
+            template <typename T>
+            T get()
+            {
+                need(sizeof(T));
+                T value;
+                std::memcpy(&value, pos, sizeof(T));
+                pos += sizeof(T);
+                return value;
+            }
+
+            std::string getString()
+            {
+                std::uint32_t length = get<std::uint32_t>();
+                need(length);
+                std::string s{reinterpret_cast<const char*>(pos), length};
+                pos += length;
+                return s;
+            }
+
+        private:
+            void need(std::size_t bytes)
+            {
+                if (static_cast<std::size_t>(end - pos) < bytes)
+                {
+                    throw std::runtime_error("OrderArchive: block is truncated");
+                }
+            }
+
+            const unsigned char* pos;
+            const unsigned char* end;
+    };
+
+    /** write the width in bits of the largest value, then every value in that many bits */
+    void packBits(const std::vector<std::uint64_t>& values, ByteWriter& out)
+    {
+        std::uint64_t largest = 0;
+        for (std::uint64_t v : values) largest |= v;
+        std::uint8_t width = 0;
+        while (width < 64 && (largest >> width) != 0) ++width;
+        out.put<std::uint8_t>(width);
+        if (width == 0) return; // every value is 0
+
+        std::uint64_t word = 0;
+        unsigned int used = 0;
+        for (std::uint64_t v : values)
+        {
+            word |= v << used;
+            if (used + width >= 64)
+            {
+                out.put<std::uint64_t>(word);
+                // the bits of v that did not fit start the next word
+                word = used == 0 ? 0 : v >> (64 - used);
+                used = used + width - 64;
+            }
+            else
+            {
+                used += width;
+            }
+        }
+        if (used > 0) out.put<std::uint64_t>(word);
+    }
+
+    std::vector<std::uint64_t> unpackBits(ByteReader& in, std::size_t count)
+    {
+        std::vector<std::uint64_t> values(count, 0);
+        std::uint8_t width = in.get<std::uint8_t>();
+        if (width == 0) return values;
+        if (width > 64) throw std::runtime_error("OrderArchive: bad bit width");
+
+        std::uint64_t mask = width == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << width) - 1;
+        std::uint64_t word = 0;
+        unsigned int available = 0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (available >= width)
+            {
+                values[i] = word & mask;
+                word = width == 64 ? 0 : word >> width;
+                available -= width;
+            }
+            else
+            {
+                // the value is split over this word and the next one
+                std::uint64_t next = in.get<std::uint64_t>();
+                std::uint64_t v = word | (available == 0 ? next : next << available);
+                values[i] = v & mask;
+                unsigned int fromNext = width - available;
+                word = fromNext == 64 ? 0 : next >> fromNext;
+                available = 64 - fromNext;
+            }
+        }
+        return values;
+    }
+
+    std::uint64_t zigzag(std::int64_t v)
+    {
+        return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+    }
+
+    std::int64_t unzigzag(std::uint64_t v)
+    {
+        return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+    }
+
+    /** scale a column to integers with the fewest decimals that give back exactly the same doubles,
+     *  then store the integers relative to their minimum. Falls back to raw doubles */
+    void encodeDoubles(const std::vector<double>& values, ByteWriter& out)
+    {
+        double scale = 1;
+        for (int decimals = 0; decimals <= MAX_DECIMALS; ++decimals, scale *= 10)
+        {
+            bool exact = true;
+            for (double v : values)
+            {
+                double scaled = std::round(v * scale);
+                if (!std::isfinite(v) || std::fabs(scaled) > 9007199254740992.0 || scaled / scale != v)
+                {
+                    exact = false;
+                    break;
+                }
+            }
+            if (!exact) continue;
+
+            std::vector<std::int64_t> ints;
+            ints.reserve(values.size());
+            std::int64_t base = 0;
+            for (double v : values)
+            {
+                ints.push_back(static_cast<std::int64_t>(std::round(v * scale)));
+                if (ints.size() == 1 || ints.back() < base) base = ints.back();
+            }
+            std::vector<std::uint64_t> offsets, deltas;
+            offsets.reserve(values.size());
+            deltas.reserve(values.size());
+            std::uint64_t offsetBits = 0, deltaBits = 0;
+            for (std::size_t i = 0; i < ints.size(); ++i)
+            {
+                offsets.push_back(static_cast<std::uint64_t>(ints[i] - base));
+                deltas.push_back(zigzag(ints[i] - (i == 0 ? ints[0] : ints[i - 1])));
+                offsetBits |= offsets.back();
+                deltaBits |= deltas.back();
+            }
+
+            // sorted runs such as the price levels of a frame pack tighter as deltas
+            bool useDeltas = deltaBits < offsetBits;
+            out.put<std::uint8_t>(useDeltas ? 2 : 1); // scaled codec, delta or frame of reference
+            out.put<std::uint8_t>(decimals);
+            out.put<std::int64_t>(useDeltas ? ints[0] : base);
+            packBits(useDeltas ? deltas : offsets, out);
+            return;
+        }
+
+        out.put<std::uint8_t>(0); // raw codec
+        for (double v : values) out.put<double>(v);
+    }
+
+    std::vector<double> decodeDoubles(ByteReader& in, std::size_t count)
+    {
+        std::vector<double> values(count);
+        std::uint8_t codec = in.get<std::uint8_t>();
+        if (codec == 0)
+        {
+            for (double& v : values) v = in.get<double>();
+            return values;
+        }
+        if (codec != 1 && codec != 2) throw std::runtime_error("OrderArchive: unknown column codec");
+
+        int decimals = in.get<std::uint8_t>();
+        if (decimals > MAX_DECIMALS) throw std::runtime_error("OrderArchive: bad column scale");
+        double scale = 1;
+        for (int d = 0; d < decimals; ++d) scale *= 10;
+        std::int64_t base = in.get<std::int64_t>();
+        std::vector<std::uint64_t> offsets = unpackBits(in, count);
+        std::int64_t current = base;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (codec == 2) current += unzigzag(offsets[i]);
+            else current = base + static_cast<std::int64_t>(offsets[i]);
+            values[i] = static_cast<double>(current) / scale;
+        }
+        return values;
+    }
+
+    /** days since 1970-01-01 of a civil date */
+    std::int64_t daysFromCivil(std::int64_t y, unsigned int m, unsigned int d)
+    {
+        y -= m <= 2;
+        std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+        unsigned int yoe = static_cast<unsigned int>(y - era * 400);
+        unsigned int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        unsigned int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+    }
+
+    void civilFromDays(std::int64_t z, int& y, unsigned int& m, unsigned int& d)
+    {
+        z += 719468;
+        std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+        unsigned int doe = static_cast<unsigned int>(z - era * 146097);
+        unsigned int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        unsigned int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        unsigned int mp = (5 * doy + 2) / 153;
+        d = doy - (153 * mp + 2) / 5 + 1;
+        m = mp < 10 ? mp + 3 : mp - 9;
+        y = static_cast<int>(yoe + era * 400 + (m <= 2));
+    }
+
+    /** "2020/03/17 17:01:24.884492" to microseconds since the epoch */
+    std::int64_t parseTimestamp(const std::string& s)
+    {
+        int y, mo, d, h, mi, sec;
+        char fraction[16] = "";
+        int fields = std::sscanf(s.c_str(), "%4d/%2d/%2d %2d:%2d:%2d.%15[0-9]", &y, &mo, &d, &h, &mi, &sec, fraction);
+        if (fields < 6)
+        {
+            throw std::runtime_error("OrderArchive: cannot parse timestamp " + s);
+        }
+        std::int64_t micros = 0;
+        int digits = 0;
+        for (; fraction[digits] != '\0' && digits < 6; ++digits)
+        {
+            micros = micros * 10 + (fraction[digits] - '0');
+        }
+        for (; digits < 6; ++digits) micros *= 10; // ".88492" is 884920 microseconds
+
+        std::int64_t days = daysFromCivil(y, mo, d);
+        return ((days * 24 + h) * 60 + mi) * 60 * 1000000LL + sec * 1000000LL + micros;
+    }
+
+    /** how a timestamp writes its fraction: 0 for none, otherwise 1 + the number of digits */
+    std::uint64_t fractionCode(const std::string& s)
+    {
+        std::string::size_type dot = s.find('.');
+        return dot == std::string::npos ? 0 : s.size() - dot;
+    }
+
+    /** micros written back with the fraction of code, see fractionCode */
+    std::string formatTimestamp(std::int64_t micros, std::uint64_t code = 7)
+    {
+        std::int64_t seconds = micros / 1000000;
+        std::int64_t fraction = micros % 1000000;
+        if (fraction < 0)
+        {
+            fraction += 1000000;
+            seconds -= 1;
+        }
+        std::int64_t days = seconds / 86400;
+        std::int64_t rest = seconds % 86400;
+        if (rest < 0)
+        {
+            rest += 86400;
+            days -= 1;
+        }
+        int y;
+        unsigned int m, d;
+        civilFromDays(days, y, m, d);
+        char buffer[40];
+        int length = std::snprintf(buffer, sizeof(buffer), "%04d/%02u/%02u %02d:%02d:%02d",
+                                   y, m, d,
+                                   static_cast<int>(rest / 3600), static_cast<int>(rest / 60 % 60), static_cast<int>(rest % 60));
+        if (code > 0)
+        {
+            int digits = static_cast<int>(code) - 1;
+            for (int i = digits; i < 6; ++i) fraction /= 10; // Only the digits the original had
+            if (digits == 0) std::snprintf(buffer + length, sizeof(buffer) - length, ".");
+            else std::snprintf(buffer + length, sizeof(buffer) - length, ".%0*d", digits, static_cast<int>(fraction));
+        }
+        return buffer;
+    }
+
+    std::vector<unsigned char> encodeBlock(const std::vector<OrderBookEntry>& entries, std::size_t begin, std::size_t end)
+    {
+        ByteWriter out;
+        std::size_t rows = end - begin;
+        out.put<std::uint32_t>(rows);
+
+        // timestamps: runs of rows with the same string, each with its delta from the run
+        // before, how its fraction is written and its length
+        std::vector<std::uint64_t> deltas, formats, lengths;
+        std::int64_t previous = parseTimestamp(entries[begin].timestamp);
+        out.put<std::int64_t>(previous);
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            const std::string& text = entries[i].timestamp;
+            if (i > begin && text == entries[i - 1].timestamp)
+            {
+                lengths.back()++;
+                continue;
+            }
+            std::int64_t t = parseTimestamp(text);
+            std::uint64_t format = fractionCode(text);
+            if (format > 7 || formatTimestamp(t, format) != text)
+            {
+                throw std::runtime_error("OrderArchive: cannot store timestamp " + text + " exactly");
+            }
+            deltas.push_back(zigzag(t - previous));
+            formats.push_back(format);
+            lengths.push_back(1);
+            previous = t;
+        }
+        out.put<std::uint32_t>(lengths.size());
+        packBits(deltas, out);
+        packBits(formats, out);
+        packBits(lengths, out);
+
+        // products: dictionary of this block plus a code per row
+        std::map<std::string, std::uint64_t> dictionary;
+        for (std::size_t i = begin; i < end; ++i) dictionary.emplace(entries[i].product, 0);
+        out.put<std::uint32_t>(dictionary.size());
+        std::uint64_t code = 0;
+        for (auto& e : dictionary)
+        {
+            e.second = code++;
+            out.putString(e.first);
+        }
+        std::vector<std::uint64_t> codes;
+        codes.reserve(rows);
+        for (std::size_t i = begin; i < end; ++i) codes.push_back(dictionary[entries[i].product]);
+        packBits(codes, out);
+
+        std::vector<std::uint64_t> types;
+        types.reserve(rows);
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            // the execution sits above the type so limit orders keep the original codes
+            types.push_back(static_cast<std::uint64_t>(entries[i].orderType) |
+                            static_cast<std::uint64_t>(entries[i].execution) << 3);
+        }
+        packBits(types, out);
+
+        // prices and amounts get a column per product, products trade on very different scales
+        for (std::uint64_t product = 0; product < dictionary.size(); ++product)
+        {
+            std::vector<double> prices, amounts;
+            for (std::size_t i = 0; i < rows; ++i)
+            {
+                if (codes[i] != product) continue;
+                prices.push_back(entries[begin + i].price);
+                amounts.push_back(entries[begin + i].amount);
+            }
+            encodeDoubles(prices, out);
+            encodeDoubles(amounts, out);
+        }
+        return out.buffer;
+    }
+}
+
+void OrderArchive::write(const std::vector<OrderBookEntry>& entries, std::string filename, std::size_t rowsPerBlock)
+{
+    std::ofstream file{filename, std::ios::binary};
+    if (!file.is_open())
+    {
+        throw std::runtime_error("OrderArchive: cannot open " + filename);
+    }
+    if (rowsPerBlock == 0) rowsPerBlock = 65536;
+
+    file.write(MAGIC, sizeof(MAGIC));
+    for (std::size_t begin = 0; begin < entries.size(); begin += rowsPerBlock)
+    {
+        std::size_t end = std::min(entries.size(), begin + rowsPerBlock);
+        std::vector<unsigned char> block = encodeBlock(entries, begin, end);
+        std::uint32_t size = block.size();
+        file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        file.write(reinterpret_cast<const char*>(block.data()), block.size());
+    }
+    if (!file)
+    {
+        throw std::runtime_error("OrderArchive: error writing " + filename);
+    }
+}
+
+std::vector<OrderBookEntry> OrderArchive::read(std::string filename)
+{
+    std::ifstream file{filename, std::ios::binary};
+    if (!file.is_open())
+    {
+        throw std::runtime_error("OrderArchive: cannot open " + filename);
+    }
+    std::vector<unsigned char> bytes{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    int version = bytes.size() < sizeof(MAGIC) ? 0 : formatVersion(reinterpret_cast<const char*>(bytes.data()));
+    if (version == 0)
+    {
+        throw std::runtime_error("OrderArchive: " + filename + " is not an order archive");
+    }
+
+    std::vector<OrderBookEntry> entries;
+    std::size_t pos = sizeof(MAGIC);
+    while (pos < bytes.size())
+    {
+        std::uint32_t size;
+        if (bytes.size() - pos < sizeof(size)) throw std::runtime_error("OrderArchive: truncated block header");
+        std::memcpy(&size, bytes.data() + pos, sizeof(size));
+        pos += sizeof(size);
+        if (bytes.size() - pos < size) throw std::runtime_error("OrderArchive: truncated block");
+        decodeBlock(bytes.data() + pos, size, entries, version);
+        pos += size;
+    }
+    return entries;
+}
+
+void OrderArchive::readTimeRange(std::string filename, std::string& first, std::string& last)
+{
+    std::ifstream file{filename, std::ios::binary};
+    char magic[sizeof(MAGIC)];
+    int version = file.read(magic, sizeof(magic)) ? formatVersion(magic) : 0;
+    if (version == 0)
+    {
+        throw std::runtime_error("OrderArchive: " + filename + " is not an order archive");
+    }
+
+    // hop over the blocks by their length prefixes, remembering the first and last
+    std::streamoff firstOffset = -1, lastOffset = -1;
+    std::uint32_t firstSize = 0, lastSize = 0, size;
+    while (file.read(reinterpret_cast<char*>(&size), sizeof(size)))
+    {
+        std::streamoff offset = file.tellg();
+        if (firstOffset < 0)
+        {
+            firstOffset = offset;
+            firstSize = size;
+        }
+        lastOffset = offset;
+        lastSize = size;
+        file.seekg(size, std::ios::cur);
+    }
+    first = "";
+    last = "";
+    if (firstOffset < 0) return; // no blocks
+
+    file.clear();
+    std::vector<OrderBookEntry> rows;
+    std::vector<unsigned char> block(firstSize);
+    file.seekg(firstOffset);
+    file.read(reinterpret_cast<char*>(block.data()), firstSize);
+    decodeBlock(block.data(), firstSize, rows, version);
+    if (!rows.empty()) first = rows.front().timestamp;
+
+    rows.clear();
+    block.resize(lastSize);
+    file.seekg(lastOffset);
+    file.read(reinterpret_cast<char*>(block.data()), lastSize);
+    decodeBlock(block.data(), lastSize, rows, version);
+    if (!rows.empty()) last = rows.back().timestamp;
+}
+
+std::vector<std::string> OrderArchive::readProducts(std::string filename)
+{
+    std::ifstream file{filename, std::ios::binary};
+    char magic[sizeof(MAGIC)];
+    int version = file.read(magic, sizeof(magic)) ? formatVersion(magic) : 0;
+    if (version == 0)
+    {
+        throw std::runtime_error("OrderArchive: " + filename + " is not an order archive");
+    }
+
+    auto get = [&file](auto& value)
+    {
+        if (!file.read(reinterpret_cast<char*>(&value), sizeof(value)))
+        {
+            throw std::runtime_error("OrderArchive: block is truncated");
+        }
+    };
+    // a bit-packed column is its width, then as many words as count values of that width take
+    auto skipBits = [&](std::uint64_t count)
+    {
+        std::uint8_t width;
+        get(width);
+        file.seekg((count * width + 63) / 64 * sizeof(std::uint64_t), std::ios::cur);
+    };
+
+    std::set<std::string> products;
+    std::uint32_t size;
+    while (file.read(reinterpret_cast<char*>(&size), sizeof(size)))
+    {
+        std::streamoff next = static_cast<std::streamoff>(file.tellg()) + size;
+        std::uint32_t rows, runs;
+        std::int64_t first;
+        get(rows);
+        get(first);
+        if (version == 1)
+        {
+            skipBits(rows);
+        }
+        else
+        {
+            get(runs);
+            for (int column = 0; column < 3; ++column) skipBits(runs); // Deltas, formats, lengths
+        }
+        std::uint32_t count;
+        get(count);
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            std::uint32_t length;
+            get(length);
+            std::string product(length, '\0');
+            if (!file.read(&product[0], length)) throw std::runtime_error("OrderArchive: block is truncated");
+            products.insert(product);
+        }
+        file.seekg(next);
+    }
+    return std::vector<std::string>(products.begin(), products.end());
+}
+
+void OrderArchive::decodeBlock(const unsigned char* data, std::size_t size, std::vector<OrderBookEntry>& out, int version)
+{
+    ByteReader in{data, size};
+    std::size_t rows = in.get<std::uint32_t>();
+
+    std::int64_t timestamp = in.get<std::int64_t>();
+    std::vector<std::uint64_t> deltas, formats, lengths;
+    if (version == 1)
+    {
+        // a run per row, the fraction always six digits
+        deltas = unpackBits(in, rows);
+        formats.assign(rows, 7);
+        lengths.assign(rows, 1);
+    }
+    else
+    {
+        std::size_t runs = in.get<std::uint32_t>();
+        if (runs > rows) throw std::runtime_error("OrderArchive: bad timestamp runs");
+        deltas = unpackBits(in, runs);
+        formats = unpackBits(in, runs);
+        lengths = unpackBits(in, runs);
+        std::uint64_t covered = 0;
+        for (std::size_t r = 0; r < runs; ++r)
+        {
+            if (formats[r] > 7) throw std::runtime_error("OrderArchive: bad timestamp format");
+            covered += lengths[r];
+        }
+        if (covered != rows) throw std::runtime_error("OrderArchive: timestamp runs do not cover the block");
+    }
+
+    std::vector<std::string> dictionary(in.get<std::uint32_t>());
+    for (std::string& product : dictionary) product = in.getString();
+    std::vector<std::uint64_t> codes = unpackBits(in, rows);
+    std::vector<std::uint64_t> types = unpackBits(in, rows);
+
+    std::vector<std::size_t> perProduct(dictionary.size(), 0);
+    for (std::uint64_t code : codes)
+    {
+        if (code >= dictionary.size()) throw std::runtime_error("OrderArchive: bad product code");
+        perProduct[code]++;
+    }
+    // scatter the per product columns back into row order
+    std::vector<double> prices(rows), amounts(rows);
+    for (std::size_t product = 0; product < dictionary.size(); ++product)
+    {
+        std::vector<double> productPrices = decodeDoubles(in, perProduct[product]);
+        std::vector<double> productAmounts = decodeDoubles(in, perProduct[product]);
+        std::size_t next = 0;
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            if (codes[i] != product) continue;
+            prices[i] = productPrices[next];
+            amounts[i] = productAmounts[next];
+            ++next;
+        }
+    }
+
+    out.reserve(out.size() + rows);
+    std::string text;
+    std::size_t run = 0;
+    std::uint64_t left = 0; // Rows still to come in the current run
+    for (std::size_t i = 0; i < rows; ++i)
+    {
+        while (left == 0)
+        {
+            // only format when the frame changes, version 1 has a run for every row
+            if (run == 0 || deltas[run] != 0 || formats[run] != formats[run - 1])
+            {
+                timestamp += unzigzag(deltas[run]);
+                text = formatTimestamp(timestamp, formats[run]);
+            }
+            left = lengths[run++];
+        }
+        --left;
+        std::uint64_t type = types[i] & 7;
+        std::uint64_t execution = types[i] >> 3;
+        if (type > static_cast<std::uint64_t>(OrderBookType::bidsale) ||
+            execution > static_cast<std::uint64_t>(OrderExecution::fok))
+        {
+            throw std::runtime_error("OrderArchive: bad order type code");
+        }
+        out.emplace_back(prices[i], amounts[i], text, dictionary[codes[i]], static_cast<OrderBookType>(type));
+        out.back().execution = static_cast<OrderExecution>(execution);
+    }
+}
+
+int OrderArchive::formatVersion(const char* magic)
+{
+    if (std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0) return 2;
+    if (std::memcmp(magic, MAGIC_V1, sizeof(MAGIC_V1)) == 0) return 1;
+    return 0;
+}
+
+bool OrderArchive::isArchive(const std::string& filename)
+{
+    return filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".mka") == 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "OrderBookEntry.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Compressed columnar archive for order book data.
+ *
+ * Rows are stored in blocks. Every block carries its own dictionaries and
+ * bases, so it can be decoded without reading any other block:
+ *  - timestamps as microseconds in runs of equal strings, each run bit-packed
+ *    as its delta from the run before, its fraction width and its length
+ *  - products as a per block dictionary plus bit-packed codes
+ *  - order types as bit-packed codes, the execution (limit, market...) in bits 3 and up
+ *  - prices and amounts scaled to integers by the smallest power of ten that
+ *    round-trips exactly, then frame-of-reference and bit-packed. Columns that
+ *    do not scale cleanly are kept as raw doubles.
+ *
+ * Timestamps must look like YYYY/MM/DD HH:MM:SS[.ffffff] and come back exactly as
+ * written, so a book read from an archive has the same frames as one read from
+ * its csv. Version 1 archives, which kept no fraction width, still read with six
+ * fraction digits. Usernames are not stored, every row reads back as "dataset".
+ */
+class OrderArchive
+{
+    public:
+        /** write entries to filename, throws std::runtime_error on a timestamp that cannot be
+         *  stored exactly or a write error */
+        static void write(const std::vector<OrderBookEntry>& entries,
+                          std::string filename,
+                          std::size_t rowsPerBlock = 65536);
+
+        /** read every block of an archive, throws std::runtime_error if the file is not an archive */
+        static std::vector<OrderBookEntry> read(std::string filename);
+
+        /** first and last timestamp of an archive, decoding only its first and last block */
+        static void readTimeRange(std::string filename, std::string& first, std::string& last);
+
+        /** every product of an archive, sorted, from the block dictionaries without decoding any rows */
+        static std::vector<std::string> readProducts(std::string filename);
+
+        /** decode one block (as written after its length prefix) of an archive of version,
+         *  appending the rows to out */
+        static void decodeBlock(const unsigned char* data, std::size_t size, std::vector<OrderBookEntry>& out,
+                                int version = 2);
+
+        /** the format version of the four bytes an archive starts with, 0 if they are not one */
+        static int formatVersion(const char* magic);
+
+        /** true if the file name has the archive extension .mka */
+        static bool isArchive(const std::string& filename);
+};
@@ -1,56 +1,77 @@
 #include "OrderBook.h"
 #include "CSVReader.h"
+#include "MatchingEngine.h"
+#include "Log.h"
 #include <map>
 #include <algorithm>
 
 
-/** construct, reading a csv data file */
-       OrderBook::OrderBook(std::string filename)
+/** construct, reading a csv data file, an archive, a directory of shards or a manifest */
+       OrderBook::OrderBook(std::string filename) : shards(filename)
        {
-            orders = CSVReader::readCSV (filename); // Reads the CSV file and populate the order book
 
        }
 
 
     /** return vector of all known products in the dataset */
-        std::vector<std::string> OrderBook::getKnownProducts()
+        std::vector<std::string> OrderBook::getKnownProducts() const
         {
-            std::vector<std::string> products;
-
-            std::map<std::string, bool> prodMap; 
-
-            for (OrderBookEntry& e : orders)
-            {
-                prodMap[e.product] = true; 
-            }
-
-            // now flatten the map to a vector of strings
-            for (auto const& e : prodMap)
-            {
-                products.push_back(e.first);
-            }
-
-            return products; 
+            return shards.getKnownProducts(); // Collected as the shards are read
         }
 
 
     /** return vector of Orders according to the sent filters */
         std::vector<OrderBookEntry> OrderBook::getOrders(OrderBookType type, 
                                                 std::string product,
-                                                std::string timestamp)
+                                                std::string timestamp) const
+        {
+            return getOrders(type, product, timestamp, resting);
+        }
+
+        std::vector<OrderBookEntry> OrderBook::getOrders(OrderBookType type,
+                                                const std::string& product,
+                                                const std::string& timestamp,
+                                                const RestingOrders& overlay) const
         {
             std::vector<OrderBookEntry> orders_sub;
 
-            for (OrderBookEntry& e : orders)
+            if (type == OrderBookType::bid || type == OrderBookType::ask)
             {
-                if (e.orderType == type &&
-                    e.product == product &&
-                    e.timestamp == timestamp )
-
+                // bids and asks of a frame sit together, so copy the run straight out of the index
+                int frame;
+                std::shared_ptr<const BookShard> shard = shardFor(timestamp, frame);
+                int pid = shard ? shard->productIndex(product) : -1;
+                if (frame >= 0 && pid >= 0)
+                {
+                    BookShard::Slice slice = shard->getSlice(frame, pid, type);
+                    orders_sub.assign(slice.orders, slice.orders + slice.count);
+                }
+            }
+            else
+            {
+                int frame;
+                std::shared_ptr<const BookShard> shard = shardFor(timestamp, frame);
+                BookShard::Slice all = frame >= 0 ? shard->getFrame(frame) : BookShard::Slice{nullptr, nullptr, nullptr, 0};
+                for (std::size_t i = 0; i < all.count; ++i)
                 {
-                    orders_sub.push_back(e); // Add the entry to the sub-vector if it matches the filters
+                    const OrderBookEntry& e = all.orders[i];
+                    if (e.orderType == type &&
+                        e.product == product)
+
+                    {
+                        orders_sub.push_back(e); // Add the entry to the sub-vector if it matches the filters
+                    }
+
                 }
+            }
 
+            // Resting user orders are live in every frame from the one they were entered in
+            for (OrderBookEntry& e : overlay.getOrders(type, product))
+            {
+                if (e.timestamp <= timestamp)
+                {
+                    orders_sub.push_back(e);
+                }
             }
 
             return orders_sub;
@@ -59,136 +80,484 @@
 
             double OrderBook::getHighPrice(std::vector<OrderBookEntry>& orders)
             {
-                double max = orders[0].price;
-                for (OrderBookEntry & e : orders)
-                {
-                    if (e.price > max)max = e.price; // Update max if the current price is higher
+                return getPriceSummary(orders).high;
             }
-            return max;
-        }
 
-                    double OrderBook::getLowPrice(std::vector<OrderBookEntry>& orders)
+            double OrderBook::getLowPrice(std::vector<OrderBookEntry>& orders)
             {
-                double min = orders[0].price;
-                for (OrderBookEntry & e : orders)
-                {
-                    if (e.price < min)min = e.price; // Update max if the current price is higher
+                return getPriceSummary(orders).low;
             }
-            return min;
-        }
 
-            std::string OrderBook::getEarliestTime()
+            std::string OrderBook::getEarliestTime() const
             {
-                return orders[0].timestamp;
+                return shards.getInfo(0).first; // "" for an empty book
             }
 
-            std::string OrderBook::getNextTime(std::string timestamp)
+            std::string OrderBook::getNextTime(std::string timestamp) const
             {
-                std::string next_timestamp = "";
-                for (OrderBookEntry& e : orders)
+                std::string first = shards.getInfo(0).first;
+                if (first.empty()) return "";
+                std::size_t s = shards.findShard(timestamp);
+                if (s == shards.shardCount())
                 {
-                    if (e.timestamp > timestamp)
-                    {
-                        next_timestamp = e.timestamp;
-                        break;
-                    }
+                    return first; // If no next time found, return the first timestamp
                 }
-                if (next_timestamp == "")
+                if (shards.getInfo(s).first > timestamp)
+                {
+                    return shards.getInfo(s).first; // In the gap before a shard, no need to read it
+                }
+                std::shared_ptr<const BookShard> shard = shards.get(s);
+                const std::vector<std::string>& times = shard->getFrameTimes();
+                auto next = std::upper_bound(times.begin(), times.end(), timestamp);
+                if (next != times.end())
+                {
+                    return *next;
+                }
+                return s + 1 < shards.shardCount() ? shards.getInfo(s + 1).first : first;
+            }
+
+            void OrderBook::setMemoryBudget(std::size_t bytes)
+            {
+                shards.setMemoryBudget(bytes);
+            }
+
+            void OrderBook::reportMemory(MemoryReport& report) const
+            {
+                report.add("book data", shards.memoryUsage());
+                report.add("resting orders", resting.memoryUsage());
+            }
+
+            std::shared_ptr<const BookShard> OrderBook::shardFor(const std::string& timestamp, int& frame) const
+            {
+                frame = -1;
+                std::size_t s = shards.findShard(timestamp);
+                if (s == shards.shardCount() || shards.getInfo(s).first > timestamp)
                 {
-                    next_timestamp = orders[0].timestamp; // If no next time found, return the first timestamp
-                }   
-                return next_timestamp;
+                    return nullptr; // Not inside any shard
+                }
+                std::shared_ptr<const BookShard> shard = shards.get(s);
+                frame = shard->frameIndex(timestamp);
+                return shard;
             }
 
             double OrderBook::getAveragePrice(std::vector<OrderBookEntry>& orders)
             {
-                if (orders.empty())
+                return getPriceSummary(orders).average(); // 0 for an empty list
+            }
+
+            PriceSummary OrderBook::getPriceSummary(const std::vector<OrderBookEntry>& orders)
+            {
+                // gather the columns once so the kernel reads contiguous memory
+                std::vector<double> prices, amounts;
+                prices.reserve(orders.size());
+                amounts.reserve(orders.size());
+                for (const OrderBookEntry& e : orders)
+                {
+                    prices.push_back(e.price);
+                    amounts.push_back(e.amount);
+                }
+                return PriceStats::compute(prices.data(), amounts.data(), orders.size());
+            }
+
+            PriceSummary OrderBook::getPriceSummary(OrderBookType type,
+                                                    const std::string& product,
+                                                    const std::string& timestamp) const
+            {
+                PriceSummary summary{0, 0, 0, 0, 0, 0};
+                int frame;
+                std::shared_ptr<const BookShard> shard = shardFor(timestamp, frame);
+                int pid = shard ? shard->productIndex(product) : -1;
+                if (frame >= 0 && pid >= 0 &&
+                    (type == OrderBookType::bid || type == OrderBookType::ask))
                 {
-                    return 0.0; // Or throw an exception, depending on desired behavior for empty list
+                    BookShard::Slice slice = shard->getSlice(frame, pid, type);
+                    summary = PriceStats::compute(slice.prices, slice.amounts, slice.count);
                 }
-                double sum = 0.0;
-                for (OrderBookEntry& e : orders)
+
+                // the few resting user orders are summarised separately and merged in. Their columns
+                // are gathered into buffers each thread keeps, the orders themselves are not copied
+                thread_local std::vector<double> prices, amounts;
+                prices.clear();
+                amounts.clear();
+                resting.collect(type, product, timestamp, prices, amounts);
+                if (!prices.empty())
                 {
-                    sum += e.price;
+                    summary = PriceStats::merge(summary, PriceStats::compute(prices.data(), amounts.data(), prices.size()));
                 }
-                return sum / orders.size();
+                return summary;
+            }
+
+
+            unsigned int OrderBook::insertOrder(OrderBookEntry& order)
+            {
+                order.id = resting.add(order); // The order rests until it is filled or cancelled
+                return order.id;
+            }
+
+            bool OrderBook::cancelOrder(unsigned int id)
+            {
+                return resting.cancel(id);
             }
 
+            bool OrderBook::replaceOrder(unsigned int id, double price, double amount)
+            {
+                return resting.replace(id, price, amount);
+            }
+
+            const OrderBookEntry* OrderBook::findOrder(unsigned int id) const
+            {
+                return resting.find(id);
+            }
 
-            void OrderBook::insertOrder(OrderBookEntry& order)
+            std::vector<OrderBookEntry> OrderBook::getRestingOrders() const
             {
-                orders.push_back(order); // Add the new order to the order book
-                std::sort(orders.begin(), orders.end(), OrderBookEntry::compareByTimestamp);
+                return resting.getAllOrders();
             }
 
             std::vector<OrderBookEntry> OrderBook::matchAsksToBids(std::string product, std::string timestamp )
+            {
+                return matchAsksToBids(product, timestamp, resting);
+            }
+
+            std::vector<OrderBookEntry> OrderBook::matchAsksToBids(const std::string& product,
+                                                                   const std::string& timestamp,
+                                                                   RestingOrders& overlay) const
             {
                 // Separate bids and asks
                 std::vector<OrderBookEntry> asks = getOrders(OrderBookType::ask, 
                                                             product, 
-                                                            timestamp);
+                                                            timestamp,
+                                                            overlay);
 
                 std::vector<OrderBookEntry> bids = getOrders(OrderBookType::bid, 
                                                             product, 
-                                                            timestamp);
+                                                            timestamp,
+                                                            overlay);
+
+                return matchOrders(asks, bids, product, timestamp, overlay);
+            }
 
-                std::vector<OrderBookEntry> sales;
-                
-                std::sort(asks.begin(), asks.end(), OrderBookEntry::compareByPriceAsc);
+            std::vector<OrderBookEntry> OrderBook::matchAsksToBids(const std::string& product,
+                                                                   const std::string& timestamp,
+                                                                   RestingOrders& overlay,
+                                                                   MatchFunction match) const
+            {
+                std::vector<OrderBookEntry> asks = getOrders(OrderBookType::ask, product, timestamp, overlay);
+                std::vector<OrderBookEntry> bids = getOrders(OrderBookType::bid, product, timestamp, overlay);
+                return match(asks, bids, product, timestamp, overlay);
+            }
 
-                std::sort(bids.begin(), bids.end(), OrderBookEntry::compareByPriceDesc);
+            std::vector<OrderBookEntry> OrderBook::matchOrders(std::vector<OrderBookEntry>& asks,
+                                                               std::vector<OrderBookEntry>& bids,
+                                                               const std::string& product,
+                                                               const std::string& timestamp,
+                                                               RestingOrders& overlay)
+            {
+                // price-time priority at the ask price, the rule the simulation has always used
+                MatchingEngine<FifoAllocation, AskPrice, UserSales> engine;
+                std::size_t askCount = asks.size();
+                std::size_t bidCount = bids.size();
+                std::vector<OrderBookEntry> sales = engine.match(asks, bids, product, timestamp, overlay);
+                MERKEL_LOG_TRACE("OrderBook::matchOrders " << product << " " << timestamp << " asks " << askCount
+                                 << " bids " << bidCount << " sales " << sales.size());
+                return sales;
+            }
 
-                for (OrderBookEntry& ask : asks)
+            RangeSummary OrderBook::getRangeSummary(OrderBookType type,
+                                                    const std::string& product,
+                                                    const std::string& from,
+                                                    const std::string& to) const
+            {
+                RangeSummary total{0, 0, 0};
+                // only the shards that overlap the range are read
+                for (std::size_t s = shards.findShard(from);
+                     s < shards.shardCount() && shards.getInfo(s).first <= to;
+                     ++s)
                 {
-                    for (OrderBookEntry& bid : bids)
+                    std::shared_ptr<const BookShard> shard = shards.get(s);
+                    int pid = shard->productIndex(product);
+                    if (pid < 0) continue;
+                    const std::vector<std::string>& times = shard->getFrameTimes();
+                    std::size_t first = std::lower_bound(times.begin(), times.end(), from) - times.begin();
+                    std::size_t last = std::upper_bound(times.begin(), times.end(), to) - times.begin();
+                    RangeSummary part = shard->sumFrames(pid, type, first, last);
+                    total.volume += part.volume;
+                    total.notional += part.notional;
+                    total.count += part.count;
+                }
+                return total;
+            }
+
+            RangeSummary OrderBook::getRecentSummary(OrderBookType type,
+                                                     const std::string& product,
+                                                     const std::string& timestamp,
+                                                     unsigned int n) const
+            {
+                RangeSummary total{0, 0, 0};
+                // walk back from the shard holding timestamp until n frames are counted
+                std::size_t s = shards.findShard(timestamp);
+                if (s == shards.shardCount() || shards.getInfo(s).first > timestamp)
+                {
+                    if (s == 0) return total;
+                    --s;
+                }
+                std::size_t remaining = n;
+                while (remaining > 0)
+                {
+                    std::shared_ptr<const BookShard> shard = shards.get(s);
+                    const std::vector<std::string>& times = shard->getFrameTimes();
+                    std::size_t last = std::upper_bound(times.begin(), times.end(), timestamp) - times.begin();
+                    std::size_t first = last > remaining ? last - remaining : 0;
+                    int pid = shard->productIndex(product);
+                    if (pid >= 0)
+                    {
+                        RangeSummary part = shard->sumFrames(pid, type, first, last);
+                        total.volume += part.volume;
+                        total.notional += part.notional;
+                        total.count += part.count;
+                    }
+                    remaining -= last - first;
+                    if (s == 0) break;
+                    --s;
+                }
+                return total;
+            }
+
+            std::unique_ptr<const BookSnapshot> OrderBook::makeSnapshot(const std::string& timestamp, std::uint64_t version) const
+            {
+                int frame;
+                std::shared_ptr<const BookShard> shard = shardFor(timestamp, frame); // Pinned for the snapshot's lifetime
+
+                // copy the resting orders the way getOrders and getDepth see them at this frame
+                std::vector<std::string> products = getKnownProducts();
+                std::map<std::string, BookSnapshot::RestingSide> copies;
+                for (const std::string& product : products)
+                {
+                    for (OrderBookType type : {OrderBookType::bid, OrderBookType::ask})
                     {
-                        if (bid.price >= ask.price) // Match found
+                        BookSnapshot::RestingSide side;
+                        for (OrderBookEntry& e : resting.getOrders(type, product))
+                        {
+                            if (e.timestamp <= timestamp) side.orders.push_back(e);
+                        }
+                        side.levels = resting.getLevels(type, product, timestamp); // Same filter as the orders
+                        if (!side.orders.empty() || !side.levels.empty())
                         {
+                            copies[BookSnapshot::sideKey(type, product)] = std::move(side);
+                        }
+                    }
+                }
+                return std::unique_ptr<const BookSnapshot>(new BookSnapshot(version, timestamp, std::move(products),
+                                                                            std::move(shard), frame, std::move(copies)));
+            }
+
+            std::unique_ptr<const BookSnapshot> OrderBook::makeSnapshot(const std::string& timestamp,
+                                                                        std::uint64_t version,
+                                                                        const std::vector<OrderBookEntry>& restingOrders) const
+            {
+                int frame;
+                std::shared_ptr<const BookShard> shard = shardFor(timestamp, frame);
+
+                // limit orders in price-time priority, then the pending takers, as RestingOrders keeps them
+                std::vector<OrderBookEntry> sorted = restingOrders;
+                std::stable_sort(sorted.begin(), sorted.end(), [](const OrderBookEntry& a, const OrderBookEntry& b)
+                {
+                    if (a.product != b.product) return a.product < b.product;
+                    if (a.orderType != b.orderType) return a.orderType < b.orderType;
+                    bool aTaker = a.execution != OrderExecution::limit;
+                    bool bTaker = b.execution != OrderExecution::limit;
+                    if (aTaker != bTaker) return bTaker;
+                    if (aTaker || a.price == b.price) return a.id < b.id;
+                    return a.orderType == OrderBookType::bid ? a.price > b.price : a.price < b.price;
+                });
+
+                std::map<std::string, BookSnapshot::RestingSide> copies;
+                for (const OrderBookEntry& e : sorted)
+                {
+                    if (e.orderType != OrderBookType::bid && e.orderType != OrderBookType::ask) continue;
+                    if (e.timestamp > timestamp) continue; // Not entered yet at that time, as in getOrders
+                    BookSnapshot::RestingSide& side = copies[BookSnapshot::sideKey(e.orderType, e.product)];
+                    side.orders.push_back(e);
+                    if (e.execution != OrderExecution::limit) continue; // Takers never make a level
+                    if (side.levels.empty() || side.levels.back().price != e.price)
+                    {
+                        side.levels.push_back(PriceLevel{e.price, 0, 0});
+                    }
+                    side.levels.back().amount += e.amount;
+                    side.levels.back().orderCount++;
+                }
+                return std::unique_ptr<const BookSnapshot>(new BookSnapshot(version, timestamp, getKnownProducts(),
+                                                                            std::move(shard), frame, std::move(copies)));
+            }
+
+            static PriceLevel toLevel(const PriceLevel& level)
+            {
+                return level;
+            }
+
+            static PriceLevel toLevel(const std::pair<const double, RestingLevel>& level)
+            {
+                return PriceLevel{level.first, level.second.amount, level.second.count};
+            }
 
-                            
-                                OrderBookEntry sale = {
-                                ask.price, 
-                                0, 
-                                timestamp, 
-                                product, 
-                                OrderBookType::asksale};                            // Create a new sale entry
-                            if (bid.username == "simuser")
-                            {
-                                sale.username = "simuser"; // Set the username for the sale
-                                sale.orderType = OrderBookType::bidsale; // If the bid is from the simuser, it's a sale
-                            }
-                            if (ask.username == "simuser")
-                            {
-                                sale.username = "simuser"; // Set the username for the sale
-                                sale.orderType = OrderBookType::asksale; // If the ask is from the simuser, it's a sale
-                            }
-                            
-
-
-                            if (bid.amount == ask.amount)
-                            {
-                                sale.amount = ask.amount;
-                                sales.push_back(sale);
-                                bid.amount = 0;
-                                break;
-                            }                            if (bid.amount > ask.amount) 
-                            {
-                                sale.amount = ask.amount; 
-                                sales.push_back(sale);
-                                bid.amount = bid.amount - ask.amount; // Reduce the bid amount
-                                break;
-                            }
-
-                            if (bid.amount < ask.amount) 
-                            {
-                                sale.amount = bid.amount;
-                                sales.push_back(sale);
-                                ask.amount = ask.amount - bid.amount; // Reduce the ask amount
-                                bid.amount = 0;
-                                continue;  
-                            }                        }
+            /** merge the dataset levels with the resting levels, both already best first. The resting
+             *  ones are PriceLevels or the entries of a RestingOrders side, walked best first */
+            template <typename RestingIt, typename Better, typename Fn>
+            static void mergeLevels(const PriceLevel* it, const PriceLevel* end,
+                                    RestingIt rit, RestingIt rend,
+                                    Better better, Fn& fn)
+            {
+                while (it != end || rit != rend)
+                {
+                    PriceLevel level;
+                    if (rit == rend || (it != end && better(it->price, toLevel(*rit).price)))
+                    {
+                        level = *it++;
+                    }
+                    else if (it == end || better(toLevel(*rit).price, it->price))
+                    {
+                        level = toLevel(*rit++);
                     }
+                    else // same price on both sides of the merge
+                    {
+                        PriceLevel user = toLevel(*rit++);
+                        level = PriceLevel{it->price, it->amount + user.amount, it->orderCount + user.orderCount};
+                        ++it;
+                    }
+                    if (!fn(level)) return;
                 }
-                
-                return sales;
-            }
\ No newline at end of file
+            }
+
+            template <typename Fn>
+            void OrderBook::walkLevels(OrderBookType type, const std::string& product, const std::string& timestamp, Fn fn) const
+            {
+                const PriceLevel* it = nullptr;
+                const PriceLevel* end = nullptr;
+                int frame;
+                std::shared_ptr<const BookShard> shard = shardFor(timestamp, frame); // Held until the walk is done
+                int pid = shard ? shard->productIndex(product) : -1;
+                if (frame >= 0 && pid >= 0)
+                {
+                    BookShard::LevelSpan span = shard->getLevels(frame, pid, type);
+                    it = span.begin;
+                    end = span.end;
+                }
+
+                auto higher = [](double a, double b) { return a > b; };
+                auto lower = [](double a, double b) { return a < b; };
+                // the level totals as they are, unless this looks back past an order still resting
+                const std::map<double, RestingLevel>* levels = resting.getLevelsAsOf(type, product, timestamp);
+                if (levels != nullptr)
+                {
+                    if (type == OrderBookType::bid) mergeLevels(it, end, levels->rbegin(), levels->rend(), higher, fn);
+                    else mergeLevels(it, end, levels->begin(), levels->end(), lower, fn);
+                    return;
+                }
+
+                // only the resting orders entered by timestamp, the rule getOrders uses
+                std::vector<PriceLevel> user = resting.getLevels(type, product, timestamp);
+                const PriceLevel* rit = user.data();
+                const PriceLevel* rend = rit + user.size();
+                if (type == OrderBookType::bid) mergeLevels(it, end, rit, rend, higher, fn);
+                else mergeLevels(it, end, rit, rend, lower, fn);
+            }
+
+            std::vector<PriceLevel> OrderBook::getDepth(OrderBookType type,
+                                                        const std::string& product,
+                                                        const std::string& timestamp,
+                                                        unsigned int n) const
+            {
+                std::vector<PriceLevel> depth;
+                if (n == 0) return depth;
+                depth.reserve(std::min(n, 64u)); // n can be "all of them"
+                walkLevels(type, product, timestamp, [&](const PriceLevel& level)
+                {
+                    depth.push_back(level);
+                    return depth.size() < n;
+                });
+                return depth;
+            }
+
+            double OrderBook::getDepthToPrice(OrderBookType type,
+                                              const std::string& product,
+                                              const std::string& timestamp,
+                                              double price) const
+            {
+                double total = 0;
+                walkLevels(type, product, timestamp, [&](const PriceLevel& level)
+                {
+                    // bids get worse as the price goes down, asks as it goes up
+                    bool inside = type == OrderBookType::bid ? level.price >= price : level.price <= price;
+                    if (inside) total += level.amount;
+                    return inside;
+                });
+                return total;
+            }
+
+            FillEstimate OrderBook::estimateFill(OrderBookType type,
+                                                 const std::string& product,
+                                                 const std::string& timestamp,
+                                                 double amount) const
+            {
+                FillEstimate fill{0, 0, 0, 0, 0};
+                if (amount <= 0) return fill;
+                walkLevels(type, product, timestamp, [&](const PriceLevel& level)
+                {
+                    double take = std::min(level.amount, amount - fill.amount);
+                    fill.amount += take;
+                    fill.cost += take * level.price;
+                    fill.worstPrice = level.price;
+                    fill.levels++;
+                    return fill.amount < amount;
+                });
+                if (fill.amount > 0) fill.vwap = fill.cost / fill.amount;
+                return fill;
+            }
+
+            bool OrderBook::bestLevel(OrderBookType type, const std::string& product, const std::string& timestamp, PriceLevel& level) const
+            {
+                bool found = false;
+                walkLevels(type, product, timestamp, [&](const PriceLevel& l)
+                {
+                    level = l;
+                    found = true;
+                    return false; // only need the first one
+                });
+                return found;
+            }
+
+            double OrderBook::getSpread(const std::string& product, const std::string& timestamp) const
+            {
+                PriceLevel bid, ask;
+                if (!bestLevel(OrderBookType::bid, product, timestamp, bid) ||
+                    !bestLevel(OrderBookType::ask, product, timestamp, ask))
+                {
+                    return 0.0;
+                }
+                return ask.price - bid.price;
+            }
+
+            double OrderBook::getMidPrice(const std::string& product, const std::string& timestamp) const
+            {
+                PriceLevel bid, ask;
+                if (!bestLevel(OrderBookType::bid, product, timestamp, bid) ||
+                    !bestLevel(OrderBookType::ask, product, timestamp, ask))
+                {
+                    return 0.0;
+                }
+                return (bid.price + ask.price) / 2;
+            }
+
+            double OrderBook::getMicroPrice(const std::string& product, const std::string& timestamp) const
+            {
+                PriceLevel bid, ask;
+                if (!bestLevel(OrderBookType::bid, product, timestamp, bid) ||
+                    !bestLevel(OrderBookType::ask, product, timestamp, ask))
+                {
+                    return 0.0;
+                }
+                double total = bid.amount + ask.amount;
+                if (total <= 0) return (bid.price + ask.price) / 2;
+                // a big bid pushes the fair price towards the ask and the other way round
+                return (bid.price * ask.amount + ask.price * bid.amount) / total;
+            }
@@ -1,34 +1,156 @@
 #pragma once
+#include "BookSnapshot.h"
 #include "OrderBookEntry.h"
 #include "CSVReader.h"
+#include "MatchingEngine.h"
+#include "MemoryReport.h"
+#include "RestingOrders.h"
+#include "PriceLevel.h"
+#include "PriceStats.h"
+#include "ShardSet.h"
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
 class OrderBook {
     public:
-    /** construct, reading a csv data file */
+    /** construct, reading a csv data file or an OrderArchive (.mka) file. A directory or a
+     *  .manifest file is opened as a set of time shards that are read as they are needed */
         OrderBook(std::string filename);
     /** return vector of all known products in the dataset */
-        std::vector<std::string> getKnownProducts();
+        std::vector<std::string> getKnownProducts() const;
     /** return vector of Orders according to the sent filters */
         std::vector<OrderBookEntry> getOrders(OrderBookType type, 
                                                 std::string product,
-                                                std::string timestamp);
+                                                std::string timestamp) const;
 
     /** returns the earliest time in the order book  */
-    std::string getEarliestTime();
+    std::string getEarliestTime() const;
     /** returns the next time after the sent time in the order book - If there is no next timestamp wraps around to the start */
-    std::string getNextTime(std::string timestamp);
+    std::string getNextTime(std::string timestamp) const;
 
-    void insertOrder(OrderBookEntry& order);
+    /** cap the memory used by loaded shards, see ShardSet */
+    void setMemoryBudget(std::size_t bytes);
+
+    /** insert a user order, it rests in the book until filled or cancelled. Returns the new order id,
+     *  0 if RestingOrders::add refuses its price or amount */
+    unsigned int insertOrder(OrderBookEntry& order);
+    /** remove a resting order, returns false if there is no such order */
+    bool cancelOrder(unsigned int id);
+    /** change the price and amount of a resting order, returns false if there is no such order
+     *  or the new price or amount is not a finite number above zero */
+    bool replaceOrder(unsigned int id, double price, double amount);
+    /** returns the resting order with this id or nullptr */
+    const OrderBookEntry* findOrder(unsigned int id) const;
+    /** return all orders still resting in the book */
+    std::vector<OrderBookEntry> getRestingOrders() const;
+
+    /** return up to n aggregated price levels of one side, best price first.
+     *  Resting user orders are merged with the dataset orders of the frame */
+    std::vector<PriceLevel> getDepth(OrderBookType type,
+                                     const std::string& product,
+                                     const std::string& timestamp,
+                                     unsigned int n) const;
+    /** total amount on one side at prices as good as or better than the sent price */
+    double getDepthToPrice(OrderBookType type,
+                           const std::string& product,
+                           const std::string& timestamp,
+                           double price) const;
+    /** walk one side until the amount is filled - use the ask side to price a buy, the bid side to price a sell */
+    FillEstimate estimateFill(OrderBookType type,
+                              const std::string& product,
+                              const std::string& timestamp,
+                              double amount) const;
+    /** best ask minus best bid, 0 if either side is empty */
+    double getSpread(const std::string& product, const std::string& timestamp) const;
+    /** halfway between best bid and best ask, 0 if either side is empty */
+    double getMidPrice(const std::string& product, const std::string& timestamp) const;
+    /** mid price weighted towards the side with less amount on its best level */
+    double getMicroPrice(const std::string& product, const std::string& timestamp) const;
 
     std::vector<OrderBookEntry> matchAsksToBids(std::string product, std::string timestamp );
+    /** match the frame's dataset orders together with the resting orders of an overlay instead of
+     *  the book's own. Fills are written to the overlay, the book is not changed, so many runs
+     *  can share one book */
+    std::vector<OrderBookEntry> matchAsksToBids(const std::string& product,
+                                                const std::string& timestamp,
+                                                RestingOrders& overlay) const;
+    /** same as above with the matching rules of match, see MatchingRules::select */
+    std::vector<OrderBookEntry> matchAsksToBids(const std::string& product,
+                                                const std::string& timestamp,
+                                                RestingOrders& overlay,
+                                                MatchFunction match) const;
+    /** match against the book's own resting orders with any MatchingEngine, for example
+     *  one with its own Notify hook */
+    template <typename Engine>
+    std::vector<OrderBookEntry> matchWithEngine(const std::string& product, const std::string& timestamp, Engine& engine)
+    {
+        std::vector<OrderBookEntry> asks = getOrders(OrderBookType::ask, product, timestamp, resting);
+        std::vector<OrderBookEntry> bids = getOrders(OrderBookType::bid, product, timestamp, resting);
+        return engine.match(asks, bids, product, timestamp, resting);
+    }
+    /** match already fetched asks and bids of one frame. Resting orders among them (id != 0)
+     *  get their remaining amount written back to overlay. Uses FIFO allocation at the ask price */
+    static std::vector<OrderBookEntry> matchOrders(std::vector<OrderBookEntry>& asks,
+                                                   std::vector<OrderBookEntry>& bids,
+                                                   const std::string& product,
+                                                   const std::string& timestamp,
+                                                   RestingOrders& overlay);
+
+    /** price and amount statistics of one side of a product in one frame, in a single pass */
+    PriceSummary getPriceSummary(OrderBookType type,
+                                 const std::string& product,
+                                 const std::string& timestamp) const;
+    /** price and amount statistics of any batch of orders */
+    static PriceSummary getPriceSummary(const std::vector<OrderBookEntry>& orders);
+
+    /** volume, notional and order count of one side of a product over every frame
+     *  with from <= timestamp <= to. Uses prefix sums so the cost does not depend on the range */
+    RangeSummary getRangeSummary(OrderBookType type,
+                                 const std::string& product,
+                                 const std::string& from,
+                                 const std::string& to) const;
+    /** same as getRangeSummary over the last n frames up to and including timestamp */
+    RangeSummary getRecentSummary(OrderBookType type,
+                                  const std::string& product,
+                                  const std::string& timestamp,
+                                  unsigned int n) const;
 
+    /** a frozen copy of the book at timestamp that other threads can query while this
+     *  one carries on matching, see BookSnapshots. version is stored with it */
+    std::unique_ptr<const BookSnapshot> makeSnapshot(const std::string& timestamp, std::uint64_t version) const;
+    /** the same with restingOrders, for example ones kept by BookHistory, in place of the book's own.
+     *  Orders on one price level are queued by id */
+    std::unique_ptr<const BookSnapshot> makeSnapshot(const std::string& timestamp,
+                                                     std::uint64_t version,
+                                                     const std::vector<OrderBookEntry>& restingOrders) const;
+
+    /** add rows for the loaded dataset shards and the resting orders to report */
+    void reportMemory(MemoryReport& report) const;
+
+    /** the shard holding timestamp, or nullptr. frame is its index in the shard or -1.
+     *  For reading a frame's dataset orders and levels in place, without copies */
+    std::shared_ptr<const BookShard> shardFor(const std::string& timestamp, int& frame) const;
+
+    /** the following return 0 for an empty vector */
     static double getHighPrice(std::vector<OrderBookEntry>& orders);
     static double getLowPrice(std::vector<OrderBookEntry>& orders);
     static double getAveragePrice(std::vector<OrderBookEntry>& orders); // Added declaration for getAveragePrice
 
 
     private:
-        std::vector<OrderBookEntry> orders; // Holds the order book entries
-};
\ No newline at end of file
+        /** getOrders with the resting orders taken from overlay */
+        std::vector<OrderBookEntry> getOrders(OrderBookType type,
+                                              const std::string& product,
+                                              const std::string& timestamp,
+                                              const RestingOrders& overlay) const;
+        bool bestLevel(OrderBookType type, const std::string& product, const std::string& timestamp, PriceLevel& level) const;
+        /** call fn with each level of a side, best first, until it returns false. The resting
+         *  orders come from their level totals, and only a look-back past one of them scans them */
+        template <typename Fn>
+        void walkLevels(OrderBookType type, const std::string& product, const std::string& timestamp, Fn fn) const;
+
+        ShardSet shards; // The dataset orders, read and indexed one shard at a time
+        RestingOrders resting; // User orders that live across time frames
+};
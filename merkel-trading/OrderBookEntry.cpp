@@ -1,4 +1,5 @@
 #include "OrderBookEntry.h"
+#include <stdexcept>
 
 OrderBookEntry::OrderBookEntry(double price,
                                double amount,
@@ -11,7 +12,9 @@ OrderBookEntry::OrderBookEntry(double price,
       timestamp(timestamp),
       product(product),
       orderType(orderType),
-      username(username)
+      username(username),
+      id(0),
+      execution(OrderExecution::limit)
 {
 
 }
@@ -28,3 +31,35 @@ OrderBookType OrderBookEntry::stringToOrderBookType(std::string s)
     }
    return OrderBookType::unknown;
 }
+
+OrderExecution OrderBookEntry::stringToOrderExecution(std::string s)
+{
+    if (s == "limit" || s.empty())
+    {
+        return OrderExecution::limit;
+    }
+    if (s == "market")
+    {
+        return OrderExecution::market;
+    }
+    if (s == "ioc")
+    {
+        return OrderExecution::ioc;
+    }
+    if (s == "fok")
+    {
+        return OrderExecution::fok;
+    }
+    throw std::invalid_argument("unknown order execution " + s);
+}
+
+std::string OrderBookEntry::orderExecutionToString(OrderExecution execution)
+{
+    switch (execution)
+    {
+        case OrderExecution::market: return "market";
+        case OrderExecution::ioc: return "ioc";
+        case OrderExecution::fok: return "fok";
+        default: return "limit";
+    }
+}
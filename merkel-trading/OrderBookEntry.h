@@ -10,6 +10,16 @@ enum class OrderBookType
     bidsale
 };
 
+/** how long an order may live. Only limit orders ever rest in the book, the
+ *  others trade against what is there when they are matched and the rest is dropped */
+enum class OrderExecution
+{
+    limit,  // rests until filled or cancelled
+    market, // any price
+    ioc,    // immediate or cancel: up to its price, whatever can be filled
+    fok     // fill or kill: up to its price, all of it or nothing
+};
+
 class OrderBookEntry
 {
 public:
@@ -23,16 +33,19 @@ public:
     std::string username = "dataset");
 
     static OrderBookType stringToOrderBookType(std::string s);
+    /** "limit" (or empty), "market", "ioc" or "fok", throws std::invalid_argument for anything else */
+    static OrderExecution stringToOrderExecution(std::string s);
+    static std::string orderExecutionToString(OrderExecution execution);
 
-    static bool compareByTimestamp(OrderBookEntry& e1, OrderBookEntry& e2)
+    static bool compareByTimestamp(const OrderBookEntry& e1, const OrderBookEntry& e2)
     {
         return e1.timestamp < e2.timestamp;
     }
-        static bool compareByPriceAsc(OrderBookEntry& e1, OrderBookEntry& e2)
+        static bool compareByPriceAsc(const OrderBookEntry& e1, const OrderBookEntry& e2)
     {
         return e1.price < e2.price;
     }
-            static bool compareByPriceDesc(OrderBookEntry& e1, OrderBookEntry& e2)
+            static bool compareByPriceDesc(const OrderBookEntry& e1, const OrderBookEntry& e2)
     {
         return e1.price > e2.price;
     }
@@ -43,4 +56,7 @@ public:
     std::string product;
     OrderBookType orderType;
     std::string username;
+    /** assigned by the order book when the order is inserted, 0 for dataset orders */
+    unsigned int id;
+    OrderExecution execution;
 };
\ No newline at end of file
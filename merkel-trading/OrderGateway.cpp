@@ -0,0 +1,277 @@
+#include "OrderGateway.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+    const std::uint64_t LISTEN_KEY = 0;
+    const std::uint64_t WAKE_KEY = 1;
+    const std::uint64_t FIRST_CONNECTION = 2; // Epoll keys of connections start here
+    const std::size_t MAX_PENDING_BYTES = 4 << 20; // Unsent responses a client may leave before it is dropped
+    const std::size_t MAX_MESSAGES_PER_WAKEUP = 1024; // Read from one connection before the others get a turn
+
+    void fail(const std::string& what)
+    {
+        throw std::runtime_error("OrderGateway: " + what + ": " + std::strerror(errno));
+    }
+}
+
+OrderGateway::OrderGateway(const std::string& socketPath)
+    : path(socketPath), listenFd(-1), epollFd(-1), wakeFd(-1), nextConnection(FIRST_CONNECTION), stopping(false)
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        throw std::runtime_error("OrderGateway: socket path too long: " + path);
+    }
+    std::strcpy(addr.sun_path, path.c_str());
+
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) fail("socket");
+    ::unlink(path.c_str()); // Left over from an earlier run
+    if (::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(listenFd, 64) < 0)
+    {
+        ::close(listenFd);
+        fail("bind " + path);
+    }
+
+    epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0) fail("epoll");
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = LISTEN_KEY;
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    ev.data.u64 = WAKE_KEY;
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+}
+
+OrderGateway::~OrderGateway()
+{
+    for (auto& c : connections)
+    {
+        ::close(c.second.fd);
+    }
+    if (wakeFd >= 0) ::close(wakeFd);
+    if (epollFd >= 0) ::close(epollFd);
+    if (listenFd >= 0)
+    {
+        ::close(listenFd);
+        ::unlink(path.c_str());
+    }
+}
+
+void OrderGateway::run(std::function<void(std::vector<GatewayRequest>&)> onBatch)
+{
+    epoll_event events[64];
+    std::vector<GatewayRequest> batch;
+    while (true)
+    {
+        int n = ::epoll_wait(epollFd, events, 64, -1);
+        if (n < 0)
+        {
+            if (errno == EINTR) continue;
+            fail("epoll_wait");
+        }
+
+        batch.clear();
+        for (int i = 0; i < n; ++i)
+        {
+            std::uint64_t key = events[i].data.u64;
+            if (key == LISTEN_KEY)
+            {
+                accept();
+            }
+            else if (key == WAKE_KEY)
+            {
+                std::uint64_t count;
+                while (::read(wakeFd, &count, sizeof(count)) > 0) {}
+                drainOutbox(batch);
+            }
+            else if (connections.count(key) > 0)
+            {
+                if (events[i].events & (EPOLLHUP | EPOLLERR))
+                {
+                    // take what the client sent before it went away, closing once that is all read
+                    if (!read(key, batch)) close(key, batch);
+                    continue;
+                }
+                if (events[i].events & EPOLLOUT) flush(key);
+                if ((events[i].events & EPOLLIN) && connections.count(key) > 0) read(key, batch);
+            }
+        }
+        if (!batch.empty())
+        {
+            onBatch(batch); // Everything from this wakeup at once
+        }
+
+        std::lock_guard<std::mutex> lock{outboxMutex};
+        if (stopping) return;
+    }
+}
+
+void OrderGateway::accept()
+{
+    while (true)
+    {
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return; // EAGAIN once the backlog is empty
+
+        std::uint32_t id = nextConnection++;
+        connections[id] = Connection{fd, {}, {}, false};
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.u64 = id;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+bool OrderGateway::read(std::uint32_t id, std::vector<GatewayRequest>& batch)
+{
+    Connection& c = connections[id];
+    char buffer[MAX_MESSAGES_PER_WAKEUP * sizeof(GatewayMessage)];
+    std::size_t taken = 0;
+    while (taken < MAX_MESSAGES_PER_WAKEUP)
+    {
+        // never more than the share left: the partial tail is short of a message, so this
+        // can complete at most MAX_MESSAGES_PER_WAKEUP - taken more
+        std::size_t room = (MAX_MESSAGES_PER_WAKEUP - taken) * sizeof(GatewayMessage) - c.in.size();
+        ssize_t got = ::read(c.fd, buffer, room);
+        if (got == 0)
+        {
+            close(id, batch);
+            return false;
+        }
+        if (got < 0)
+        {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) close(id, batch);
+            return false;
+        }
+
+        // messages can straddle reads, keep the partial tail for next time
+        const char* data = buffer;
+        std::size_t size = got;
+        if (!c.in.empty())
+        {
+            c.in.insert(c.in.end(), buffer, buffer + got);
+            data = c.in.data();
+            size = c.in.size();
+        }
+        std::size_t whole = size / sizeof(GatewayMessage);
+        for (std::size_t m = 0; m < whole; ++m)
+        {
+            GatewayRequest request;
+            request.connection = id;
+            std::memcpy(&request.message, data + m * sizeof(GatewayMessage), sizeof(GatewayMessage));
+            batch.push_back(request);
+        }
+        taken += whole;
+        std::vector<char> rest(data + whole * sizeof(GatewayMessage), data + size);
+        c.in.swap(rest);
+    }
+    return true; // The share is used up, epoll reports the rest next time
+}
+
+void OrderGateway::close(std::uint32_t id, std::vector<GatewayRequest>& batch)
+{
+    auto it = connections.find(id);
+    if (it == connections.end()) return;
+    ::epoll_ctl(epollFd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    ::close(it->second.fd);
+    connections.erase(it);
+
+    GatewayRequest gone{};
+    gone.connection = id;
+    gone.message.type = GatewayMessageType::disconnect;
+    batch.push_back(gone);
+}
+
+void OrderGateway::flush(std::uint32_t id)
+{
+    Connection& c = connections[id];
+    std::size_t sent = 0;
+    while (sent < c.out.size())
+    {
+        ssize_t n = ::write(c.fd, c.out.data() + sent, c.out.size() - sent);
+        if (n < 0)
+        {
+            if (errno == EINTR) continue;
+            break; // EAGAIN, or an error the next read will see
+        }
+        sent += n;
+    }
+    c.out.erase(c.out.begin(), c.out.begin() + sent);
+
+    // only ask for EPOLLOUT while there is something left to write
+    bool waiting = !c.out.empty();
+    if (waiting != c.writing)
+    {
+        c.writing = waiting;
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP | (waiting ? static_cast<std::uint32_t>(EPOLLOUT) : 0u);
+        ev.data.u64 = id;
+        ::epoll_ctl(epollFd, EPOLL_CTL_MOD, c.fd, &ev);
+    }
+}
+
+void OrderGateway::drainOutbox(std::vector<GatewayRequest>& batch)
+{
+    std::vector<GatewayResponse> responses;
+    {
+        std::lock_guard<std::mutex> lock{outboxMutex};
+        responses.swap(outbox);
+    }
+
+    // gather per connection so each gets one write
+    std::vector<std::uint32_t> touched;
+    for (const GatewayResponse& r : responses)
+    {
+        auto it = connections.find(r.connection);
+        if (it == connections.end()) continue; // Client has gone
+        touched.push_back(r.connection);
+        const char* bytes = reinterpret_cast<const char*>(&r.message);
+        it->second.out.insert(it->second.out.end(), bytes, bytes + sizeof(GatewayMessage));
+    }
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    for (std::uint32_t id : touched)
+    {
+        flush(id);
+        // a client that stopped reading would otherwise hold any amount of memory
+        if (connections[id].out.size() > MAX_PENDING_BYTES) close(id, batch);
+    }
+}
+
+void OrderGateway::send(std::vector<GatewayResponse>& responses)
+{
+    if (responses.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock{outboxMutex};
+        outbox.insert(outbox.end(), responses.begin(), responses.end());
+    }
+    std::uint64_t one = 1;
+    ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+    (void)ignored;
+}
+
+void OrderGateway::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock{outboxMutex};
+        stopping = true;
+    }
+    std::uint64_t one = 1;
+    ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+    (void)ignored;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "GatewayProtocol.h"
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/** A message from one client connection */
+struct GatewayRequest
+{
+    std::uint32_t connection;
+    GatewayMessage message;
+};
+
+/** A message for one client connection */
+struct GatewayResponse
+{
+    std::uint32_t connection;
+    GatewayMessage message;
+};
+
+/**
+ * Single threaded epoll reactor on a Unix domain stream socket.
+ *
+ * run() accepts clients, reads whole GatewayMessages from every readable
+ * socket and hands everything that arrived in one wakeup to onBatch as a
+ * single batch. Each connection gives at most a fixed number of messages
+ * per wakeup, so one busy client cannot starve the others; epoll is level
+ * triggered and reports it again with the rest. Responses can be sent from any thread: they are queued,
+ * the reactor is woken through an eventfd and writes them out, buffering
+ * per connection when a client reads slowly. A client that leaves more
+ * than a few megabytes unread is disconnected, like one that hung up.
+ */
+class OrderGateway
+{
+    public:
+        /** bind and listen on socketPath, replacing a stale socket file.
+         *  Throws std::runtime_error if the socket cannot be set up */
+        OrderGateway(const std::string& socketPath);
+        ~OrderGateway();
+        OrderGateway(const OrderGateway&) = delete;
+        OrderGateway& operator=(const OrderGateway&) = delete;
+
+        /** run the reactor on this thread until stop() is called */
+        void run(std::function<void(std::vector<GatewayRequest>&)> onBatch);
+
+        /** queue responses for their connections, safe from any thread */
+        void send(std::vector<GatewayResponse>& responses);
+
+        /** make run() return, safe from any thread */
+        void stop();
+
+    private:
+        struct Connection
+        {
+            int fd;
+            std::vector<char> in;  // Bytes of a message not yet complete
+            std::vector<char> out; // Bytes the socket would not take yet
+            bool writing;          // Waiting for EPOLLOUT
+        };
+
+        void accept();
+        /** read up to a wakeup's share of messages, true if it stopped with more to read */
+        bool read(std::uint32_t id, std::vector<GatewayRequest>& batch);
+        void flush(std::uint32_t id);
+        void close(std::uint32_t id, std::vector<GatewayRequest>& batch);
+        /** write queued responses, dropping clients with too much left unsent */
+        void drainOutbox(std::vector<GatewayRequest>& batch);
+
+        std::string path;
+        int listenFd;
+        int epollFd;
+        int wakeFd;   // eventfd, written by send and stop
+        std::map<std::uint32_t, Connection> connections;
+        std::uint32_t nextConnection;
+
+        std::mutex outboxMutex; // Guards outbox and stopping
+        std::vector<GatewayResponse> outbox;
+        bool stopping;
+};
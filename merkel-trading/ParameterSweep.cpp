@@ -0,0 +1,127 @@
+#include "ParameterSweep.h"
+#include "CSVReader.h"
+#include "Log.h"
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+ParameterSweep::ParameterSweep(const OrderBook& book) : book(book)
+{
+
+}
+
+std::vector<BacktestResult> ParameterSweep::run(const std::vector<StrategyConfig>& configs,
+                                                const Wallet& wallet,
+                                                unsigned int threads)
+{
+    std::vector<BacktestResult> results(configs.size());
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    if (threads > configs.size()) threads = configs.size();
+
+    // Each worker takes the next config until they are all done
+    std::atomic<std::size_t> next{0};
+    auto worker = [&]()
+    {
+        for (std::size_t i = next++; i < configs.size(); i = next++)
+        {
+            Backtest backtest{book, configs[i], wallet};
+            results[i] = backtest.run();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned int t = 1; t < threads; ++t)
+    {
+        pool.emplace_back(worker);
+    }
+    worker(); // This thread works too
+    for (std::thread& t : pool)
+    {
+        t.join();
+    }
+    return results;
+}
+
+std::vector<StrategyConfig> ParameterSweep::readConfigs(std::string filename)
+{
+    std::vector<StrategyConfig> configs;
+    std::ifstream file{filename};
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::vector<std::string> tokens = CSVReader::tokenise(line, ',');
+        if (tokens.size() < 4 || tokens.size() > 6) continue;
+        try
+        {
+            StrategyConfig config{tokens[0], tokens[1], std::stod(tokens[2]), std::stod(tokens[3])};
+            if (tokens.size() >= 5 && !MatchingRules::parse(tokens[4], config.allocation, config.tradePrice))
+            {
+                throw std::invalid_argument{"matching rules"};
+            }
+            if (tokens.size() == 6)
+            {
+                config.arbitragePause = std::stod(tokens[5]);
+            }
+            configs.push_back(config);
+        }
+        catch (const std::exception& e)
+        {
+            MERKEL_LOG_WARN("ParameterSweep::readConfigs bad line: " << line);
+        }
+    }
+    return configs;
+}
+
+std::vector<StrategyConfig> ParameterSweep::defaultGrid(const OrderBook& book)
+{
+    std::vector<StrategyConfig> configs;
+    for (const std::string& product : book.getKnownProducts())
+    {
+        for (double edge : {-0.002, -0.001, 0.0005, 0.001}) // negative edges cross the spread
+        {
+            for (double size : {0.1, 1.0})
+            {
+                std::ostringstream name;
+                name << product << " e" << edge << " s" << size;
+                configs.push_back(StrategyConfig{name.str(), product, edge, size});
+            }
+        }
+    }
+    return configs;
+}
+
+std::string ParameterSweep::formatResults(const std::vector<BacktestResult>& results)
+{
+    std::ostringstream out;
+    out << std::left << std::setw(28) << "Run"
+        << std::right << std::setw(8) << "Frames"
+        << std::setw(8) << "Orders"
+        << std::setw(8) << "Fills"
+        << std::setw(8) << "Refused"
+        << std::setw(14) << "Volume"
+        << std::setw(16) << "Start value"
+        << std::setw(16) << "End value"
+        << std::setw(14) << "PnL"
+        << std::setw(14) << "Realized"
+        << std::setw(14) << "Drawdown" << "\n";
+    for (const BacktestResult& r : results)
+    {
+        out << std::left << std::setw(28) << r.config.name
+            << std::right << std::setw(8) << r.frames
+            << std::setw(8) << r.ordersPlaced
+            << std::setw(8) << r.fills
+            << std::setw(8) << r.refusedFills
+            << std::setw(14) << r.volume
+            << std::setw(16) << r.startValue
+            << std::setw(16) << r.endValue
+            << std::setw(14) << r.endValue - r.startValue
+            << std::setw(14) << r.realizedPnl
+            << std::setw(14) << r.maxDrawdown << "\n";
+    }
+    return out.str();
+}
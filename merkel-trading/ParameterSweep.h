@@ -0,0 +1,36 @@
+#pragma once
+#include "Backtest.h"
+#include "OrderBook.h"
+#include "Wallet.h"
+#include <string>
+#include <vector>
+
+/**
+ * Runs many strategy configurations over one order book that is loaded
+ * and indexed once. The book is only read, every run has its own wallet
+ * and resting orders, so the runs go in parallel on a pool of threads.
+ */
+class ParameterSweep
+{
+    public:
+        ParameterSweep(const OrderBook& book);
+
+        /** run every config starting from a copy of wallet, results come back in config order.
+         *  threads = 0 uses one thread per core */
+        std::vector<BacktestResult> run(const std::vector<StrategyConfig>& configs,
+                                        const Wallet& wallet,
+                                        unsigned int threads = 0);
+
+        /** read configs from a csv file with lines name,product,edge,orderSize[,matching[,arbitragePause]]
+         *  where matching is allocation/price as read by MatchingRules::parse, fifo/ask if left out */
+        static std::vector<StrategyConfig> readConfigs(std::string filename);
+
+        /** a grid of edges and order sizes over every product in the book */
+        static std::vector<StrategyConfig> defaultGrid(const OrderBook& book);
+
+        /** format results as a table, one row per run */
+        static std::string formatResults(const std::vector<BacktestResult>& results);
+
+    private:
+        const OrderBook& book;
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+/** One aggregated price level of a book side */
+struct PriceLevel
+{
+    double price;
+    double amount;  // total amount of all orders at this price
+    int orderCount;
+};
+
+/** What it would take to fill an amount against one side of the book */
+struct FillEstimate
+{
+    double amount;     // how much could be filled, less than asked for if the book runs out
+    double cost;       // sum of price * amount over the levels used
+    double vwap;       // cost / amount, 0 if nothing could be filled
+    double worstPrice; // price of the last level touched
+    int levels;        // number of levels touched
+};
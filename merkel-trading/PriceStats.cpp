@@ -0,0 +1,139 @@
+#include "PriceStats.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PRICESTATS_X86 1
+#endif
+
+PriceSummary PriceStats::compute(const double* prices, const double* amounts, std::size_t n)
+{
+    // Choose the kernel once, the cpu does not change under us
+    static PriceSummary (*const kernel)(const double*, const double*, std::size_t) =
+        hasAVX2() ? &PriceStats::computeAVX2 : &PriceStats::computeScalar;
+    return kernel(prices, amounts, n);
+}
+
+PriceSummary PriceStats::merge(const PriceSummary& a, const PriceSummary& b)
+{
+    if (a.count == 0) return b;
+    if (b.count == 0) return a;
+    PriceSummary s;
+    s.count = a.count + b.count;
+    s.low = a.low < b.low ? a.low : b.low;
+    s.high = a.high > b.high ? a.high : b.high;
+    s.sum = a.sum + b.sum;
+    s.amount = a.amount + b.amount;
+    s.notional = a.notional + b.notional;
+    return s;
+}
+
+PriceSummary PriceStats::computeScalar(const double* prices, const double* amounts, std::size_t n)
+{
+    PriceSummary s{0, 0, 0, 0, 0, 0};
+    if (n == 0) return s;
+
+    double low = prices[0], high = prices[0];
+    double sum = 0, amount = 0, notional = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        double p = prices[i];
+        if (p < low) low = p;
+        if (p > high) high = p;
+        sum += p;
+        amount += amounts[i];
+        notional += p * amounts[i];
+    }
+    s.count = n;
+    s.low = low;
+    s.high = high;
+    s.sum = sum;
+    s.amount = amount;
+    s.notional = notional;
+    return s;
+}
+
+#ifdef PRICESTATS_X86
+
+/** add up the 4 lanes of a register */
+__attribute__((target("avx2")))
+static double horizontalSum(__m256d v)
+{
+    __m128d lo = _mm256_castpd256_pd128(v);
+    __m128d hi = _mm256_extractf128_pd(v, 1);
+    lo = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+__attribute__((target("avx2")))
+PriceSummary PriceStats::computeAVX2(const double* prices, const double* amounts, std::size_t n)
+{
+    if (n < 4) return computeScalar(prices, amounts, n);
+
+    __m256d vlow = _mm256_set1_pd(prices[0]);
+    __m256d vhigh = vlow;
+    __m256d vsum = _mm256_setzero_pd();
+    __m256d vamount = _mm256_setzero_pd();
+    __m256d vnotional = _mm256_setzero_pd();
+
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d p = _mm256_loadu_pd(prices + i);
+        __m256d a = _mm256_loadu_pd(amounts + i);
+        vlow = _mm256_min_pd(vlow, p);
+        vhigh = _mm256_max_pd(vhigh, p);
+        vsum = _mm256_add_pd(vsum, p);
+        vamount = _mm256_add_pd(vamount, a);
+        vnotional = _mm256_add_pd(vnotional, _mm256_mul_pd(p, a));
+    }
+
+    alignas(32) double lows[4];
+    alignas(32) double highs[4];
+    _mm256_store_pd(lows, vlow);
+    _mm256_store_pd(highs, vhigh);
+
+    PriceSummary s;
+    s.count = n;
+    s.low = lows[0];
+    s.high = highs[0];
+    for (int lane = 1; lane < 4; ++lane)
+    {
+        if (lows[lane] < s.low) s.low = lows[lane];
+        if (highs[lane] > s.high) s.high = highs[lane];
+    }
+    s.sum = horizontalSum(vsum);
+    s.amount = horizontalSum(vamount);
+    s.notional = horizontalSum(vnotional);
+
+    // Leftovers that do not fill a register
+    for (; i < n; ++i)
+    {
+        double p = prices[i];
+        if (p < s.low) s.low = p;
+        if (p > s.high) s.high = p;
+        s.sum += p;
+        s.amount += amounts[i];
+        s.notional += p * amounts[i];
+    }
+    return s;
+}
+
+bool PriceStats::hasAVX2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+PriceSummary PriceStats::computeAVX2(const double* prices, const double* amounts, std::size_t n)
+{
+    return computeScalar(prices, amounts, n); // No AVX2 on this platform
+}
+
+bool PriceStats::hasAVX2()
+{
+    return false;
+}
+
+#endif
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+
+/** Price and amount statistics of a batch of orders */
+struct PriceSummary
+{
+    std::size_t count;
+    double low;      // 0 when count is 0
+    double high;     // 0 when count is 0
+    double sum;      // sum of the prices
+    double amount;   // sum of the amounts
+    double notional; // sum of price * amount
+
+    /** mean price, 0 for an empty batch */
+    double average() const { return count == 0 ? 0.0 : sum / count; }
+    /** amount weighted mean price, 0 if there is no amount */
+    double vwap() const { return amount == 0 ? 0.0 : notional / amount; }
+};
+
+/** Totals of one side of a product over a range of frames */
+struct RangeSummary
+{
+    double volume;   // sum of the amounts
+    double notional; // sum of price * amount
+    std::size_t count;
+
+    /** amount weighted mean price over the range, 0 if there is no volume */
+    double vwap() const { return volume == 0 ? 0.0 : notional / volume; }
+};
+
+/**
+ * Single pass min/max/sum/count/VWAP kernels over price and amount columns.
+ * compute picks the AVX2 version at runtime when the cpu supports it,
+ * the scalar version otherwise.
+ */
+class PriceStats
+{
+    public:
+        /** summarise n prices and their amounts, both arrays laid out contiguously */
+        static PriceSummary compute(const double* prices, const double* amounts, std::size_t n);
+
+        /** combine the summaries of two batches */
+        static PriceSummary merge(const PriceSummary& a, const PriceSummary& b);
+
+        static PriceSummary computeScalar(const double* prices, const double* amounts, std::size_t n);
+        static PriceSummary computeAVX2(const double* prices, const double* amounts, std::size_t n);
+
+        /** true if this build has an AVX2 kernel and the cpu can run it */
+        static bool hasAVX2();
+};
@@ -0,0 +1,30 @@
+#include "QuotingAgent.h"
+
+QuotingAgent::QuotingAgent(StrategyConfig config, std::int64_t interval)
+    : config(config), interval(interval), ordersPlaced(0), fills(0), volume(0), position(0)
+{
+
+}
+
+void QuotingAgent::onWakeup(EventSimulator& sim, unsigned int agent)
+{
+    double bid, ask;
+    if (sim.bestPrice(OrderBookType::bid, config.product, bid) &&
+        sim.bestPrice(OrderBookType::ask, config.product, ask))
+    {
+        double mid = (bid + ask) / 2;
+        OrderBookEntry buy{mid * (1 - config.edge), config.orderSize, "", config.product, OrderBookType::bid, "simuser"};
+        OrderBookEntry sell{mid * (1 + config.edge), config.orderSize, "", config.product, OrderBookType::ask, "simuser"};
+        sim.submit(agent, buy, interval);
+        sim.submit(agent, sell, interval);
+        ordersPlaced += 2;
+    }
+    sim.wakeAt(agent, sim.now() + interval);
+}
+
+void QuotingAgent::onFill(EventSimulator&, unsigned int, const OrderBookEntry& fill)
+{
+    fills++;
+    volume += fill.amount;
+    position += fill.orderType == OrderBookType::bidsale ? fill.amount : -fill.amount;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "Backtest.h"
+#include "EventSimulator.h"
+#include <cstdint>
+
+/**
+ * The built-in quoting strategy as a continuous time agent: every interval
+ * it quotes one bid and one ask around the mid of the best prices it sees,
+ * each living for one interval. Its orders reach the book, and its fills
+ * reach it, after the latency it was added to the simulator with.
+ */
+class QuotingAgent : public SimAgent
+{
+    public:
+        QuotingAgent(StrategyConfig config, std::int64_t interval);
+
+        void onWakeup(EventSimulator& sim, unsigned int agent) override;
+        void onFill(EventSimulator& sim, unsigned int agent, const OrderBookEntry& fill) override;
+
+        unsigned int getOrdersPlaced() const { return ordersPlaced; }
+        unsigned int getFills() const { return fills; }
+        double getVolume() const { return volume; }
+        double getPosition() const { return position; } // Base currency bought minus sold
+
+    private:
+        StrategyConfig config;
+        std::int64_t interval; // Microseconds between quotes
+        unsigned int ordersPlaced;
+        unsigned int fills;
+        double volume;
+        double position;
+};
@@ -0,0 +1,157 @@
+#include "ReportWriter.h"
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+
+ReportWriter::ReportWriter(std::ostream& out, ReportFormat format, bool background, std::size_t bufferBytes)
+    : out(out),
+      format(format),
+      bufferBytes(bufferBytes < 4096 ? 4096 : bufferBytes),
+      buffer(this->bufferBytes),
+      used(0),
+      background(background),
+      full(poolSize),
+      written(poolSize)
+{
+    if (!background) return;
+    for (std::size_t i = 1; i < poolSize; ++i)
+    {
+        written.push(std::vector<char>(this->bufferBytes));
+    }
+    writer = std::thread{[this]()
+    {
+        std::vector<char> b;
+        while (full.pop(b))
+        {
+            this->out.write(b.data(), b.size());
+            b.resize(this->bufferBytes);
+            written.push(std::move(b));
+        }
+    }};
+}
+
+ReportWriter::~ReportWriter()
+{
+    flush();
+    if (background)
+    {
+        full.close();
+        writer.join();
+    }
+}
+
+void ReportWriter::trade(const OrderBookEntry& sale)
+{
+    double values[2] = {sale.price, sale.amount};
+    row(1, OrderBookType::unknown, sale.timestamp, sale.product, values, 2);
+}
+
+void ReportWriter::fill(const OrderBookEntry& sale)
+{
+    double values[2] = {sale.price, sale.amount};
+    row(2, sale.orderType == OrderBookType::bidsale ? OrderBookType::bid : OrderBookType::ask,
+        sale.timestamp, sale.product, values, 2);
+}
+
+void ReportWriter::wallet(const std::string& timestamp, const WalletValuation& valuation)
+{
+    double values[4] = {valuation.value, valuation.realized, valuation.unrealized, valuation.drawdown};
+    row(3, OrderBookType::unknown, timestamp, "wallet", values, 4);
+}
+
+void ReportWriter::row(char kind, OrderBookType side, const std::string& timestamp, const std::string& product,
+                       const double* values, std::size_t count)
+{
+    reserve(timestamp.size() + product.size() + 16 + count * 32);
+    if (format == ReportFormat::binary)
+    {
+        char header[6];
+        header[0] = kind;
+        header[1] = side == OrderBookType::bid ? 1 : side == OrderBookType::ask ? 2 : 0;
+        std::uint16_t lengths[2] = {static_cast<std::uint16_t>(timestamp.size()), static_cast<std::uint16_t>(product.size())};
+        std::memcpy(header + 2, lengths, sizeof(lengths));
+        put(header, sizeof(header));
+        put(timestamp.data(), timestamp.size());
+        put(product.data(), product.size());
+        put(reinterpret_cast<const char*>(values), count * sizeof(double));
+        return;
+    }
+
+    put(timestamp.data(), timestamp.size());
+    put(",", 1);
+    put(product.data(), product.size());
+    if (kind == 1) put(",trade", 6);
+    if (kind == 2) put(side == OrderBookType::bid ? ",bidsale" : ",asksale", 8);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        put(",", 1);
+        put(values[i]);
+    }
+    put("\n", 1);
+}
+
+void ReportWriter::put(const char* data, std::size_t size)
+{
+    std::memcpy(buffer.data() + used, data, size);
+    used += size;
+}
+
+void ReportWriter::put(double value)
+{
+    // shortest text that reads back as the same double
+    std::to_chars_result r = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value);
+    used = r.ptr - buffer.data();
+}
+
+void ReportWriter::reserve(std::size_t bytes)
+{
+    if (used + bytes > buffer.size())
+    {
+        handOff();
+        if (bytes > buffer.size()) buffer.resize(bytes); // A row bigger than a whole buffer
+    }
+}
+
+void ReportWriter::handOff()
+{
+    if (used == 0) return;
+    if (!background)
+    {
+        out.write(buffer.data(), used);
+        used = 0;
+        return;
+    }
+    buffer.resize(used);
+    full.push(std::move(buffer));
+    written.pop(buffer); // Waits only if the writer thread is a whole pool behind
+    used = 0;
+}
+
+MemoryUsage ReportWriter::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.tape = buffer.capacity();
+    if (background) usage.tape += (poolSize - 1) * bufferBytes;
+    return usage;
+}
+
+void ReportWriter::flush()
+{
+    handOff();
+    if (background)
+    {
+        // every buffer back means everything has been written
+        std::vector<std::vector<char>> spare;
+        for (std::size_t i = 1; i < poolSize; ++i)
+        {
+            std::vector<char> b;
+            written.pop(b);
+            spare.push_back(std::move(b));
+        }
+        for (std::vector<char>& b : spare)
+        {
+            written.push(std::move(b));
+        }
+    }
+    out.flush();
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "Channel.h"
+#include "MemoryUsage.h"
+#include "OrderBookEntry.h"
+#include "Wallet.h"
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class ReportFormat
+{
+    csv,    // one line per row, see ReportWriter
+    binary  // one record per row, see ReportWriter
+};
+
+/**
+ * Buffered writer for trade, fill and wallet history reports.
+ *
+ * Rows are formatted with std::to_chars straight into a large buffer that
+ * goes to the stream only when it is full, on flush, or when the writer
+ * is destroyed. With background set, full buffers are handed to a writer
+ * thread through a Channel and come back for reuse once written, so the
+ * caller only formats.
+ *
+ * CSV rows:
+ *   timestamp,product,trade,price,amount
+ *   timestamp,product,bidsale|asksale,price,amount    (a fill)
+ *   timestamp,wallet,value,realized,unrealized,drawdown
+ *
+ * Binary records, host byte order: kind (1 trade, 2 fill, 3 wallet),
+ * side (0 none, 1 bid, 2 ask), 16 bit timestamp and product lengths, the
+ * two strings, then price and amount, or value, realized, unrealized and
+ * drawdown for a wallet row, as doubles.
+ */
+class ReportWriter
+{
+    public:
+        ReportWriter(std::ostream& out, ReportFormat format = ReportFormat::csv,
+                     bool background = false, std::size_t bufferBytes = 1 << 20);
+        /** flushes, and stops the writer thread */
+        ~ReportWriter();
+        ReportWriter(const ReportWriter&) = delete;
+        ReportWriter& operator=(const ReportWriter&) = delete;
+
+        /** a trade in the market */
+        void trade(const OrderBookEntry& sale);
+        /** a trade of ours, sale is a bidsale or an asksale */
+        void fill(const OrderBookEntry& sale);
+        /** the wallet's valuation at a time */
+        void wallet(const std::string& timestamp, const WalletValuation& valuation);
+
+        /** write out everything so far and flush the stream */
+        void flush();
+
+        /** the buffers, counted as tape. Buffers with the writer thread are taken at full size */
+        MemoryUsage memoryUsage() const;
+
+    private:
+        /** make room for a row of about bytes, handing the buffer on if it is too full */
+        void reserve(std::size_t bytes);
+        /** hand the buffer to the stream or the writer thread and start an empty one */
+        void handOff();
+        void row(char kind, OrderBookType side, const std::string& timestamp, const std::string& product,
+                 const double* values, std::size_t count);
+        void put(const char* data, std::size_t size);
+        void put(double value);
+
+        std::ostream& out;
+        ReportFormat format;
+        std::size_t bufferBytes;
+        std::vector<char> buffer;
+        std::size_t used;
+
+        // background writing: full buffers go out, written ones come back
+        static const std::size_t poolSize = 3;
+        bool background;
+        Channel<std::vector<char>> full;
+        Channel<std::vector<char>> written;
+        std::thread writer;
+};
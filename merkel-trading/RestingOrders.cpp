@@ -0,0 +1,332 @@
+#include "RestingOrders.h"
+#include <algorithm>
+
+RestingOrders::RestingOrders() : nextId(1)
+{
+
+}
+
+unsigned int RestingOrders::add(OrderBookEntry order)
+{
+    bool priced = order.execution == OrderExecution::market ? std::isfinite(order.price) : valid(order.price);
+    if (!priced || !valid(order.amount))
+    {
+        return 0;
+    }
+    order.id = nextId++;
+    if (order.execution != OrderExecution::limit)
+    {
+        takers.push_back(order); // Never linked into a level
+        return order.id;
+    }
+    OrderNode* node = allocate(order);
+    link(node);
+    nodesById[order.id] = node;
+    return order.id;
+}
+
+bool RestingOrders::cancel(unsigned int id)
+{
+    auto it = nodesById.find(id);
+    if (it == nodesById.end())
+    {
+        return removeTaker(id); // Not resting, maybe a pending taker or already filled
+    }
+    OrderNode* node = it->second;
+    unlink(node);
+    nodesById.erase(it);
+    freeNodes.push_back(node); // Keep the node for the next add
+    return true;
+}
+
+bool RestingOrders::replace(unsigned int id, double price, double amount)
+{
+    auto it = nodesById.find(id);
+    if (it == nodesById.end() || !valid(price) || !valid(amount))
+    {
+        return false;
+    }
+    OrderNode* node = it->second;
+    if (price == node->order.price && amount <= node->order.amount)
+    {
+        // Reducing size keeps the place in the queue
+        node->level->amount -= node->order.amount - amount;
+        node->order.amount = amount;
+        return true;
+    }
+    // Anything else goes to the back of the (new) level
+    unlink(node);
+    node->order.price = price;
+    node->order.amount = amount;
+    link(node);
+    return true;
+}
+
+void RestingOrders::updateAmount(unsigned int id, double amount)
+{
+    auto it = nodesById.find(id);
+    if (it == nodesById.end())
+    {
+        removeTaker(id);
+        return;
+    }
+    OrderNode* node = it->second;
+    if (amount <= 0)
+    {
+        cancel(id); // Fully filled
+        return;
+    }
+    node->level->amount -= node->order.amount - amount;
+    node->order.amount = amount;
+}
+
+const OrderBookEntry* RestingOrders::find(unsigned int id) const
+{
+    auto it = nodesById.find(id);
+    if (it == nodesById.end())
+    {
+        for (const OrderBookEntry& e : takers)
+        {
+            if (e.id == id) return &e;
+        }
+        return nullptr;
+    }
+    return &it->second->order;
+}
+
+std::vector<OrderBookEntry> RestingOrders::getOrders(OrderBookType type, const std::string& product) const
+{
+    std::vector<OrderBookEntry> result;
+    std::string key = product + (type == OrderBookType::bid ? "|bid" : "|ask");
+    auto sideIt = sides.find(key);
+    if (sideIt != sides.end())
+    {
+        const Side& side = sideIt->second.levels;
+        if (type == OrderBookType::bid)
+        {
+            // Best bid is the highest price
+            for (auto lvl = side.rbegin(); lvl != side.rend(); ++lvl)
+            {
+                for (OrderNode* n = lvl->second.head; n != nullptr; n = n->next)
+                {
+                    result.push_back(n->order);
+                }
+            }
+        }
+        else
+        {
+            for (auto lvl = side.begin(); lvl != side.end(); ++lvl)
+            {
+                for (OrderNode* n = lvl->second.head; n != nullptr; n = n->next)
+                {
+                    result.push_back(n->order);
+                }
+            }
+        }
+    }
+    for (const OrderBookEntry& e : takers)
+    {
+        if (e.orderType == type && e.product == product) result.push_back(e);
+    }
+    return result;
+}
+
+const std::map<double, RestingLevel>* RestingOrders::getLevels(OrderBookType type, const std::string& product) const
+{
+    auto sideIt = sides.find(product + (type == OrderBookType::bid ? "|bid" : "|ask"));
+    if (sideIt == sides.end() || sideIt->second.levels.empty())
+    {
+        return nullptr;
+    }
+    return &sideIt->second.levels;
+}
+
+const std::map<double, RestingLevel>* RestingOrders::getLevelsAsOf(OrderBookType type,
+                                                                   const std::string& product,
+                                                                   const std::string& timestamp) const
+{
+    auto sideIt = sides.find(product + (type == OrderBookType::bid ? "|bid" : "|ask"));
+    if (sideIt == sides.end() || sideIt->second.levels.empty() || timestamp < sideIt->second.newest)
+    {
+        return nullptr;
+    }
+    return &sideIt->second.levels;
+}
+
+std::vector<PriceLevel> RestingOrders::getLevels(OrderBookType type, const std::string& product, const std::string& timestamp) const
+{
+    std::vector<PriceLevel> levels;
+    const Side* side = getLevelsAsOf(type, product, timestamp);
+    if (side != nullptr)
+    {
+        levels.reserve(side->size());
+        auto add = [&](const RestingLevel& lvl) { levels.push_back(PriceLevel{lvl.price, lvl.amount, lvl.count}); };
+        if (type == OrderBookType::bid)
+        {
+            for (auto lvl = side->rbegin(); lvl != side->rend(); ++lvl) add(lvl->second);
+        }
+        else
+        {
+            for (auto lvl = side->begin(); lvl != side->end(); ++lvl) add(lvl->second);
+        }
+        return levels;
+    }
+    side = getLevels(type, product);
+    if (side == nullptr) return levels;
+    auto add = [&](const RestingLevel& lvl)
+    {
+        PriceLevel level{lvl.price, 0, 0};
+        for (OrderNode* n = lvl.head; n != nullptr; n = n->next)
+        {
+            if (n->order.timestamp > timestamp) continue; // Not entered yet at that time
+            level.amount += n->order.amount;
+            level.orderCount++;
+        }
+        if (level.orderCount > 0) levels.push_back(level);
+    };
+    if (type == OrderBookType::bid)
+    {
+        for (auto lvl = side->rbegin(); lvl != side->rend(); ++lvl) add(lvl->second);
+    }
+    else
+    {
+        for (auto lvl = side->begin(); lvl != side->end(); ++lvl) add(lvl->second);
+    }
+    return levels;
+}
+
+void RestingOrders::collect(OrderBookType type, const std::string& product, const std::string& timestamp,
+                            std::vector<double>& prices, std::vector<double>& amounts) const
+{
+    auto add = [&](const OrderBookEntry& e)
+    {
+        if (e.timestamp > timestamp) return;
+        prices.push_back(e.price);
+        amounts.push_back(e.amount);
+    };
+    if (const Side* side = getLevels(type, product))
+    {
+        for (const auto& lvl : *side)
+        {
+            for (OrderNode* n = lvl.second.head; n != nullptr; n = n->next) add(n->order);
+        }
+    }
+    for (const OrderBookEntry& e : takers)
+    {
+        if (e.orderType == type && e.product == product) add(e);
+    }
+}
+
+std::vector<OrderBookEntry> RestingOrders::getAllOrders() const
+{
+    std::vector<OrderBookEntry> result;
+    for (auto const& e : nodesById)
+    {
+        result.push_back(e.second->order);
+    }
+    result.insert(result.end(), takers.begin(), takers.end());
+    std::sort(result.begin(), result.end(), [](const OrderBookEntry& a, const OrderBookEntry& b)
+    {
+        return a.id < b.id;
+    });
+    return result;
+}
+
+bool RestingOrders::removeTaker(unsigned int id)
+{
+    for (auto it = takers.begin(); it != takers.end(); ++it)
+    {
+        if (it->id == id)
+        {
+            takers.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+RestingOrders::SideLevels& RestingOrders::sideFor(OrderBookType type, const std::string& product)
+{
+    return sides[product + (type == OrderBookType::bid ? "|bid" : "|ask")];
+}
+
+void RestingOrders::link(OrderNode* node)
+{
+    SideLevels& entry = sideFor(node->order.orderType, node->order.product);
+    if (entry.newest < node->order.timestamp) entry.newest = node->order.timestamp;
+    Side& side = entry.levels;
+    RestingLevel& level = side[node->order.price];
+    level.price = node->order.price;
+    level.side = &side;
+
+    node->level = &level;
+    node->next = nullptr;
+    node->prev = level.tail;
+    if (level.tail != nullptr)
+    {
+        level.tail->next = node;
+    }
+    else
+    {
+        level.head = node;
+    }
+    level.tail = node;
+    level.amount += node->order.amount;
+    level.count++;
+}
+
+void RestingOrders::unlink(OrderNode* node)
+{
+    RestingLevel* level = node->level;
+    if (node->prev != nullptr) node->prev->next = node->next;
+    else level->head = node->next;
+    if (node->next != nullptr) node->next->prev = node->prev;
+    else level->tail = node->prev;
+
+    level->amount -= node->order.amount;
+    level->count--;
+    node->prev = nullptr;
+    node->next = nullptr;
+    node->level = nullptr;
+
+    if (level->count == 0)
+    {
+        // Drop the empty level so it does not show up in the book
+        double price = level->price;
+        level->side->erase(price);
+    }
+}
+
+MemoryUsage RestingOrders::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.entries += pool.size() * sizeof(OrderNode);
+    for (const OrderNode& node : pool)
+    {
+        usage.strings += MemoryUsage::heapBytes(node.order);
+    }
+    usage.addOrders(takers, usage.entries);
+
+    usage.indexes += MemoryUsage::treeBytes(sides);
+    for (const auto& side : sides)
+    {
+        usage.strings += MemoryUsage::heapBytes(side.first) + MemoryUsage::heapBytes(side.second.newest);
+        usage.indexes += MemoryUsage::treeBytes(side.second.levels);
+    }
+    usage.indexes += MemoryUsage::hashBytes(nodesById);
+    usage.indexes += freeNodes.capacity() * sizeof(OrderNode*);
+    return usage;
+}
+
+OrderNode* RestingOrders::allocate(const OrderBookEntry& order)
+{
+    if (!freeNodes.empty())
+    {
+        OrderNode* node = freeNodes.back();
+        freeNodes.pop_back();
+        node->order = order;
+        return node;
+    }
+    pool.emplace_back(order);
+    return &pool.back();
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include "MemoryUsage.h"
+#include "OrderBookEntry.h"
+#include "PriceLevel.h"
+#include <cmath>
+#include <deque>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct RestingLevel;
+
+/** A user order resting in the book, linked into the list of its price level */
+struct OrderNode
+{
+    OrderNode(OrderBookEntry order) : order(order), prev(nullptr), next(nullptr), level(nullptr) {}
+
+    OrderBookEntry order;
+    OrderNode* prev;
+    OrderNode* next;
+    RestingLevel* level;
+};
+
+/** All resting orders at one price, oldest first, plus the level totals */
+struct RestingLevel
+{
+    double price = 0;
+    double amount = 0; // sum of the amounts of the orders on this level
+    int count = 0;
+    OrderNode* head = nullptr;
+    OrderNode* tail = nullptr;
+    std::map<double, RestingLevel>* side = nullptr; // the side this level belongs to
+};
+
+/**
+ * Holds the orders entered by users until they are filled or cancelled.
+ * Orders are found by id through a hash map and sit in an intrusive
+ * list per price level, so cancel and replace never scan the book.
+ *
+ * Market, IOC and FOK orders never join a level. They wait in a short
+ * list until the next match of their product takes them, whatever is
+ * left of them then is dropped.
+ */
+class RestingOrders
+{
+    public:
+        RestingOrders();
+        RestingOrders(const RestingOrders&) = delete;
+        RestingOrders& operator=(const RestingOrders&) = delete;
+
+        /** add an order at the back of its price level, or to the pending takers if it
+         *  is not a limit order. Returns the new order id, or 0 if the amount is not finite
+         *  and above zero or the price is not - a market order's price only has to be finite */
+        unsigned int add(OrderBookEntry order);
+
+        /** remove an order, returns false if the id is not resting */
+        bool cancel(unsigned int id);
+
+        /** change price and amount of an order, keeping its id.
+         *  The order keeps its queue position if only the amount goes down.
+         *  Pending takers cannot be changed, and price and amount must be
+         *  finite and above zero */
+        bool replace(unsigned int id, double price, double amount);
+
+        /** set the remaining amount after a fill, removing the order once it is used up.
+         *  A pending taker is always removed, it has had its one chance to trade */
+        void updateAmount(unsigned int id, double amount);
+
+        /** returns the resting order with this id or nullptr */
+        const OrderBookEntry* find(unsigned int id) const;
+
+        /** return the orders for one side of a product in price-time priority, then the pending takers */
+        std::vector<OrderBookEntry> getOrders(OrderBookType type, const std::string& product) const;
+
+        /** return the price levels for one side of a product, or nullptr if there are none */
+        const std::map<double, RestingLevel>* getLevels(OrderBookType type, const std::string& product) const;
+
+        /** the price levels of one side if they are what it held at timestamp, that is if no order
+         *  on it was entered later. nullptr if the side is empty or holds a later order */
+        const std::map<double, RestingLevel>* getLevelsAsOf(OrderBookType type,
+                                                            const std::string& product,
+                                                            const std::string& timestamp) const;
+
+        /** return the price levels of one side made of the orders entered at or before timestamp,
+         *  best first. The same orders as getOrders once filtered on e.timestamp <= timestamp.
+         *  Read from the level totals when getLevelsAsOf has them, otherwise order by order */
+        std::vector<PriceLevel> getLevels(OrderBookType type, const std::string& product, const std::string& timestamp) const;
+
+        /** append the price and amount of each order of one side entered at or before timestamp,
+         *  pending takers included, the orders getOrders gives once filtered on their timestamp */
+        void collect(OrderBookType type, const std::string& product, const std::string& timestamp,
+                     std::vector<double>& prices, std::vector<double>& amounts) const;
+
+        /** return every resting order, by id */
+        std::vector<OrderBookEntry> getAllOrders() const;
+
+        std::size_t size() const { return nodesById.size() + takers.size(); }
+
+        /** the node pool (free nodes included), pending takers, levels and id index */
+        MemoryUsage memoryUsage() const;
+
+    private:
+        /** the levels for one side of one product, keyed by price */
+        typedef std::map<double, RestingLevel> Side;
+
+        /** a side and the latest timestamp of an order linked into it. That is never lowered,
+         *  so while a query's timestamp is at or after it the level totals hold for the query */
+        struct SideLevels
+        {
+            Side levels;
+            std::string newest;
+        };
+
+        SideLevels& sideFor(OrderBookType type, const std::string& product);
+        void link(OrderNode* node);
+        void unlink(OrderNode* node);
+        bool removeTaker(unsigned int id);
+        /** finite and above zero. NaN compares false both ways, so it must never become a level key */
+        static bool valid(double value) { return value > 0 && std::isfinite(value); }
+        OrderNode* allocate(const OrderBookEntry& order);
+
+        std::map<std::string, SideLevels> sides; // keyed by product + "|bid" / "|ask"
+        std::unordered_map<unsigned int, OrderNode*> nodesById;
+        std::deque<OrderNode> pool; // deque so node addresses stay valid as it grows
+        std::vector<OrderNode*> freeNodes;
+        std::vector<OrderBookEntry> takers; // Market/IOC/FOK orders waiting for their match, by id
+        unsigned int nextId;
+};
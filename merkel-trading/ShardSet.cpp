@@ -0,0 +1,297 @@
+#include "ShardSet.h"
+#include "CSVReader.h"
+#include "OrderArchive.h"
+#include <algorithm>
+#include <set>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+const std::size_t ShardSet::defaultBudget = 256 * 1024 * 1024;
+
+ShardSet::ShardSet(const std::string& path) : lazy(true), loadedBytes(0), budget(defaultBudget)
+{
+    if (std::filesystem::is_directory(path))
+    {
+        scanDirectory(path);
+    }
+    else if (std::filesystem::path(path).extension() == ".manifest")
+    {
+        readManifest(path);
+    }
+    else
+    {
+        // a plain file is the whole book, read it now like a single file always was
+        lazy = false;
+        std::shared_ptr<const BookShard> shard = BookShard::load(path);
+        const std::vector<std::string>& times = shard->getFrameTimes();
+        infos.push_back(ShardInfo{path, times.empty() ? "" : times.front(), times.empty() ? "" : times.back(),
+                                  shard->getProducts()});
+        cache.push_back(shard);
+        cacheBytes.push_back(shard->memoryBytes());
+        recent.push_back(0);
+        positions.push_back(recent.begin());
+        loadedBytes = cacheBytes[0];
+        products = shard->getProducts();
+        std::sort(products.begin(), products.end());
+        return;
+    }
+
+    // drop empty files and order the rest by time
+    infos.erase(std::remove_if(infos.begin(), infos.end(), [](const ShardInfo& i) { return i.first.empty(); }),
+                infos.end());
+    std::sort(infos.begin(), infos.end(), [](const ShardInfo& a, const ShardInfo& b)
+    {
+        return a.first < b.first;
+    });
+    if (infos.empty())
+    {
+        throw std::runtime_error("ShardSet: no order book data in " + path);
+    }
+    cache.resize(infos.size());
+    cacheBytes.resize(infos.size(), 0);
+    positions.resize(infos.size(), recent.end());
+
+    std::set<std::string> all;
+    for (const ShardInfo& info : infos)
+    {
+        all.insert(info.products.begin(), info.products.end());
+    }
+    products.assign(all.begin(), all.end());
+}
+
+void ShardSet::scanDirectory(const std::string& path)
+{
+    for (const auto& entry : std::filesystem::directory_iterator(path))
+    {
+        if (!entry.is_regular_file()) continue;
+        std::string file = entry.path().string();
+        if (entry.path().extension() != ".csv" && !OrderArchive::isArchive(file)) continue;
+        ShardInfo info{file, "", "", {}};
+        probe(info);
+        infos.push_back(info);
+    }
+}
+
+void ShardSet::readManifest(const std::string& path)
+{
+    std::ifstream manifest{path};
+    if (!manifest.is_open())
+    {
+        throw std::runtime_error("ShardSet: cannot open " + path);
+    }
+    std::filesystem::path dir = std::filesystem::path(path).parent_path();
+    std::string line;
+    while (std::getline(manifest, line))
+    {
+        if (line.empty() || line[0] == '#') continue;
+        std::vector<std::string> tokens = CSVReader::tokenise(line, ',');
+        if (tokens.empty()) continue;
+        ShardInfo info{(dir / tokens[0]).string(), "", "", {}};
+        if (tokens.size() >= 4)
+        {
+            info.first = tokens[1];
+            info.last = tokens[2];
+            info.products.assign(tokens.begin() + 3, tokens.end());
+        }
+        else
+        {
+            probe(info); // The products have to be read from the file, the range comes with them
+        }
+        infos.push_back(info);
+    }
+}
+
+void ShardSet::probe(ShardInfo& info)
+{
+    if (OrderArchive::isArchive(info.path))
+    {
+        OrderArchive::readTimeRange(info.path, info.first, info.last);
+        info.products = OrderArchive::readProducts(info.path);
+        return;
+    }
+
+    readCsvRange(info);
+    if (!info.first.empty()) readCsvProducts(info);
+}
+
+void ShardSet::readCsvRange(ShardInfo& info)
+{
+    std::ifstream file{info.path, std::ios::binary};
+    std::string line;
+    CSVReader::OrderRow row;
+    while (std::getline(file, line))
+    {
+        if (!CSVReader::readOrderRow(line, row)) continue; // Headers and bad lines are not loaded either
+        info.first = std::string(row.timestamp);
+        break;
+    }
+    if (info.first.empty()) return;
+
+    // the last row from a block at the end, twice as large each time it holds none
+    std::size_t size = std::filesystem::file_size(info.path);
+    for (std::size_t tail = 4096; info.last.empty(); tail *= 2)
+    {
+        std::size_t start = tail < size ? size - tail : 0;
+        std::string block(size - start, '\0');
+        file.clear();
+        file.seekg(start);
+        file.read(&block[0], block.size());
+        block.resize(file.gcount());
+        std::size_t end = block.size();
+        while (end > 0)
+        {
+            std::size_t begin = block.rfind('\n', end - 1);
+            begin = begin == std::string::npos ? 0 : begin + 1;
+            if ((begin > 0 || start == 0) &&
+                CSVReader::readOrderRow(std::string_view{block.data() + begin, end - begin}, row))
+            {
+                info.last = std::string(row.timestamp);
+                break;
+            }
+            end = begin > 0 ? begin - 1 : 0; // A line cut by the start of the block is left for a larger one
+        }
+        if (start == 0) break;
+    }
+}
+
+void ShardSet::readCsvProducts(ShardInfo& info)
+{
+    // the sidecar starts with the size and time stamp of the file it was written for
+    std::string sidecar = info.path + ".products";
+    std::string stamp = std::to_string(std::filesystem::file_size(info.path)) + " " +
+                        std::to_string(std::filesystem::last_write_time(info.path).time_since_epoch().count());
+    std::string line;
+    std::ifstream saved{sidecar};
+    if (std::getline(saved, line) && line == stamp)
+    {
+        while (std::getline(saved, line))
+        {
+            if (!line.empty()) info.products.push_back(line);
+        }
+        return;
+    }
+
+    std::ifstream file{info.path, std::ios::binary};
+    std::set<std::string, std::less<>> found;
+    CSVReader::OrderRow row;
+    while (std::getline(file, line))
+    {
+        if (!CSVReader::readOrderRow(line, row)) continue;
+        if (found.find(row.product) == found.end()) found.emplace(row.product);
+    }
+    info.products.assign(found.begin(), found.end());
+
+    // written whole and then renamed, so a reader never sees half of one. A directory
+    // that cannot be written to only costs the next open another pass
+    std::string temporary = sidecar + ".tmp";
+    std::ofstream out{temporary, std::ios::trunc};
+    out << stamp << "\n";
+    for (const std::string& product : info.products) out << product << "\n";
+    out.close();
+    std::error_code failed;
+    if (out) std::filesystem::rename(temporary, sidecar, failed);
+    if (!out || failed) std::filesystem::remove(temporary, failed);
+}
+
+std::size_t ShardSet::findShard(const std::string& timestamp) const
+{
+    auto it = std::lower_bound(infos.begin(), infos.end(), timestamp, [](const ShardInfo& i, const std::string& t)
+    {
+        return i.last < t;
+    });
+    return it - infos.begin();
+}
+
+std::shared_ptr<const BookShard> ShardSet::get(std::size_t shard) const
+{
+    std::unique_lock<std::mutex> lock{mutex};
+    if (cache[shard] != nullptr)
+    {
+        touch(shard);
+        return cache[shard];
+    }
+
+    // read without the lock so other shards stay available meanwhile
+    lock.unlock();
+    std::shared_ptr<const BookShard> loaded = BookShard::load(infos[shard].path);
+    std::size_t bytes = loaded->memoryBytes();
+    lock.lock();
+
+    if (cache[shard] != nullptr)
+    {
+        return cache[shard]; // Another thread was quicker
+    }
+    cache[shard] = loaded;
+    cacheBytes[shard] = bytes;
+    loadedBytes += bytes;
+    recent.push_front(shard);
+    positions[shard] = recent.begin();
+
+    // callers still holding an evicted shard keep it alive until they are done
+    while (lazy && loadedBytes > budget && recent.size() > 1)
+    {
+        std::size_t victim = recent.back();
+        recent.pop_back();
+        positions[victim] = recent.end();
+        loadedBytes -= cacheBytes[victim];
+        cacheBytes[victim] = 0;
+        cache[victim].reset();
+    }
+    return loaded;
+}
+
+void ShardSet::touch(std::size_t shard) const
+{
+    recent.splice(recent.begin(), recent, positions[shard]); // Iterators stay valid
+}
+
+void ShardSet::setMemoryBudget(std::size_t bytes)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    budget = bytes;
+}
+
+std::size_t ShardSet::getLoadedBytes() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return loadedBytes;
+}
+
+MemoryUsage ShardSet::memoryUsage() const
+{
+    std::vector<std::shared_ptr<const BookShard>> loaded;
+    MemoryUsage usage;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        usage.indexes += cache.capacity() * sizeof(cache[0]) + cacheBytes.capacity() * sizeof(std::size_t);
+        for (std::size_t s : recent)
+        {
+            loaded.push_back(cache[s]);
+        }
+    }
+
+    // walked outside the lock, the shards cannot change
+    for (const std::shared_ptr<const BookShard>& shard : loaded)
+    {
+        usage += shard->memoryUsage();
+        usage.indexes += sizeof(BookShard);
+    }
+    usage.indexes += infos.capacity() * sizeof(ShardInfo);
+    for (const ShardInfo& info : infos)
+    {
+        usage.strings += MemoryUsage::heapBytes(info.path) + MemoryUsage::heapBytes(info.first) +
+                         MemoryUsage::heapBytes(info.last);
+        usage.addStrings(info.products, usage.indexes);
+    }
+    usage.addStrings(products, usage.indexes);
+    usage.indexes += positions.capacity() * sizeof(positions[0]);
+    return usage;
+}
+
+std::size_t ShardSet::getLoadedCount() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return recent.size();
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "BookShard.h"
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/** where a shard lives, which timestamps it covers and what it trades */
+struct ShardInfo
+{
+    std::string path;
+    std::string first; // First timestamp in the shard
+    std::string last;  // Last timestamp in the shard
+    std::vector<std::string> products;
+};
+
+/**
+ * The shards that make up one order book dataset, ordered by time.
+ *
+ * A dataset is one of
+ *  - a single csv or .mka file, loaded straight away and never evicted
+ *  - a directory of csv/.mka files, one time slice each
+ *  - a .manifest file listing one shard per line as
+ *    "path[,first,last[,product...]]", with paths relative to the manifest
+ *
+ * Shards of a directory or manifest are only read when a query needs them.
+ * Their time ranges and products come from the manifest or from a probe when
+ * the set is opened, so every product is known before its first shard is
+ * loaded. An archive is probed through its block headers. A csv gets its range
+ * from its first and last rows, and its products from a "<file>.products"
+ * sidecar: the first probe reads the rows once and writes one, later ones
+ * reuse it while the file's size and time stamp are unchanged. Every file
+ * must be in time order and no frame may be split across two shards.
+ * Loaded shards are kept in an LRU cache that drops the least recently used
+ * ones once their total size goes over the memory budget.
+ *
+ * All methods are safe to call from several threads.
+ */
+class ShardSet
+{
+    public:
+        /** open a file, directory or manifest, throws std::runtime_error if nothing can be read */
+        ShardSet(const std::string& path);
+
+        std::size_t shardCount() const { return infos.size(); }
+        const ShardInfo& getInfo(std::size_t shard) const { return infos[shard]; }
+        /** index of the first shard that ends at or after timestamp, shardCount() if there is none */
+        std::size_t findShard(const std::string& timestamp) const;
+
+        /** the shard at index, loading it (and evicting others) if it is not cached */
+        std::shared_ptr<const BookShard> get(std::size_t shard) const;
+
+        /** bytes the cache may hold before it evicts. The most recent shard always stays */
+        void setMemoryBudget(std::size_t bytes);
+        std::size_t getLoadedBytes() const;
+        /** the loaded shards and the shard list, by category */
+        MemoryUsage memoryUsage() const;
+        std::size_t getLoadedCount() const;
+
+        /** products of every shard, known from the probe or manifest without loading them */
+        std::vector<std::string> getKnownProducts() const { return products; }
+
+        /** the default memory budget, 256 MB */
+        static const std::size_t defaultBudget;
+
+    private:
+        void scanDirectory(const std::string& path);
+        void readManifest(const std::string& path);
+        /** fill in the time range and products of a shard by probing its file */
+        static void probe(ShardInfo& info);
+        /** the first and last timestamps of a csv, from the rows at its two ends */
+        static void readCsvRange(ShardInfo& info);
+        /** the products of a csv from its sidecar, or from a pass over its rows that writes the sidecar */
+        static void readCsvProducts(ShardInfo& info);
+        /** move the shard to the front of recent, it was just used. Needs the lock */
+        void touch(std::size_t shard) const;
+
+        std::vector<ShardInfo> infos;
+        std::vector<std::string> products; // Of every shard, sorted
+        bool lazy;
+
+        mutable std::mutex mutex; // Guards everything below
+        mutable std::vector<std::shared_ptr<const BookShard>> cache; // Loaded shards by index
+        mutable std::vector<std::size_t> cacheBytes;
+        mutable std::list<std::size_t> recent; // Loaded shard indexes, most recently used first
+        mutable std::vector<std::list<std::size_t>::iterator> positions; // Of each loaded shard in recent
+        mutable std::size_t loadedBytes;
+        std::size_t budget;
+};
@@ -0,0 +1,127 @@
+#pragma once
+#include "OrderBookEntry.h"
+#include "PriceLevel.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * What a trading strategy sees and says, see StrategyRunner.
+ *
+ * Everything handed to a strategy is a non-owning view into memory the
+ * runner or the book already holds: the dataset levels and order columns
+ * of the frame straight out of its BookShard and the frame's trades in
+ * the runner's reused vector. Views are only valid during the callback.
+ * Orders go back through an OrderBuffer the runner allocated once, so a
+ * callback never has to allocate.
+ *
+ * A strategy built as a shared library exports the three functions of
+ * MERKEL_EXPORT_STRATEGY and is opened with StrategyLibrary. It must be
+ * built with the same compiler and this same header.
+ */
+
+const int STRATEGY_API_VERSION = 1;
+
+/** a read-only array somebody else owns */
+template <typename T>
+struct View
+{
+    const T* data;
+    std::size_t size;
+
+    const T* begin() const { return data; }
+    const T* end() const { return data + size; }
+    const T& operator[](std::size_t i) const { return data[i]; }
+    bool empty() const { return size == 0; }
+};
+
+/** one product in the current frame, dataset orders only */
+struct ProductView
+{
+    const char* name;       // eg "ETH/BTC"
+    View<PriceLevel> bids;  // Aggregated levels, best first
+    View<PriceLevel> asks;
+    View<double> bidPrices; // Every bid of the frame, the columns BookShard keeps
+    View<double> bidAmounts;
+    View<double> askPrices;
+    View<double> askAmounts;
+    double mid;             // Halfway between the best levels, 0 if a side is empty
+};
+
+struct FrameView
+{
+    const char* timestamp;
+    unsigned int frame;          // Counts from 0 at the earliest frame
+    View<ProductView> products;  // Same order every frame
+};
+
+enum class OrderRequestKind : std::uint8_t
+{
+    place,     // a new order on product
+    cancelAll  // cancel the strategy's resting orders on product, or on every product if product < 0
+};
+
+struct OrderRequest
+{
+    OrderRequestKind kind;
+    OrderBookType side;       // bid or ask
+    OrderExecution execution;
+    int product;              // Index into FrameView::products
+    double price;
+    double amount;
+};
+
+/** fixed capacity output, filled by the strategy and emptied by the runner */
+class OrderBuffer
+{
+    public:
+        OrderBuffer(OrderRequest* storage, std::size_t capacity) : storage(storage), capacity(capacity), count(0) {}
+
+        /** false once the buffer is full, the request is then dropped */
+        bool push(const OrderRequest& request)
+        {
+            if (count == capacity) return false;
+            storage[count++] = request;
+            return true;
+        }
+        bool place(int product, OrderBookType side, double price, double amount,
+                   OrderExecution execution = OrderExecution::limit)
+        {
+            return push(OrderRequest{OrderRequestKind::place, side, execution, product, price, amount});
+        }
+        bool cancelAll(int product = -1)
+        {
+            return push(OrderRequest{OrderRequestKind::cancelAll, OrderBookType::unknown, OrderExecution::limit, product, 0, 0});
+        }
+
+        View<OrderRequest> requests() const { return View<OrderRequest>{storage, count}; }
+        void clear() { count = 0; }
+
+    private:
+        OrderRequest* storage;
+        std::size_t capacity;
+        std::size_t count;
+};
+
+/** a trading strategy driven by StrategyRunner */
+class Strategy
+{
+    public:
+        virtual ~Strategy() {}
+        /** a new frame, before it is matched */
+        virtual void onFrame(const FrameView& frame, OrderBuffer& out) = 0;
+        /** every trade of the frame once it is matched, the strategy's own included */
+        virtual void onTrade(const View<OrderBookEntry>& trades, OrderBuffer& out) { (void)trades; (void)out; }
+        /** one of the strategy's orders traded, a bidsale or an asksale */
+        virtual void onFill(const OrderBookEntry& fill, OrderBuffer& out) { (void)fill; (void)out; }
+};
+
+/** the functions a strategy library exports, args is the text after the library on the command line */
+typedef int (*StrategyVersionFunction)();
+typedef Strategy* (*CreateStrategyFunction)(const char* args);
+typedef void (*DestroyStrategyFunction)(Strategy* strategy);
+
+/** put this in a strategy library's source, once, with its Strategy class */
+#define MERKEL_EXPORT_STRATEGY(StrategyClass) \
+    extern "C" int merkelStrategyVersion() { return STRATEGY_API_VERSION; } \
+    extern "C" Strategy* merkelCreateStrategy(const char* args) { return new StrategyClass(args); } \
+    extern "C" void merkelDestroyStrategy(Strategy* strategy) { delete strategy; }
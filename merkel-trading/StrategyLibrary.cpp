@@ -0,0 +1,49 @@
+#include "StrategyLibrary.h"
+#include <dlfcn.h>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    void* symbol(void* handle, const std::string& path, const char* name)
+    {
+        void* found = ::dlsym(handle, name);
+        if (found == nullptr)
+        {
+            ::dlclose(handle);
+            throw std::runtime_error("StrategyLibrary: " + path + " has no " + name);
+        }
+        return found;
+    }
+}
+
+StrategyLibrary::StrategyLibrary(const std::string& path, const std::string& args)
+    : handle(nullptr), strategy(nullptr), destroy(nullptr)
+{
+    handle = ::dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr)
+    {
+        throw std::runtime_error("StrategyLibrary: " + std::string{::dlerror()});
+    }
+    auto version = reinterpret_cast<StrategyVersionFunction>(symbol(handle, path, "merkelStrategyVersion"));
+    auto create = reinterpret_cast<CreateStrategyFunction>(symbol(handle, path, "merkelCreateStrategy"));
+    destroy = reinterpret_cast<DestroyStrategyFunction>(symbol(handle, path, "merkelDestroyStrategy"));
+    if (version() != STRATEGY_API_VERSION)
+    {
+        ::dlclose(handle);
+        throw std::runtime_error("StrategyLibrary: " + path + " is built for strategy API version " +
+                                 std::to_string(version()) + ", not " + std::to_string(STRATEGY_API_VERSION));
+    }
+    strategy = create(args.c_str());
+    if (strategy == nullptr)
+    {
+        ::dlclose(handle);
+        throw std::runtime_error("StrategyLibrary: " + path + " did not create a strategy");
+    }
+}
+
+StrategyLibrary::~StrategyLibrary()
+{
+    destroy(strategy);
+    ::dlclose(handle);
+}
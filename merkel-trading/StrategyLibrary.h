@@ -0,0 +1,26 @@
+#pragma once
+#include "StrategyApi.h"
+#include <string>
+
+/**
+ * A strategy loaded from a shared library with dlopen. The library must
+ * export the functions of MERKEL_EXPORT_STRATEGY. The strategy is
+ * destroyed through the library and the library closed with this object.
+ */
+class StrategyLibrary
+{
+    public:
+        /** open path and create its strategy with args. Throws std::runtime_error if the
+         *  library cannot be opened, lacks an entry point or was built for another API version */
+        StrategyLibrary(const std::string& path, const std::string& args = "");
+        ~StrategyLibrary();
+        StrategyLibrary(const StrategyLibrary&) = delete;
+        StrategyLibrary& operator=(const StrategyLibrary&) = delete;
+
+        Strategy& getStrategy() { return *strategy; }
+
+    private:
+        void* handle;
+        Strategy* strategy;
+        DestroyStrategyFunction destroy;
+};
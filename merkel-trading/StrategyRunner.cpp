@@ -0,0 +1,168 @@
+#include "StrategyRunner.h"
+#include "CSVReader.h"
+
+StrategyRunner::StrategyRunner(const OrderBook& book, Strategy& strategy, Wallet wallet, std::size_t bufferCapacity)
+    : book(book),
+      strategy(strategy),
+      wallet(wallet),
+      match(MatchingRules::select(AllocationRule::fifo, TradePriceRule::askPrice)),
+      products(book.getKnownProducts()),
+      storage(bufferCapacity),
+      out(storage.data(), storage.size()),
+      placed(products.size()),
+      result{0, 0, 0, 0, 0, WalletValuation{0, 0, 0, 0, 0, 0}, ""}
+{
+    for (const std::string& product : products)
+    {
+        std::vector<std::string> currs = CSVReader::tokenise(product, '/');
+        bases.push_back(currs.size() == 2 ? currs[0] : "");
+        quotes.push_back(currs.size() == 2 ? currs[1] : "");
+    }
+    views.resize(products.size());
+    frame.products = View<ProductView>{views.data(), views.size()};
+    if (!quotes.empty()) this->wallet.setReferenceCurrency(quotes[0]);
+}
+
+StrategyResult StrategyRunner::run()
+{
+    std::string start = book.getEarliestTime();
+    std::string timestamp = start;
+    unsigned int number = 0;
+    do
+    {
+        buildFrame(timestamp, number++);
+        strategy.onFrame(frame, out);
+        apply(timestamp);
+
+        trades.clear();
+        for (const std::string& product : products)
+        {
+            std::vector<OrderBookEntry> sales = book.matchAsksToBids(product, timestamp, overlay, match);
+            trades.insert(trades.end(), sales.begin(), sales.end());
+        }
+        // pay for the fills before the strategy can order again with what they freed
+        for (OrderBookEntry& sale : trades)
+        {
+            if (sale.username == "simuser" && sale.amount > 0) wallet.processSale(sale);
+        }
+        settle();
+        strategy.onTrade(View<OrderBookEntry>{trades.data(), trades.size()}, out);
+        apply(timestamp);
+
+        for (OrderBookEntry& sale : trades)
+        {
+            if (sale.username != "simuser" || sale.amount <= 0) continue;
+            result.fills++;
+            result.volume += sale.amount;
+            strategy.onFill(sale, out);
+            apply(timestamp);
+        }
+        for (const ProductView& view : views)
+        {
+            if (view.mid > 0) wallet.markPrice(view.name, view.mid);
+        }
+
+        result.frames++;
+        timestamp = book.getNextTime(timestamp);
+    } while (timestamp != start && !timestamp.empty());
+
+    shard.reset();
+    result.valuation = wallet.getValuation();
+    result.wallet = wallet.toString();
+    return result;
+}
+
+void StrategyRunner::buildFrame(const std::string& timestamp, unsigned int number)
+{
+    frame.timestamp = timestamp.c_str();
+    frame.frame = number;
+    int index;
+    shard = book.shardFor(timestamp, index);
+    for (std::size_t p = 0; p < products.size(); ++p)
+    {
+        ProductView& view = views[p];
+        view = ProductView{products[p].c_str(), {nullptr, 0}, {nullptr, 0}, {nullptr, 0}, {nullptr, 0}, {nullptr, 0}, {nullptr, 0}, 0};
+        int pid = shard ? shard->productIndex(products[p]) : -1;
+        if (index < 0 || pid < 0) continue;
+
+        BookShard::LevelSpan bids = shard->getLevels(index, pid, OrderBookType::bid);
+        BookShard::LevelSpan asks = shard->getLevels(index, pid, OrderBookType::ask);
+        view.bids = View<PriceLevel>{bids.begin, static_cast<std::size_t>(bids.end - bids.begin)};
+        view.asks = View<PriceLevel>{asks.begin, static_cast<std::size_t>(asks.end - asks.begin)};
+        BookShard::Slice bidOrders = shard->getSlice(index, pid, OrderBookType::bid);
+        BookShard::Slice askOrders = shard->getSlice(index, pid, OrderBookType::ask);
+        view.bidPrices = View<double>{bidOrders.prices, bidOrders.count};
+        view.bidAmounts = View<double>{bidOrders.amounts, bidOrders.count};
+        view.askPrices = View<double>{askOrders.prices, askOrders.count};
+        view.askAmounts = View<double>{askOrders.amounts, askOrders.count};
+        if (!view.bids.empty() && !view.asks.empty())
+        {
+            view.mid = (view.bids[0].price + view.asks[0].price) / 2;
+        }
+    }
+}
+
+void StrategyRunner::apply(const std::string& timestamp)
+{
+    for (const OrderRequest& r : out.requests())
+    {
+        bool known = r.product >= 0 && static_cast<std::size_t>(r.product) < products.size();
+        if (r.kind == OrderRequestKind::cancelAll)
+        {
+            for (std::size_t p = 0; p < products.size(); ++p)
+            {
+                if (r.product >= 0 && static_cast<int>(p) != r.product) continue;
+                for (unsigned int id : placed[p])
+                {
+                    overlay.cancel(id);
+                    wallet.release(id);
+                }
+                placed[p].clear();
+            }
+            continue;
+        }
+
+        // Same checks as Wallet::canFulfillOrder, without its console output: what the
+        // strategy's other open orders hold back cannot pay for this one
+        bool funded = false;
+        if (known && r.side == OrderBookType::bid) funded = wallet.getAvailable(quotes[r.product]) >= r.amount * r.price;
+        if (known && r.side == OrderBookType::ask) funded = wallet.getAvailable(bases[r.product]) >= r.amount;
+        if (!funded || r.amount <= 0)
+        {
+            result.ordersRejected++;
+            continue;
+        }
+        OrderBookEntry order{r.price, r.amount, timestamp, products[r.product], r.side, "simuser"};
+        order.execution = r.execution;
+        order.id = overlay.add(order);
+        if (order.id == 0) // A price that is not finite and above zero
+        {
+            result.ordersRejected++;
+            continue;
+        }
+        wallet.reserve(order);
+        placed[r.product].push_back(order.id);
+        result.ordersPlaced++;
+    }
+    out.clear();
+}
+
+void StrategyRunner::settle()
+{
+    for (std::vector<unsigned int>& ids : placed)
+    {
+        std::size_t kept = 0;
+        for (unsigned int id : ids)
+        {
+            const OrderBookEntry* order = overlay.find(id);
+            if (order == nullptr)
+            {
+                wallet.release(id); // Filled, or a taker that had its one match
+                continue;
+            }
+            wallet.reserve(*order); // What is left after a partial fill
+            ids[kept++] = id;
+        }
+        ids.resize(kept);
+    }
+}
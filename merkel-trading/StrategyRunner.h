@@ -0,0 +1,69 @@
+#pragma once
+#include "MatchingEngine.h"
+#include "OrderBook.h"
+#include "RestingOrders.h"
+#include "StrategyApi.h"
+#include "Wallet.h"
+#include <string>
+#include <vector>
+
+/** What came out of one strategy run */
+struct StrategyResult
+{
+    unsigned int frames;
+    unsigned int ordersPlaced;
+    unsigned int ordersRejected; // Not enough funds, or not a bid or ask on a known product
+    unsigned int fills;
+    double volume;
+    WalletValuation valuation;   // In the quote currency of the first product
+    std::string wallet;
+};
+
+/**
+ * The headless replay loop for a Strategy. Every frame the strategy gets
+ * a FrameView of the frame's dataset book, its orders are checked against
+ * what the wallet has not already reserved for its other open orders and
+ * entered into the run's own resting orders, the frame is matched product
+ * by product and the run's fills settled, and the strategy hears of the
+ * trades and then of its own fills. Like a Backtest the run never changes the shared
+ * book, so several can share one.
+ *
+ * The views, the order buffer and the trade list are built once and
+ * reused, so calling the strategy costs no allocation.
+ */
+class StrategyRunner
+{
+    public:
+        StrategyRunner(const OrderBook& book, Strategy& strategy, Wallet wallet, std::size_t bufferCapacity = 1024);
+
+        /** replay from the earliest frame until the book wraps around */
+        StrategyResult run();
+
+    private:
+        /** point the product views at the dataset of timestamp */
+        void buildFrame(const std::string& timestamp, unsigned int frame);
+        /** enter the strategy's requests and empty the buffer */
+        void apply(const std::string& timestamp);
+        /** after a match: forget the orders that filled or were dropped and give back what
+         *  they held, hold only what is left of the others */
+        void settle();
+
+        const OrderBook& book;
+        Strategy& strategy;
+        Wallet wallet;
+        MatchFunction match;
+
+        std::vector<std::string> products;
+        std::vector<std::string> bases;  // Currency each product sells
+        std::vector<std::string> quotes; // Currency each product is priced in
+        std::vector<ProductView> views;
+        FrameView frame;
+        std::vector<OrderRequest> storage;
+        OrderBuffer out;
+        std::vector<OrderBookEntry> trades; // This frame's trades, kept for its capacity
+
+        RestingOrders overlay;
+        std::vector<std::vector<unsigned int>> placed; // Ids still in the overlay per product, for cancelAll
+        std::shared_ptr<const BookShard> shard;        // Keeps the viewed frame loaded
+        StrategyResult result;
+};
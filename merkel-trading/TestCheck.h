@@ -0,0 +1,104 @@
+#pragma once
+#include "OrderBook.h"
+#include "OrderBookEntry.h"
+#include "PriceLevel.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * What the test programs share. A test opens with testTitle, starts each
+ * part with testSection, which numbers them, and checks with check, which
+ * prints what was checked and whether it held and counts the failures.
+ * main returns testFailures(), so "make check" stops at the first program
+ * with one. The helpers below build and compare the fixtures most tests use.
+ */
+
+/** the dataset the tests replay, small enough to walk every frame of */
+const char* const TEST_DATASET = "orderBook.csv";
+/** more levels than any side of TEST_DATASET has, for depth queries that want them all */
+const unsigned int ALL_LEVELS = 1000;
+
+inline int& testFailureCount()
+{
+    static int failures = 0;
+    return failures;
+}
+
+inline void testTitle(const std::string& name)
+{
+    std::cout << "=== " << name << " Testing ===" << std::endl;
+}
+
+inline void testSection(const std::string& what)
+{
+    static int section = 0;
+    std::cout << "\n" << ++section << ". Testing " << what << ":" << std::endl;
+}
+
+inline void check(bool ok, const std::string& what)
+{
+    std::cout << (ok ? "  ok: " : "  FAILED: ") << what << std::endl;
+    if (!ok) ++testFailureCount();
+}
+
+inline int testFailures()
+{
+    std::cout << (testFailureCount() == 0 ? "=== All checks passed ===" : "=== Some checks FAILED ===") << std::endl;
+    return testFailureCount() == 0 ? 0 : 1;
+}
+
+/** a and b equal up to a relative tolerance, for sums taken in a different order */
+inline bool near(double a, double b, double tolerance = 1e-9)
+{
+    return std::fabs(a - b) <= tolerance * std::max(1.0, std::max(std::fabs(a), std::fabs(b)));
+}
+
+/** true if f throws an Exception */
+template <typename Exception = std::runtime_error, typename F>
+bool throws(F f)
+{
+    try
+    {
+        f();
+    }
+    catch (const Exception&)
+    {
+        return true;
+    }
+    return false;
+}
+
+/** every timestamp of book, first to last */
+inline std::vector<std::string> testFrames(const OrderBook& book)
+{
+    std::vector<std::string> times;
+    std::string start = book.getEarliestTime();
+    std::string t = start;
+    do
+    {
+        times.push_back(t);
+        t = book.getNextTime(t);
+    } while (t != start);
+    return times;
+}
+
+/** same prices and order counts, amounts near */
+inline bool sameLevels(const std::vector<PriceLevel>& a, const std::vector<PriceLevel>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+        if (a[i].price != b[i].price || !near(a[i].amount, b[i].amount) || a[i].orderCount != b[i].orderCount) return false;
+    }
+    return true;
+}
+
+inline std::vector<OrderBookEntry> byId(std::vector<OrderBookEntry> orders)
+{
+    std::sort(orders.begin(), orders.end(), [](const OrderBookEntry& a, const OrderBookEntry& b) { return a.id < b.id; });
+    return orders;
+}
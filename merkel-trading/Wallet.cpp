@@ -1,5 +1,7 @@
 #include "Wallet.h"
+#include "Log.h"
 #include <iostream>
+#include <algorithm>
 #include "CSVReader.h"
 
 Wallet::Wallet() 
@@ -23,6 +25,12 @@ Wallet::Wallet()
         {
             balance = currencies[type];
         }
+        if (!reference.empty())
+        {
+            adjust(type, amount, -1);
+            flow(amount * priceOf(type));
+            updateDrawdown();
+        }
         balance += amount;
         currencies[type] = balance;
     }    bool Wallet::removeCurrency(std::string type, double amount)
@@ -34,14 +42,20 @@ Wallet::Wallet()
 
         if (currencies.count(type) == 0)
         {
-            std::cout << "No currency for " << type << " in wallet." << std::endl;
+            MERKEL_LOG_DEBUG("No currency for " << type << " in wallet.");
             return false; // Currency type does not exist
         }
         else // Currency is there, is there enough?
         {
             if (containsCurrency(type, amount))
             {
-                std::cout << "Removing " << type << " : " << amount << std::endl;
+                MERKEL_LOG_DEBUG("Removing " << type << " : " << amount);
+                if (!reference.empty())
+                {
+                    adjust(type, -amount, -1);
+                    flow(-amount * priceOf(type));
+                    updateDrawdown();
+                }
                 currencies[type] -= amount;
                 return true;
             }
@@ -59,6 +73,13 @@ Wallet::Wallet()
             return currencies[type] >= amount;
     }
 
+double Wallet::getBalance(std::string type)
+{
+    auto it = currencies.find(type);
+    if (it == currencies.end()) return 0;
+    return it->second;
+}
+
 std::string Wallet::toString()
 {
     std::string s;
@@ -66,7 +87,24 @@ std::string Wallet::toString()
     {
         std::string currency = pair.first;
         double amount = pair.second;
-        s += currency + " : " + std::to_string(amount) + "\n";
+        s += currency + " : " + std::to_string(amount);
+        if (getReserved(currency) > 0)
+        {
+            s += " [" + std::to_string(getReserved(currency)) + " reserved]";
+        }
+        if (!reference.empty() && currency != reference && priceOf(currency) > 0)
+        {
+            s += " (" + reference + " " + std::to_string(amount * priceOf(currency)) + ")";
+        }
+        s += "\n";
+    }
+    if (!reference.empty())
+    {
+        WalletValuation v = getValuation();
+        s += "Value in " + reference + " : " + std::to_string(v.value) +
+             " realized : " + std::to_string(v.realized) +
+             " unrealized : " + std::to_string(v.unrealized) +
+             " max drawdown : " + std::to_string(v.maxDrawdown) + "\n";
     }
     return s;
 }
@@ -74,50 +112,278 @@ std::string Wallet::toString()
 
 bool Wallet::canFulfillOrder(OrderBookEntry order)
 {
-        std::vector<std::string> currs = CSVReader::tokenise(order.product, '/');
-        // Ask
-        if (order.orderType == OrderBookType::ask)
+    Reservation need;
+    if (!reservationFor(order, need)) return false;
+    double available = getAvailable(need.currency);
+    auto own = reservations.find(order.id);
+    if (order.id != 0 && own != reservations.end() && own->second.currency == need.currency)
+    {
+        available += own->second.amount; // A replace can reuse what the order already holds
+    }
+    MERKEL_LOG_DEBUG("Wallet::canFulfillOrder: " << need.currency << " : " << need.amount << " of " << available);
+    return need.amount <= available;
+}
+
+void Wallet::reserve(const OrderBookEntry& order)
+{
+    release(order.id);
+    Reservation r;
+    if (order.id == 0 || !reservationFor(order, r)) return; // Only orders in the book hold funds
+    reserved[r.currency] += r.amount;
+    reservations[order.id] = r;
+}
+
+void Wallet::release(unsigned int id)
+{
+    auto it = reservations.find(id);
+    if (it == reservations.end()) return;
+    double& held = reserved[it->second.currency];
+    held -= it->second.amount;
+    if (held < 1e-12) reserved.erase(it->second.currency); // Rounding leaves no dust behind
+    reservations.erase(it);
+}
+
+void Wallet::keepReserved(const std::vector<OrderBookEntry>& open)
+{
+    std::map<unsigned int, const OrderBookEntry*> stillOpen;
+    for (const OrderBookEntry& e : open)
+    {
+        stillOpen[e.id] = &e;
+    }
+    std::vector<unsigned int> ids;
+    for (const auto& r : reservations)
+    {
+        ids.push_back(r.first);
+    }
+    for (unsigned int id : ids)
+    {
+        auto it = stillOpen.find(id);
+        if (it == stillOpen.end()) release(id); // Filled, or a taker that had its chance
+        else reserve(*it->second);               // Partly filled, holds only what is left
+    }
+}
+
+double Wallet::getReserved(std::string type) const
+{
+    auto it = reserved.find(type);
+    return it == reserved.end() ? 0 : it->second;
+}
+
+double Wallet::getAvailable(std::string type)
+{
+    return getBalance(type) - getReserved(type);
+}
+
+bool Wallet::reservationFor(const OrderBookEntry& order, Reservation& r)
+{
+    std::vector<std::string> currs = CSVReader::tokenise(order.product, '/');
+    if (currs.size() != 2) return false;
+    if (order.orderType == OrderBookType::ask)
+    {
+        r = Reservation{currs[0], order.amount}; // The currency we are selling
+        return true;
+    }
+    if (order.orderType == OrderBookType::bid)
+    {
+        r = Reservation{currs[1], order.amount * order.price}; // The currency we are paying with
+        return true;
+    }
+    return false;
+}
+
+bool Wallet::processSale(OrderBookEntry& sale)
+{
+    std::vector<std::string> currs = CSVReader::tokenise(sale.product, '/');
+    if (sale.orderType != OrderBookType::asksale && sale.orderType != OrderBookType::bidsale) return false;
+    if (currs.size() != 2) return false;
+    bool ask = sale.orderType == OrderBookType::asksale;
+    // an ask sells the base for the quote, a bid buys the base with the quote
+    std::string outgoingCurrency = ask ? currs[0] : currs[1];
+    double outgoingAmount = ask ? sale.amount : sale.amount * sale.price;
+    std::string incomingCurrency = ask ? currs[1] : currs[0];
+    double incomingAmount = ask ? sale.amount * sale.price : sale.amount;
+
+    double balance = getBalance(outgoingCurrency);
+    if (balance <= 0 || balance + 1e-12 < outgoingAmount)
+    {
+        MERKEL_LOG_WARN("Wallet::processSale: " << outgoingAmount << " " << outgoingCurrency
+                        << " wanted but only " << balance << " held, sale refused");
+        return false;
+    }
+    outgoingAmount = std::min(outgoingAmount, balance); // What rounding put over the balance
+
+    if (!reference.empty())
+    {
+        // what the trade is worth, from whichever side has a price
+        double worth = -1;
+        if (priceOf(incomingCurrency) > 0) worth = incomingAmount * priceOf(incomingCurrency);
+        else if (priceOf(outgoingCurrency) > 0) worth = outgoingAmount * priceOf(outgoingCurrency);
+        bool costed = priceOf(outgoingCurrency) > 0;
+
+        double cost = adjust(outgoingCurrency, -outgoingAmount, worth);
+        adjust(incomingCurrency, incomingAmount, worth);
+        if (costed && worth >= 0) realized += worth - cost;
+        updateDrawdown();
+    }
+
+    currencies[incomingCurrency] += incomingAmount; // Add the incoming currency to the wallet
+    currencies[outgoingCurrency] -= outgoingAmount; // Remove the outgoing currency from the wallet
+    return true;
+}
+
+void Wallet::setReferenceCurrency(std::string type)
+{
+    reference = type;
+    marks.clear();
+    value = 0;
+    totalCost = 0;
+    realized = 0;
+    maxDrawdown = 0;
+
+    Mark& ref = marks[reference];
+    ref.price = 1;
+    ref.priced = true;
+    for (const std::pair<const std::string, double>& c : currencies)
+    {
+        if (c.first == reference)
         {
-            double amount = order.amount;
-            std::string currency = currs[0]; // The currency we are selling
-            std::cout << "Wallet::canFulfillOrder: " << currency << " : " << amount << std::endl;
-            return containsCurrency(currency, amount);
+            ref.cost = c.second;
+            value += c.second;
+            totalCost += c.second;
         }
-        // Bid
-        if (order.orderType == OrderBookType::bid)
+        else
         {
-            double amount = order.amount * order.price; // Amount in the currency we are buying
-            std::string currency = currs[1]; // The currency we are buying
-            std::cout << "Wallet::canFulfillOrder: " << currency << " : " << amount << std::endl;
-            return containsCurrency(currency, amount);
+            marks[c.first].unpriced = c.second;
         }
+    }
+    peak = value;
+}
+
+bool Wallet::markPrice(std::string product, double mid)
+{
+    std::vector<std::string> currs = CSVReader::tokenise(product, '/');
+    if (currs.size() != 2) return false;
+    return markPrice(currs[0], currs[1], mid);
+}
 
+bool Wallet::markPrice(const std::string& base, const std::string& quote, double mid)
+{
+    if (reference.empty() || mid <= 0) return false;
+    double quotePrice = priceOf(quote);
+    double basePrice = priceOf(base);
+    if (quotePrice > 0)
+    {
+        setPrice(base, mid * quotePrice);
+        return true;
+    }
+    if (basePrice > 0)
+    {
+        setPrice(quote, basePrice / mid);
+        return true;
+    }
     return false;
 }
 
-void Wallet::processSale(OrderBookEntry& sale)
+void Wallet::setPrice(std::string type, double price)
 {
-    std::vector<std::string> currs = CSVReader::tokenise(sale.product, '/');
-    // Ask
-    if (sale.orderType == OrderBookType::asksale)
+    if (reference.empty() || type == reference || price <= 0) return;
+    Mark& m = marks[type];
+    double balance = getBalance(type);
+    if (!m.priced)
+    {
+        // holdings from before the first price are costed at it, like a deposit made now
+        m.priced = true;
+        m.cost += m.unpriced * price;
+        flow(m.unpriced * price);
+        m.unpriced = 0;
+        totalCost += m.cost;
+        value += balance * price;
+    }
+    else
+    {
+        value += balance * (price - m.price);
+    }
+    m.price = price;
+    updateDrawdown();
+}
+
+double Wallet::adjust(const std::string& type, double delta, double worth)
+{
+    Mark& m = marks[type];
+    double released = 0;
+    if (delta > 0)
     {
-        double outgoingAmount = sale.amount;
-        std::string outgoingCurrency = currs[0]; // The currency we are selling
-        double incomingAmount = sale.amount * sale.price; // Amount in the currency we are buying
-        std::string incomingCurrency = currs[1]; // The currency we are buying
-        
-        currencies[incomingCurrency] += incomingAmount; // Add the incoming currency to the wallet
-        currencies[outgoingCurrency] -= outgoingAmount; // Remove the outgoing currency from the wallet
+        double cost = worth >= 0 ? worth : delta * m.price;
+        if (m.priced || worth >= 0) m.cost += cost;
+        else m.unpriced += delta; // Costed when the first price comes
+        if (m.priced) totalCost += cost;
     }
-    // Bid
-    if (sale.orderType == OrderBookType::bidsale)
+    else
     {
-        double incomingAmount = sale.amount;
-        std::string incomingCurrency = currs[0]; // The currency we are buying
-        double outgoingAmount = sale.amount * sale.price; // Amount in the currency we are spending
-        std::string outgoingCurrency = currs[1]; // The currency we are spending
+        // average cost: what goes out takes its share of the cost with it. Nothing held
+        // has no cost to give, taking it all would book the sale as pure profit
+        double balance = getBalance(type);
+        double share = balance > 0 ? std::min(1.0, -delta / balance) : 0.0;
+        released = m.cost * share;
+        m.cost -= released;
+        m.unpriced -= m.unpriced * share;
+        if (m.priced) totalCost -= released;
+    }
+    if (m.priced) value += delta * m.price;
+    return released;
+}
+
+void Wallet::flow(double amount)
+{
+    peak += amount;
+}
+
+void Wallet::updateDrawdown()
+{
+    if (value > peak) peak = value;
+    maxDrawdown = std::max(maxDrawdown, peak - value);
+}
+
+double Wallet::priceOf(const std::string& type) const
+{
+    auto it = marks.find(type);
+    if (it == marks.end() || !it->second.priced) return 0;
+    return it->second.price;
+}
+
+WalletValuation Wallet::getValuation() const
+{
+    return WalletValuation{value, realized, value - totalCost, peak, peak - value, maxDrawdown};
+}
+
+double Wallet::getExposure(std::string type) const
+{
+    auto it = currencies.find(type);
+    if (it == currencies.end()) return 0;
+    return it->second * priceOf(type);
+}
 
-        currencies[incomingCurrency] += incomingAmount; // Add the incoming currency to the wallet
-        currencies[outgoingCurrency] -= outgoingAmount; // Remove the outgoing currency from the wallet
+MemoryUsage Wallet::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.indexes += MemoryUsage::treeBytes(currencies) + MemoryUsage::treeBytes(marks);
+    usage.indexes += MemoryUsage::treeBytes(reserved) + MemoryUsage::treeBytes(reservations);
+    for (const auto& c : currencies)
+    {
+        usage.strings += MemoryUsage::heapBytes(c.first);
     }
-}
\ No newline at end of file
+    for (const auto& m : marks)
+    {
+        usage.strings += MemoryUsage::heapBytes(m.first);
+    }
+    for (const auto& r : reserved)
+    {
+        usage.strings += MemoryUsage::heapBytes(r.first);
+    }
+    for (const auto& r : reservations)
+    {
+        usage.strings += MemoryUsage::heapBytes(r.second.currency);
+    }
+    usage.strings += MemoryUsage::heapBytes(reference);
+    return usage;
+}
@@ -1,8 +1,21 @@
 #pragma once
 #include <string>
 #include <map>
+#include <vector>
+#include "MemoryUsage.h"
 #include "OrderBookEntry.h"
 
+/** The wallet valued in its reference currency, see Wallet::setReferenceCurrency */
+struct WalletValuation
+{
+    double value;       // every priced currency at its latest price
+    double realized;    // profit locked in by sales, against the average cost of what was sold
+    double unrealized;  // value minus the cost of what is still held
+    double peak;        // highest value so far, moved along with deposits and withdrawals
+    double drawdown;    // peak - value
+    double maxDrawdown; // largest drawdown so far
+};
+
 class Wallet
 {
     public:
@@ -16,17 +29,100 @@ class Wallet
         /** Check if the wallet contains a specific currency */
         bool containsCurrency(std::string type, double amount);
 
+        /** Return the balance of a currency, 0 if the wallet has none */
+        double getBalance(std::string type);
+
         /** Get the amount of a specific currency */
         std::string toString();
 
-        /** Check if the wallet can fulfill an order */
+        /** Check if the wallet can fulfill an order from what is not already reserved for
+         *  other open orders. An order with an id is checked without its own reservation,
+         *  so a replace is sized against what it already holds */
         bool canFulfillOrder(OrderBookEntry order);
 
-        /** Process a sale, updating the wallet accordingly */
-        void processSale(OrderBookEntry& sale);
+        /** Set aside what an open order may spend: the base of an ask, amount * price of the
+         *  quote for a bid. Replaces what was set aside before under the order's id */
+        void reserve(const OrderBookEntry& order);
+
+        /** Give back what was set aside for an order, once it is cancelled or filled */
+        void release(unsigned int id);
+
+        /** Keep the reservations of the orders still in open, at their remaining amounts,
+         *  and release the others. For after a match, when filled orders have left the book */
+        void keepReserved(const std::vector<OrderBookEntry>& open);
+
+        /** Amount of a currency set aside for open orders */
+        double getReserved(std::string type) const;
+
+        /** Balance less what is reserved, what a new order can spend */
+        double getAvailable(std::string type);
+
+        /** Process a sale, updating the wallet accordingly. Returns false and changes nothing
+         *  if the wallet does not hold what the sale pays out */
+        bool processSale(OrderBookEntry& sale);
+
+        /** Value the wallet in reference, eg "USDT", from now on. Resets the valuation:
+         *  what is held now is costed at the first price each currency gets */
+        void setReferenceCurrency(std::string reference);
+
+        /** A new mid price for a product. Prices the base from the quote's price or the quote
+         *  from the base's, touching only that one currency. Returns false if neither has a price yet */
+        bool markPrice(std::string product, double mid);
+
+        /** markPrice for a product already split into its base and quote */
+        bool markPrice(const std::string& base, const std::string& quote, double mid);
+
+        /** Set the price of one currency in the reference currency */
+        void setPrice(std::string type, double price);
+
+        /** Value, profit and drawdown, kept up to date by every sale and price change */
+        WalletValuation getValuation() const;
+
+        /** Balance times price of a currency, 0 if it has no price yet */
+        double getExposure(std::string type) const;
+
+        /** Bytes held by the balance and valuation maps */
+        MemoryUsage memoryUsage() const;
 
 
     private:
+        /** What one open order holds back */
+        struct Reservation
+        {
+            std::string currency;
+            double amount;
+        };
+
+        /** Valuation state of one currency */
+        struct Mark
+        {
+            double price = 0;    // In the reference currency
+            bool priced = false;
+            double cost = 0;     // What the balance cost, in the reference currency
+            double unpriced = 0; // Part of the balance held since before the first price, costed then
+        };
+
+        /** apply a balance change to the valuation. value is what the change is worth in the
+         *  reference currency, negative if unknown. Returns the cost of what was given up */
+        double adjust(const std::string& type, double delta, double value);
+        /** move the peak with money coming in or going out, so it is not taken for profit or loss */
+        void flow(double value);
+        void updateDrawdown();
+        /** price of a currency in the reference currency, 0 if it has none yet */
+        double priceOf(const std::string& type) const;
+        /** what order would hold back, false if its product or side cannot be reserved */
+        static bool reservationFor(const OrderBookEntry& order, Reservation& r);
+
         std::map<std::string, double> currencies; // Map to store currency type and amount
+        std::map<std::string, double> reserved;   // Held back for open orders, by currency
+        std::map<unsigned int, Reservation> reservations; // By order id
+
+        std::string reference; // Empty until setReferenceCurrency
+        std::map<std::string, Mark> marks;
+        double value = 0;     // Sum of balance * price over the priced currencies
+        double totalCost = 0; // Sum of the costs of the priced currencies
+        double realized = 0;
+        double peak = 0;
+        double maxDrawdown = 0;
 
 };
\ No newline at end of file
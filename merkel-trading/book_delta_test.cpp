@@ -0,0 +1,132 @@
+#include "BookDelta.h"
+#include "OrderBook.h"
+#include "TestCheck.h"
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /** apply(before, diff(before, after)) == after */
+    bool identity(OrderBookType side, const std::vector<PriceLevel>& before, const std::vector<PriceLevel>& after)
+    {
+        std::vector<LevelDelta> changes;
+        BookDelta::diff(side, before, after, changes);
+        std::vector<PriceLevel> levels = before;
+        BookDelta::apply(levels, side, changes);
+        return sameLevels(levels, after);
+    }
+
+    bool sameDelta(const FrameDelta& a, const FrameDelta& b)
+    {
+        if (a.from != b.from || a.to != b.to || a.products.size() != b.products.size()) return false;
+        for (std::size_t p = 0; p < a.products.size(); ++p)
+        {
+            const ProductDelta& x = a.products[p];
+            const ProductDelta& y = b.products[p];
+            if (x.product != y.product || x.changes.size() != y.changes.size()) return false;
+            for (std::size_t i = 0; i < x.changes.size(); ++i)
+            {
+                const LevelDelta& c = x.changes[i];
+                const LevelDelta& d = y.changes[i];
+                if (c.change != d.change || c.side != d.side || c.price != d.price ||
+                    c.amount != d.amount || c.orderCount != d.orderCount)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+int main()
+{
+    testTitle("BookDelta");
+
+    testSection("diff by hand (bids 10, 9, 8 to 11, 9, 7)");
+    std::vector<PriceLevel> before{{10, 1, 1}, {9, 2, 1}, {8, 3, 2}};
+    std::vector<PriceLevel> after{{11, 1, 1}, {9, 2.5, 2}, {7, 1, 1}};
+    std::vector<LevelDelta> changes;
+    BookDelta::diff(OrderBookType::bid, before, after, changes);
+    check(changes.size() == 5, "5 changes");
+    check(changes.size() == 5 &&
+          changes[0].change == LevelChange::add && changes[0].price == 11 &&
+          changes[1].change == LevelChange::remove && changes[1].price == 10 && changes[1].amount == 0 &&
+          changes[2].change == LevelChange::modify && changes[2].price == 9 && changes[2].amount == 2.5 &&
+          changes[3].change == LevelChange::remove && changes[3].price == 8 &&
+          changes[4].change == LevelChange::add && changes[4].price == 7,
+          "add 11, remove 10, modify 9, remove 8, add 7, best first");
+    changes.clear();
+    BookDelta::diff(OrderBookType::bid, before, before, changes);
+    check(changes.empty(), "no change between equal sides");
+    check(identity(OrderBookType::bid, before, after), "apply(diff) gives the new bids");
+    check(identity(OrderBookType::ask, {{8, 3, 2}, {9, 2, 1}}, {{7, 1, 1}, {9, 2, 1}, {12, 4, 1}}), "apply(diff) gives the new asks");
+    check(identity(OrderBookType::bid, {}, after) && identity(OrderBookType::bid, before, {}), "from and to an empty side");
+
+    testSection("apply(diff) on every frame of the dataset");
+    OrderBook book{TEST_DATASET};
+    std::vector<std::string> products = book.getKnownProducts();
+    std::vector<std::string> times = testFrames(book);
+    std::size_t sides = 0;
+    std::size_t failed = 0;
+    for (std::size_t f = 0; f < times.size(); ++f)
+    {
+        const std::string& from = times[f];
+        const std::string& to = times[(f + 1) % times.size()];
+        for (const std::string& product : products)
+        {
+            for (OrderBookType side : {OrderBookType::bid, OrderBookType::ask})
+            {
+                ++sides;
+                if (!identity(side, book.getDepth(side, product, from, ALL_LEVELS), book.getDepth(side, product, to, ALL_LEVELS))) ++failed;
+            }
+        }
+    }
+    check(failed == 0, std::to_string(sides) + " sides over " + std::to_string(times.size()) + " frame pairs, last to first included, " +
+          std::to_string(failed) + " differ");
+
+    testSection("between with resting orders");
+    const std::string& start = times[0];
+    const std::string& second = times[1];
+    FrameDelta quiet = BookDelta::between(book, second, second);
+    check(quiet.products.empty(), "nothing changes from a frame to itself");
+    OrderBookEntry bid{0.001, 5, second, "ETH/BTC", OrderBookType::bid, "simuser"};
+    book.insertOrder(bid);
+    FrameDelta withUser = BookDelta::between(book, second, second);
+    check(withUser.products.empty(), "a resting order is in both frames, so it is no change");
+    FrameDelta delta = BookDelta::between(book, start, second);
+    bool levelsMatch = true;
+    for (const ProductDelta& p : delta.products)
+    {
+        for (OrderBookType side : {OrderBookType::bid, OrderBookType::ask})
+        {
+            std::vector<LevelDelta> sideChanges;
+            for (const LevelDelta& c : p.changes)
+            {
+                if (c.side == side) sideChanges.push_back(c);
+            }
+            std::vector<PriceLevel> levels = book.getDepth(side, p.product, start, ALL_LEVELS);
+            BookDelta::apply(levels, side, sideChanges);
+            if (!sameLevels(levels, book.getDepth(side, p.product, second, ALL_LEVELS))) levelsMatch = false;
+        }
+    }
+    check(!delta.products.empty() && levelsMatch, "the first frame's depth with between applied is the second frame's");
+
+    testSection("the stream form");
+    std::stringstream stream;
+    BookDelta::write(stream, delta);
+    BookDelta::write(stream, quiet);
+    FrameDelta back;
+    check(BookDelta::read(stream, back) && sameDelta(back, delta), "the first frame reads back as written");
+    check(BookDelta::read(stream, back) && sameDelta(back, quiet), "so does a frame without changes");
+    check(!BookDelta::read(stream, back), "then the stream ends");
+
+    std::stringstream whole;
+    BookDelta::write(whole, delta);
+    std::string bytes = whole.str();
+    std::istringstream cut{bytes.substr(0, bytes.size() - 10)};
+    check(throws([&cut, &back] { BookDelta::read(cut, back); }), "a frame cut short throws");
+
+    return testFailures();
+}
@@ -0,0 +1,95 @@
+#include "BookHistory.h"
+#include "OrderBook.h"
+#include "TestCheck.h"
+#include <string>
+#include <vector>
+
+namespace
+{
+    /** what the user does in frame f: quote around the mid, lifting the best ask every third
+     *  frame so some orders fill in part, cancel and replace now and then, match */
+    void step(OrderBook& book, unsigned int f, const std::string& timestamp)
+    {
+        double mid = book.getMidPrice("ETH/BTC", timestamp);
+        std::vector<PriceLevel> best = book.getDepth(OrderBookType::ask, "ETH/BTC", timestamp, 1);
+        double price = f % 3 == 0 && !best.empty() ? best[0].price : mid * (1 - 0.001 * (f % 3));
+        OrderBookEntry bid{price, 1.0 + f, timestamp, "ETH/BTC", OrderBookType::bid, "simuser"};
+        OrderBookEntry ask{mid * 1.002, 0.5, timestamp, "ETH/BTC", OrderBookType::ask, "simuser"};
+        book.insertOrder(bid);
+        book.insertOrder(ask);
+
+        std::vector<OrderBookEntry> resting = byId(book.getRestingOrders());
+        if (f % 2 == 1 && !resting.empty()) book.cancelOrder(resting.front().id);
+        if (f % 3 == 2 && resting.size() > 1) book.replaceOrder(resting[1].id, resting[1].price * 0.999, resting[1].amount * 2);
+
+        for (const std::string& product : book.getKnownProducts())
+        {
+            book.matchAsksToBids(product, timestamp);
+        }
+    }
+
+    bool sameOrders(const std::vector<OrderBookEntry>& a, const std::vector<OrderBookEntry>& b)
+    {
+        if (a.size() != b.size()) return false;
+        for (std::size_t i = 0; i < a.size(); ++i)
+        {
+            if (a[i].id != b[i].id || a[i].price != b[i].price || a[i].amount != b[i].amount) return false;
+        }
+        return true;
+    }
+
+    bool sameDepth(const BookSnapshot& a, const BookSnapshot& b)
+    {
+        for (const std::string& product : a.getKnownProducts())
+        {
+            for (OrderBookType side : {OrderBookType::bid, OrderBookType::ask})
+            {
+                if (!sameLevels(a.getDepth(side, product, ALL_LEVELS), b.getDepth(side, product, ALL_LEVELS))) return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main()
+{
+    testTitle("BookHistory");
+    OrderBook book{TEST_DATASET};
+    BookHistory history{book, 3}; // Checkpoints at frames 0, 3 and 6, deltas between
+    std::vector<std::string> times = testFrames(book);
+    for (std::size_t f = 0; f < times.size(); ++f)
+    {
+        history.record(times[f]);
+        step(book, f, times[f]);
+    }
+
+    testSection("the frames recorded");
+    check(history.frameCount() == times.size(), std::to_string(times.size()) + " frames recorded");
+    check(history.checkpointCount() == (times.size() + 2) / 3, "a checkpoint every 3 frames");
+
+    testSection("bookAt against a replay from the start");
+    for (std::size_t f = 0; f < times.size(); ++f)
+    {
+        OrderBook replay{TEST_DATASET};
+        for (std::size_t g = 0; g < f; ++g)
+        {
+            step(replay, g, times[g]);
+        }
+        std::unique_ptr<const BookSnapshot> kept = history.bookAt(times[f]);
+        std::unique_ptr<const BookSnapshot> live = replay.makeSnapshot(times[f], f);
+        std::vector<OrderBookEntry> resting = byId(replay.getRestingOrders());
+        check(kept != nullptr && sameDepth(*kept, *live) && sameOrders(byId(history.getRestingAt(times[f])), resting),
+              "frame " + std::to_string(f) + ": same depth and the same " + std::to_string(resting.size()) + " resting orders");
+    }
+
+    testSection("timestamps between and before frames");
+    check(history.bookAt("2000/01/01 00:00:00.000000") == nullptr, "nothing before the first frame");
+    std::unique_ptr<const BookSnapshot> between = history.bookAt(times[2] + "1");
+    check(between != nullptr && between->getTimestamp() == times[2], "a time inside a frame gives that frame");
+
+    testSection("a replay starting over");
+    history.record(times[0]);
+    check(history.frameCount() == 1, "recording the first frame again clears the rest");
+
+    return testFailures();
+}
@@ -0,0 +1,154 @@
+#include "CSVReader.h"
+#include "ChunkedAnalytics.h"
+#include "OrderBook.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+    bool sameSummary(const PriceSummary& a, const PriceSummary& b)
+    {
+        return a.count == b.count && a.low == b.low && a.high == b.high &&
+               near(a.sum, b.sum) && near(a.amount, b.amount) && near(a.notional, b.notional);
+    }
+
+    bool identical(const PriceSummary& a, const PriceSummary& b)
+    {
+        return a.count == b.count && a.low == b.low && a.high == b.high &&
+               a.sum == b.sum && a.amount == b.amount && a.notional == b.notional;
+    }
+
+    bool identical(const ChunkedResult& a, const ChunkedResult& b)
+    {
+        if (a.rows != b.rows || a.rejected != b.rejected || a.bytes != b.bytes || a.products.size() != b.products.size())
+        {
+            return false;
+        }
+        for (const auto& [product, stats] : a.products)
+        {
+            auto it = b.products.find(product);
+            if (it == b.products.end() || !identical(stats.bids, it->second.bids) || !identical(stats.asks, it->second.asks))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** the statistics of the loaded orders with from <= timestamp <= to */
+    std::map<std::string, ProductStats> inMemory(const std::vector<OrderBookEntry>& entries,
+                                                 const std::string& from, const std::string& to)
+    {
+        std::map<std::string, std::vector<OrderBookEntry>> bids, asks;
+        for (const OrderBookEntry& e : entries)
+        {
+            if (e.timestamp < from || e.timestamp > to) continue;
+            (e.orderType == OrderBookType::bid ? bids : asks)[e.product].push_back(e);
+            bids[e.product]; // Both sides listed, the way a product shows up in a result
+            asks[e.product];
+        }
+        std::map<std::string, ProductStats> stats;
+        for (const auto& [product, orders] : bids)
+        {
+            stats[product] = ProductStats{OrderBook::getPriceSummary(orders), OrderBook::getPriceSummary(asks[product])};
+        }
+        return stats;
+    }
+
+    /** every product in result against the loaded orders, false if any differs or is missing */
+    bool matches(const ChunkedResult& result, const std::map<std::string, ProductStats>& want, std::size_t rows)
+    {
+        if (result.rows != rows || result.products.size() != want.size()) return false;
+        for (const auto& [product, stats] : want)
+        {
+            auto it = result.products.find(product);
+            if (it == result.products.end() || !sameSummary(it->second.bids, stats.bids) ||
+                !sameSummary(it->second.asks, stats.asks))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** length of the longest line of the dataset, line break included */
+    std::size_t longestLine()
+    {
+        std::ifstream in{TEST_DATASET};
+        std::string line;
+        std::size_t longest = 0;
+        while (std::getline(in, line)) longest = std::max(longest, line.size() + 1);
+        return longest;
+    }
+
+    std::size_t countRows(const std::map<std::string, ProductStats>& stats)
+    {
+        std::size_t rows = 0;
+        for (const auto& [product, s] : stats) rows += s.bids.count + s.asks.count;
+        return rows;
+    }
+}
+
+int main()
+{
+    testTitle("ChunkedAnalytics");
+    std::vector<OrderBookEntry> entries = CSVReader::readCSV(TEST_DATASET);
+    OrderBook book{TEST_DATASET};
+    std::vector<std::string> times = testFrames(book);
+    const std::string& first = times.front();
+    const std::string& last = times.back();
+
+    ChunkedAnalytics whole{TEST_DATASET};
+    ChunkedAnalytics small{TEST_DATASET, 4096, 4096}; // Chunks and blocks far smaller than the file
+    ChunkedAnalytics odd{TEST_DATASET, 1000, 333};    // Blocks shorter than some lines
+
+    testSection("chunking");
+    check(whole.chunkCount() == 1, "the default chunk size reads the file as one chunk");
+    check(small.chunkCount() > 10, std::to_string(small.chunkCount()) + " chunks of 4 KB");
+
+    testSection("against the orders in memory");
+    std::map<std::string, ProductStats> all = inMemory(entries, first, last);
+    ChunkedResult one = whole.run("", "", 1);
+    ChunkedResult many = small.run("", "", 1);
+    check(matches(one, all, entries.size()), "one chunk: " + std::to_string(one.rows) + " rows, every product and side");
+    check(matches(many, all, entries.size()), std::to_string(many.chunks) + " chunks: the same");
+    check(matches(odd.run("", "", 1), all, entries.size()), "333 byte blocks: the same");
+    std::size_t size = std::filesystem::file_size(TEST_DATASET);
+    check(one.bytes == size, "one chunk reads the " + std::to_string(size) + " bytes once");
+    check(many.bytes >= size && many.bytes - size <= (many.chunks - 1) * longestLine(),
+          std::to_string(many.bytes) + " bytes, no more than one line read twice where chunks meet");
+    check(one.rejected == many.rejected, std::to_string(many.rejected) + " rejected either way");
+    bool rangesMatch = true;
+    for (const auto& [product, stats] : many.products)
+    {
+        RangeSummary bids = book.getRangeSummary(OrderBookType::bid, product, first, last);
+        RangeSummary asks = book.getRangeSummary(OrderBookType::ask, product, first, last);
+        if (bids.count != stats.bids.count || !near(bids.volume, stats.bids.amount) || !near(bids.notional, stats.bids.notional) ||
+            asks.count != stats.asks.count || !near(asks.volume, stats.asks.amount) || !near(asks.notional, stats.asks.notional))
+        {
+            rangesMatch = false;
+        }
+    }
+    check(rangesMatch, "count, volume and notional agree with OrderBook::getRangeSummary");
+
+    testSection("threads");
+    check(identical(small.run("", "", 3), many), "3 threads give exactly what 1 does");
+    check(identical(small.run("", "", 0), many), "so does one per core");
+
+    testSection("a time range");
+    const std::string& from = times[1];
+    const std::string& to = times[3];
+    std::map<std::string, ProductStats> part = inMemory(entries, from, to);
+    ChunkedResult range = small.run(from, to, 3);
+    check(matches(range, part, countRows(part)), "frames 2 to 4: " + std::to_string(range.rows) + " rows");
+    check(matches(small.run(from, "", 1), inMemory(entries, from, last), countRows(inMemory(entries, from, last))),
+          "an open end runs to the last frame");
+    check(small.run("2000/01/01", "2000/01/02", 2).rows == 0, "a range before the data has no rows");
+
+    return testFailures();
+}
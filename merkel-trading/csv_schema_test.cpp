@@ -0,0 +1,94 @@
+#include "CSVSchema.h"
+#include "TestCheck.h"
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    struct PriceRow
+    {
+        std::string_view time;
+        double price;
+        std::optional<double> size;
+    };
+
+    struct LevelsRow
+    {
+        std::string product;
+        std::vector<double> prices;
+    };
+
+    constexpr char timeColumn[] = "time";
+    constexpr char priceColumn[] = "price";
+    constexpr char sizeColumn[] = "size";
+    constexpr char productColumn[] = "product";
+    constexpr char priceSuffix[] = "_price";
+
+    using PriceSchema = CSVSchema<PriceRow,
+                                  CSVColumn<CSVNamed<timeColumn>, &PriceRow::time>,
+                                  CSVColumn<CSVNamed<priceColumn>, &PriceRow::price>,
+                                  CSVOptional<CSVNamed<sizeColumn>, &PriceRow::size>>;
+    using PositionSchema = CSVSchema<PriceRow,
+                                     CSVColumn<CSVAt<0>, &PriceRow::time>,
+                                     CSVColumn<CSVAt<2>, &PriceRow::price>,
+                                     CSVOptional<CSVAt<3>, &PriceRow::size>>;
+    using LevelsSchema = CSVSchema<LevelsRow,
+                                   CSVColumn<CSVNamed<productColumn>, &LevelsRow::product>,
+                                   CSVColumn<CSVEndsWith<priceSuffix>, &LevelsRow::prices>>;
+    using ClashSchema = CSVSchema<PriceRow,
+                                  CSVColumn<CSVNamed<priceColumn>, &PriceRow::price>,
+                                  CSVOptional<CSVAt<1>, &PriceRow::size>>;
+
+    template <typename Schema>
+    bool throwsOn(std::string_view header)
+    {
+        return throws([header] { CSVRowParser<Schema> parser{header}; });
+    }
+}
+
+int main()
+{
+    testTitle("CSV Schema");
+
+    testSection("CSVRowParser by name");
+    CSVRowParser<PriceSchema> byName{"size,\"time\",venue,price"};
+    PriceRow row{};
+    check(byName.parse("2,2020/03/17,x,0.5", row) && row.time == "2020/03/17" && row.price == 0.5 && row.size == 2.0,
+          "columns found in any order, a quoted header included");
+    check(byName.parse("n/a,2020/03/17,x,0.5", row) && !row.size.has_value(), "an optional field that does not convert is left empty");
+    check(!byName.parse("2,2020/03/17,x,cheap", row), "a required field that does not convert fails the row");
+    check(!byName.parse("2,2020/03/17,x", row), "a line without the required price fails");
+    check(throwsOn<PriceSchema>("time,size"), "a header without a required column throws");
+    check(!throwsOn<PriceSchema>("time,price"), "a header without an optional column does not");
+    check(throwsOn<ClashSchema>("time,price"), "two columns on one field throw");
+
+    testSection("CSVRowParser by position");
+    CSVRowParser<PositionSchema> byPosition;
+    check(byPosition.parse("t,x,1.5", row) && row.price == 1.5 && !row.size.has_value(),
+          "a short line still parses without its optional column");
+    row.size = 9.0;
+    check(byPosition.parse("t,x,1.5,3", row) && row.size == 3.0, "and with it");
+    check(byPosition.parse("t,x,1.5", row) && !row.size.has_value(), "an optional left from the last row is cleared");
+    check(!byPosition.parse("t,x", row), "a line that ends before a required column fails");
+    byPosition.setMinFields(5);
+    byPosition.setMaxFields(6);
+    check(!byPosition.parse("t,x,1.5,3", row), "4 fields are under the minimum of 5");
+    check(byPosition.parse("t,x,1.5,3,y,z", row), "6 fields are inside 5 to 6");
+    check(!byPosition.parse("t,x,1.5,3,y,z,w", row), "7 fields are over the maximum");
+    CSVRowParser<PositionSchema> spaced{' ', true};
+    check(spaced.parse("t  x   1.5 ", row) && row.price == 1.5, "skipEmpty counts a run of separators as one");
+
+    testSection("CSVEndsWith");
+    CSVRowParser<LevelsSchema> levels{"product,bid_price,bid_size,ask_price,last_price"};
+    check(levels.getWidth(1) == 3 && levels.getHeaders(1) == std::vector<std::string>{"bid_price", "ask_price", "last_price"},
+          "three headers end in _price, in header order");
+    LevelsRow lrow;
+    check(levels.parse("ETH/BTC,1,9,2,1.5", lrow) && lrow.product == "ETH/BTC" &&
+          lrow.prices == std::vector<double>{1, 2, 1.5}, "read into the vector, bid_size skipped");
+    check(!levels.parse("ETH/BTC,1,9,x,1.5", lrow), "one that does not convert fails the row");
+    check(throwsOn<LevelsSchema>("product,bid,ask"), "no header with the suffix throws");
+
+    return testFailures();
+}
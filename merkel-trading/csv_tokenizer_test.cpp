@@ -0,0 +1,60 @@
+#include "CSVTokenizer.h"
+#include "TestCheck.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    /** every field of line, unquoted */
+    std::vector<std::string> fields(std::string_view line, char separator = ',', bool skipEmpty = false)
+    {
+        std::vector<std::string> out;
+        CSVTokenizer t{line, separator, skipEmpty};
+        while (t.next())
+        {
+            out.push_back(t.unquoted());
+        }
+        return out;
+    }
+}
+
+int main()
+{
+    testTitle("CSVTokenizer");
+
+    testSection("fields");
+    check(fields("a,b,c") == std::vector<std::string>{"a", "b", "c"}, "a plain line");
+    check(fields("a,,c,") == std::vector<std::string>{"a", "", "c", ""}, "empty fields, a trailing one included");
+    check(fields("") == std::vector<std::string>{""}, "an empty line is one empty field");
+    check(fields("a,,c,", ',', true) == std::vector<std::string>{"a", "c"}, "skipEmpty drops empty fields");
+    check(fields(",,", ',', true).empty(), "skipEmpty on separators alone gives none");
+    check(fields("a,b\r") == std::vector<std::string>{"a", "b"}, "a trailing \\r is dropped");
+    check(fields("a;b,c", ';') == std::vector<std::string>{"a", "b,c"}, "another separator");
+    check(fields("\"x,y\",z") == std::vector<std::string>{"x,y", "z"}, "a quoted field holds a separator");
+    check(fields("\"say \"\"hi\"\"\",z") == std::vector<std::string>{"say \"hi\"", "z"}, "doubled quotes are undoubled");
+    check(fields("\"\",z", ',', true) == std::vector<std::string>{"", "z"}, "skipEmpty keeps an empty quoted field");
+    check(fields("\"open,z") == std::vector<std::string>{"open,z"}, "no closing quote takes the rest of the line");
+    CSVTokenizer t{"\"a\"\"b\",c"};
+    check(t.next() && t.quoted() && t.field() == "a\"\"b" && t.unquoted() == "a\"b",
+          "field() leaves doubled quotes, unquoted() does not");
+    check(t.next() && t.index() == 1 && !t.quoted() && !t.next(), "then field 1 and the end");
+    CSVTokenizer s{"a,b,c,d"};
+    check(s.skip(2) && s.next() && s.field() == "c", "skip 2 then the third field");
+    check(!s.skip(2), "skipping past the end fails");
+    check(CSVTokenizer::countFields("a,b,,d") == 4 && CSVTokenizer::countFields("a,b,,d", ',', true) == 3, "countFields");
+
+    testSection("numbers");
+    double d = -1;
+    int i = -1;
+    check(CSVTokenizer::parseNumber(" 0.25 ", d) && d == 0.25, "spaces around a number are allowed");
+    check(CSVTokenizer::parseNumber("+3", i) && i == 3, "a leading + is allowed");
+    check(CSVTokenizer::parseNumber("-1e-3", d) && d == -0.001, "a negative exponent");
+    d = 7;
+    check(!CSVTokenizer::parseNumber("1.5x", d) && d == 7, "trailing garbage fails and leaves the value");
+    check(!CSVTokenizer::parseNumber("", d) && !CSVTokenizer::parseNumber("  ", d) && !CSVTokenizer::parseNumber("+", d),
+          "empty, blank and a lone + fail");
+    check(!CSVTokenizer::parseNumber("2.5", i) && !CSVTokenizer::parseNumber("99999999999", i), "2.5 and an overflow are not ints");
+
+    return testFailures();
+}
@@ -5,9 +5,305 @@
 #include <vector>
 #include <exception>
 #include "Wallet.h"
+#include "ParameterSweep.h"
+#include "ReportWriter.h"
+#include "OrderArchive.h"
+#include "ArbitrageScanner.h"
+#include "BookDelta.h"
+#include "ChunkedAnalytics.h"
+#include "EventSimulator.h"
+#include "QuotingAgent.h"
+#include "StrategyRunner.h"
+#ifdef __linux__
+#include "GatewayServer.h"
+#include "MarketDataPublisher.h"
+#include "MarketDataReader.h"
+#include "StrategyLibrary.h"
+#endif
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <thread>
 
-int main()
+int main(int argc, char* argv[])
 {
+      // Headless parameter sweep: merkelrex --sweep <orderbook.csv> [configs.csv] [threads]
+      if (argc >= 3 && std::string{argv[1]} == "--sweep")
+      {
+            OrderBook book{argv[2]}; // Loaded and indexed once for every run
+            std::vector<StrategyConfig> configs = argc >= 4 ? ParameterSweep::readConfigs(argv[3])
+                                                            : ParameterSweep::defaultGrid(book);
+            unsigned int threads = argc >= 5 ? std::stoul(argv[4]) : 0;
+
+            Wallet wallet;
+            wallet.insertCurrency("BTC", 10.);
+
+            ParameterSweep sweep{book};
+            std::vector<BacktestResult> results = sweep.run(configs, wallet, threads);
+            std::cout << ParameterSweep::formatResults(results);
+
+            MemoryReport memory;
+            book.reportMemory(memory);
+            memory.add("wallet", wallet.memoryUsage());
+            std::cout << memory.toString();
+            return 0;
+      }
+
+      // Headless pipelined replay of one strategy, fills go to stdout:
+      // merkelrex --replay <orderbook.csv> <product> <edge> <size> [fifo|prorata|size/ask|bid|mid]
+      if (argc >= 6 && std::string{argv[1]} == "--replay")
+      {
+            OrderBook book{argv[2]};
+            Wallet wallet;
+            wallet.insertCurrency("BTC", 10.);
+
+            StrategyConfig config{"replay", argv[3], std::stod(argv[4]), std::stod(argv[5])};
+            if (argc >= 7 && !MatchingRules::parse(argv[6], config.allocation, config.tradePrice))
+            {
+                  std::cerr << "Unknown matching rules " << argv[6] << std::endl;
+                  return 1;
+            }
+            Backtest backtest{book, config, wallet};
+            ReportWriter report{std::cout, ReportFormat::csv, true}; // Written on its own thread
+            backtest.setReport(&report);
+            BacktestResult result = backtest.runPipelined();
+            report.flush();
+            std::cout << ParameterSweep::formatResults({result});
+
+            MemoryReport memory;
+            book.reportMemory(memory);
+            memory.add("backtest", backtest.memoryUsage());
+            memory.add("report", report.memoryUsage());
+            std::cout << memory.toString();
+            return 0;
+      }
+
+      // Continuous time replay, every order matched as it arrives, with one quoting agent:
+      // merkelrex --continuous <orderbook.csv> <product> <edge> <size> [latency us] [interval us] [order lifetime us]
+      if (argc >= 6 && std::string{argv[1]} == "--continuous")
+      {
+            std::vector<OrderBookEntry> orders = OrderArchive::isArchive(argv[2]) ? OrderArchive::read(argv[2])
+                                                                                   : CSVReader::readCSV(argv[2]);
+            std::int64_t latency = argc >= 7 ? std::stoll(argv[6]) : 0;
+            std::int64_t interval = argc >= 8 ? std::stoll(argv[7]) : 1000000;
+            std::int64_t lifetime = argc >= 9 ? std::stoll(argv[8]) : 0;
+
+            EventSimulator sim{orders, lifetime};
+            QuotingAgent agent{StrategyConfig{"continuous", argv[3], std::stod(argv[4]), std::stod(argv[5])}, interval};
+            sim.addAgent(agent, latency);
+            auto started = std::chrono::steady_clock::now();
+            SimulationResult result;
+            try
+            {
+                  result = sim.run();
+            }
+            catch (const std::exception& e) // An agent with more orders in flight than there are slots
+            {
+                  std::cerr << "Continuous replay stopped: " << e.what() << std::endl;
+                  return 1;
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+            std::cout << EventSimulator::toTimestamp(result.start) << " to " << EventSimulator::toTimestamp(result.end) << std::endl;
+            std::cout << result.events << " events in " << seconds << "s, " << result.trades << " trades, volume "
+                      << result.volume << ", " << result.expired << " expired, " << result.dropped << " dropped" << std::endl;
+            std::cout << "Agent placed " << agent.getOrdersPlaced() << " orders, " << agent.getFills()
+                      << " fills, volume " << agent.getVolume() << ", position " << agent.getPosition() << std::endl;
+            return 0;
+      }
+
+#ifdef __linux__ // Strategy libraries, the feed and the gateway need Linux, see the Makefile
+      // Headless replay of a strategy library: merkelrex --strategy <orderbook.csv> <strategy.so> [args]
+      if (argc >= 4 && std::string{argv[1]} == "--strategy")
+      {
+            OrderBook book{argv[2]};
+            StrategyLibrary library{argv[3], argc >= 5 ? argv[4] : ""};
+            Wallet wallet;
+            wallet.insertCurrency("BTC", 10.);
+
+            StrategyRunner runner{book, library.getStrategy(), wallet};
+            StrategyResult result = runner.run();
+            std::cout << result.frames << " frames, " << result.ordersPlaced << " orders placed, "
+                      << result.ordersRejected << " rejected, " << result.fills << " fills, volume "
+                      << result.volume << std::endl;
+            std::cout << result.wallet;
+            return 0;
+      }
+#endif
+
+      // Level deltas between consecutive frames as a binary stream:
+      // merkelrex --deltas <orderbook.csv> <out.deltas>
+      if (argc >= 4 && std::string{argv[1]} == "--deltas")
+      {
+            OrderBook book{argv[2]};
+            std::ofstream out{argv[3], std::ios::binary};
+            std::string start = book.getEarliestTime();
+            std::string from = start;
+            std::size_t changes = 0, levels = 0, frames = 0;
+            while (true)
+            {
+                  std::string to = book.getNextTime(from);
+                  if (to == start || to.empty()) break;
+                  FrameDelta delta = BookDelta::between(book, from, to);
+                  BookDelta::write(out, delta);
+                  for (const ProductDelta& p : delta.products) changes += p.changes.size();
+                  for (const std::string& p : book.getKnownProducts())
+                  {
+                        levels += book.getDepth(OrderBookType::bid, p, to, 1u << 30).size() +
+                                  book.getDepth(OrderBookType::ask, p, to, 1u << 30).size();
+                  }
+                  frames++;
+                  from = to;
+            }
+            std::cout << frames << " frame changes, " << changes << " level deltas against "
+                      << levels << " levels in the full books, " << out.tellp() << " bytes" << std::endl;
+            return 0;
+      }
+
+      // Per product statistics over csv data of any size, read in chunks without loading it:
+      // merkelrex --stats <orderbook.csv|directory> [from] [to] [threads]
+      if (argc >= 3 && std::string{argv[1]} == "--stats")
+      {
+            ChunkedAnalytics analytics{argv[2]};
+            std::string from = argc >= 4 ? argv[3] : "";
+            std::string to = argc >= 5 ? argv[4] : "";
+            unsigned int threads = argc >= 6 ? std::stoul(argv[5]) : 0;
+            std::cout << ChunkedAnalytics::formatResult(analytics.run(from, to, threads));
+            return 0;
+      }
+
+      // Triangular arbitrage report, every frame: merkelrex --arbitrage <orderbook.csv> [minEdge] [fee]
+      if (argc >= 3 && std::string{argv[1]} == "--arbitrage")
+      {
+            OrderBook book{argv[2]};
+            double minEdge = argc >= 4 ? std::stod(argv[3]) : 0;
+            ArbitrageScanner scanner{book, argc >= 5 ? std::stod(argv[4]) : 0};
+            std::cout << scanner.cycleCount() << " cycles" << std::endl;
+            std::string start = book.getEarliestTime();
+            std::string timestamp = start;
+            do
+            {
+                  std::vector<ArbitrageOpportunity> found = scanner.scan(timestamp, minEdge);
+                  std::cout << timestamp << ": " << found.size() << " above min edge" << std::endl;
+                  std::cout << ArbitrageScanner::formatOpportunities(found);
+                  timestamp = book.getNextTime(timestamp);
+            } while (timestamp != start && !timestamp.empty());
+            return 0;
+      }
+
+#ifdef __linux__
+      // Replay frames into a shared memory market data feed:
+      // merkelrex --feed <orderbook.csv> <feed name> [depth] [frame millis]
+      if (argc >= 4 && std::string{argv[1]} == "--feed")
+      {
+            OrderBook book{argv[2]};
+            MarketDataPublisher feed{argv[3]};
+            unsigned int depth = argc >= 5 ? std::stoul(argv[4]) : 10;
+            int frameMillis = argc >= 6 ? std::stoi(argv[5]) : 0;
+            std::string start = book.getEarliestTime();
+            std::string timestamp = start;
+            std::uint32_t frame = 0;
+            do
+            {
+                  feed.frameStart(frame, timestamp);
+                  for (const std::string& product : book.getKnownProducts())
+                  {
+                        feed.levels(frame, product, OrderBookType::bid, book.getDepth(OrderBookType::bid, product, timestamp, depth));
+                        feed.levels(frame, product, OrderBookType::ask, book.getDepth(OrderBookType::ask, product, timestamp, depth));
+                        feed.trades(frame, book.matchAsksToBids(product, timestamp));
+                  }
+                  feed.frameEnd(frame);
+                  frame++;
+                  std::this_thread::sleep_for(std::chrono::milliseconds(frameMillis));
+                  timestamp = book.getNextTime(timestamp);
+            } while (timestamp != start && !timestamp.empty());
+            std::cout << "Published " << feed.getPublished() << " records" << std::endl;
+            return 0;
+      }
+
+      // Print a market data feed as it arrives: merkelrex --watch <feed name>
+      if (argc >= 3 && std::string{argv[1]} == "--watch")
+      {
+            MarketDataReader reader{argv[2], true};
+            MarketDataRecord r;
+            while (true)
+            {
+                  if (!reader.next(r))
+                  {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                        continue;
+                  }
+                  std::cout << r.sequence << " frame " << r.frame << " ";
+                  switch (r.kind)
+                  {
+                        case MarketDataKind::frameStart: std::cout << "start " << r.getText(); break;
+                        case MarketDataKind::level: std::cout << "level " << r.getText() << (r.side == 0 ? " bid " : " ask ")
+                                                              << r.depth << " " << r.price << " x " << r.amount; break;
+                        case MarketDataKind::trade: std::cout << "trade " << r.getText() << " " << r.price << " x " << r.amount; break;
+                        case MarketDataKind::frameEnd: std::cout << "end"; break;
+                  }
+                  std::cout << std::endl;
+                  if (r.kind == MarketDataKind::frameEnd && reader.getDropped() > 0)
+                  {
+                        std::cout << "dropped " << reader.getDropped() << std::endl;
+                  }
+            }
+      }
+
+      // Serve binary order entry on a Unix domain socket, optionally publishing market data:
+      // merkelrex --gateway <orderbook.csv> <socket> [feed name]
+      if (argc >= 4 && std::string{argv[1]} == "--gateway")
+      {
+            OrderBook book{argv[2]};
+            GatewayServer server{book, argv[3]};
+            std::unique_ptr<MarketDataPublisher> feed;
+            if (argc >= 5)
+            {
+                  feed.reset(new MarketDataPublisher{argv[4]});
+                  server.setPublisher(feed.get());
+            }
+            // a dashboard thread polls book snapshots, it never holds up matching
+            BookSnapshots snapshots;
+            server.setSnapshots(&snapshots);
+            std::atomic<bool> serving{true};
+            std::thread dashboard{[&snapshots, &serving]()
+            {
+                  BookSnapshots::Reader reader{snapshots};
+                  std::uint64_t shown = ~std::uint64_t{0};
+                  while (serving.load())
+                  {
+                        reader.read([&shown](const BookSnapshot& snapshot)
+                        {
+                              if (snapshot.getVersion() == shown) return;
+                              shown = snapshot.getVersion();
+                              std::cout << "Frame " << shown << " " << snapshot.getTimestamp();
+                              for (const std::string& product : snapshot.getKnownProducts())
+                              {
+                                    std::cout << " " << product << " mid: " << snapshot.getMidPrice(product);
+                              }
+                              std::cout << std::endl;
+                        });
+                        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                  }
+            }};
+            std::cout << "Gateway listening on " << argv[3] << std::endl;
+            server.run();
+            serving = false;
+            dashboard.join();
+            return 0;
+      }
+#endif
+
+      // Convert a csv order book to the compressed archive format:
+      // merkelrex --archive <orderbook.csv> <orderbook.mka>
+      if (argc >= 4 && std::string{argv[1]} == "--archive")
+      {
+            std::vector<OrderBookEntry> entries = CSVReader::readCSV(argv[2]);
+            OrderArchive::write(entries, argv[3]);
+            std::cout << "Wrote " << entries.size() << " entries to " << argv[3] << std::endl;
+            return 0;
+      }
 
       MerkelMain mainApp;
       mainApp.init();
@@ -0,0 +1,107 @@
+#include "MatchingEngine.h"
+#include "TestCheck.h"
+#include <vector>
+
+namespace
+{
+    const std::string TIME = "2020/03/17 17:01:24.884492";
+    const std::string PRODUCT = "ETH/BTC";
+
+    OrderBookEntry order(OrderBookType type, double price, double amount,
+                         OrderExecution execution = OrderExecution::limit)
+    {
+        OrderBookEntry e{price, amount, TIME, PRODUCT, type};
+        e.execution = execution;
+        return e;
+    }
+
+    /** bids of 1 then 3 at 10, against one ask of 2 at 9 */
+    std::vector<OrderBookEntry> matchLevel(MatchFunction match)
+    {
+        std::vector<OrderBookEntry> asks{order(OrderBookType::ask, 9, 2)};
+        std::vector<OrderBookEntry> bids{order(OrderBookType::bid, 10, 1), order(OrderBookType::bid, 10, 3)};
+        RestingOrders overlay;
+        return match(asks, bids, PRODUCT, TIME, overlay);
+    }
+
+    /** asks of 1 at 9, 10 and 11 against one taker bid */
+    std::vector<OrderBookEntry> sweep(double price, double amount, OrderExecution execution)
+    {
+        std::vector<OrderBookEntry> asks{order(OrderBookType::ask, 11, 1), order(OrderBookType::ask, 9, 1),
+                                         order(OrderBookType::ask, 10, 1)};
+        std::vector<OrderBookEntry> bids{order(OrderBookType::bid, price, amount, execution)};
+        RestingOrders overlay;
+        return MatchingEngine<FifoAllocation, AskPrice>::matchFrame(asks, bids, PRODUCT, TIME, overlay);
+    }
+
+    bool sales(const std::vector<OrderBookEntry>& got, const std::vector<std::pair<double, double>>& want)
+    {
+        if (got.size() != want.size()) return false;
+        for (std::size_t i = 0; i < got.size(); ++i)
+        {
+            if (!near(got[i].price, want[i].first) || !near(got[i].amount, want[i].second)) return false;
+        }
+        return true;
+    }
+
+    double volume(const std::vector<OrderBookEntry>& got)
+    {
+        double total = 0;
+        for (const OrderBookEntry& e : got) total += e.amount;
+        return total;
+    }
+}
+
+int main()
+{
+    testTitle("MatchingEngine");
+
+    testSection("allocation on one level (bids 1 and 3 at 10, ask 2 at 9)");
+    check(sales(matchLevel(MatchingRules::select(AllocationRule::fifo, TradePriceRule::askPrice)), {{9, 1}, {9, 1}}),
+          "fifo fills the older bid first: 1 and 1");
+    check(sales(matchLevel(MatchingRules::select(AllocationRule::proRata, TradePriceRule::askPrice)), {{9, 0.5}, {9, 1.5}}),
+          "pro rata shares by size: 0.5 and 1.5");
+    check(sales(matchLevel(MatchingRules::select(AllocationRule::sizePriority, TradePriceRule::askPrice)), {{9, 2}}),
+          "size priority fills the larger bid: 2");
+
+    testSection("trade prices");
+    check(sales(matchLevel(MatchingRules::select(AllocationRule::fifo, TradePriceRule::bidPrice)), {{10, 1}, {10, 1}}),
+          "bid price trades at 10");
+    check(sales(matchLevel(MatchingRules::select(AllocationRule::fifo, TradePriceRule::midPrice)), {{9.5, 1}, {9.5, 1}}),
+          "mid price trades at 9.5");
+
+    testSection("the user's fills");
+    std::vector<OrderBookEntry> asks{order(OrderBookType::ask, 9, 2)};
+    std::vector<OrderBookEntry> bids{order(OrderBookType::bid, 10, 1)};
+    bids[0].username = "simuser";
+    RestingOrders overlay;
+    std::vector<OrderBookEntry> mine = MatchingEngine<FifoAllocation, AskPrice>::matchFrame(asks, bids, PRODUCT, TIME, overlay);
+    check(mine.size() == 1 && mine[0].orderType == OrderBookType::bidsale && mine[0].username == "simuser",
+          "a fill of simuser's bid is a bidsale in their name");
+    OrderBookEntry resting = order(OrderBookType::ask, 9, 2);
+    resting.username = "simuser";
+    unsigned int id = overlay.add(resting);
+    asks = {*overlay.find(id)};
+    bids = {order(OrderBookType::bid, 10, 0.5)};
+    MatchingEngine<FifoAllocation, AskPrice>::matchFrame(asks, bids, PRODUCT, TIME, overlay);
+    check(overlay.find(id) != nullptr && overlay.find(id)->amount == 1.5, "a resting ask has what is left written back, 1.5");
+
+    testSection("IOC, FOK and market orders (asks 1 at 9, 10 and 11)");
+    check(sales(sweep(10, 3, OrderExecution::ioc), {{9, 1}, {10, 1}}), "IOC for 3 up to 10 fills 2, the rest is dropped");
+    check(sweep(10, 3, OrderExecution::fok).empty(), "FOK for 3 up to 10 fills nothing");
+    check(sales(sweep(10, 2, OrderExecution::fok), {{9, 1}, {10, 1}}), "FOK for 2 up to 10 fills all of it");
+    check(near(volume(sweep(1, 3, OrderExecution::market)), 3), "a market order ignores its price and takes all 3");
+    check(sales(sweep(10, 3, OrderExecution::limit), {{9, 1}, {10, 1}}), "a limit bid gets the same fills in the auction");
+
+    testSection("rule names");
+    AllocationRule allocation = AllocationRule::fifo;
+    TradePriceRule price = TradePriceRule::askPrice;
+    check(MatchingRules::parse("prorata/mid", allocation, price) &&
+          allocation == AllocationRule::proRata && price == TradePriceRule::midPrice, "prorata/mid parses");
+    check(MatchingRules::parse(MatchingRules::toString(AllocationRule::sizePriority, TradePriceRule::bidPrice), allocation, price) &&
+          allocation == AllocationRule::sizePriority && price == TradePriceRule::bidPrice, "toString parses back");
+    check(!MatchingRules::parse("lifo/ask", allocation, price) && allocation == AllocationRule::sizePriority,
+          "an unknown rule is refused and changes nothing");
+
+    return testFailures();
+}
@@ -0,0 +1,77 @@
+#include "CSVReader.h"
+#include "OrderArchive.h"
+#include "TestCheck.h"
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    const char* ARCHIVE = "order_archive_test.mka";
+
+    /** index of the first row that differs from want in any field, want.size() if none does */
+    std::size_t firstDifference(const std::vector<OrderBookEntry>& got, const std::vector<OrderBookEntry>& want)
+    {
+        for (std::size_t i = 0; i < want.size(); ++i)
+        {
+            if (i >= got.size()) return i;
+            const OrderBookEntry& a = got[i];
+            const OrderBookEntry& b = want[i];
+            if (a.timestamp != b.timestamp || a.product != b.product || a.orderType != b.orderType ||
+                a.price != b.price || a.amount != b.amount)
+            {
+                return i;
+            }
+        }
+        return got.size() == want.size() ? want.size() : got.size();
+    }
+
+    void roundTrip(const std::string& csv, std::size_t rowsPerBlock)
+    {
+        std::vector<OrderBookEntry> entries = CSVReader::readCSV(csv);
+        OrderArchive::write(entries, ARCHIVE, rowsPerBlock);
+        std::vector<OrderBookEntry> back = OrderArchive::read(ARCHIVE);
+        std::size_t diff = firstDifference(back, entries);
+        check(diff == entries.size(), csv + " in blocks of " + std::to_string(rowsPerBlock) + " reads back the same " +
+              std::to_string(entries.size()) + " rows" + (diff < entries.size() ? ", row " + std::to_string(diff) + " differs" : ""));
+
+        std::string first, last;
+        OrderArchive::readTimeRange(ARCHIVE, first, last);
+        check(first == entries.front().timestamp && last == entries.back().timestamp,
+              "time range " + first + " to " + last + " as written");
+    }
+}
+
+int main()
+{
+    testTitle("OrderArchive");
+
+    testSection("round trips");
+    roundTrip("test.csv", 65536);      // Five digit fractions, written as they were
+    roundTrip("orderBook.csv", 65536);
+    roundTrip("orderBook.csv", 100);   // Many blocks, each with its own dictionary
+
+    testSection("the product dictionary");
+    std::vector<std::string> products = OrderArchive::readProducts(ARCHIVE);
+    check(products == std::vector<std::string>{"BTC/USDT", "DOGE/BTC", "DOGE/USDT", "ETH/BTC", "ETH/USDT"},
+          "readProducts lists the 5 products of orderBook.csv, sorted");
+
+    testSection("mixed timestamp forms");
+    std::vector<OrderBookEntry> mixed{
+        OrderBookEntry{1, 1, "2020/03/17 17:01:24", "ETH/BTC", OrderBookType::bid},
+        OrderBookEntry{1, 1, "2020/03/17 17:01:24.5", "ETH/BTC", OrderBookType::ask},
+        OrderBookEntry{1, 1, "2020/03/17 17:01:24.500000", "ETH/BTC", OrderBookType::ask},
+        OrderBookEntry{1, 1, "2020/03/17 17:01:23.999999", "ETH/BTC", OrderBookType::bid}};
+    OrderArchive::write(mixed, ARCHIVE);
+    check(firstDifference(OrderArchive::read(ARCHIVE), mixed) == mixed.size(),
+          "no fraction, short and long fractions and a step back all read back as written");
+
+    testSection("refusals");
+    check(throws([] { OrderArchive::write({OrderBookEntry{1, 1, "yesterday", "ETH/BTC", OrderBookType::bid}}, ARCHIVE); }),
+          "a timestamp that cannot be stored exactly is refused");
+    check(OrderArchive::formatVersion("MKA1") == 1 && OrderArchive::formatVersion("MKA2") == 2 &&
+          OrderArchive::formatVersion("MKA9") == 0, "format versions 1 and 2 are known, others are not");
+    check(OrderArchive::isArchive(ARCHIVE) && !OrderArchive::isArchive("orderBook.csv"), "archives are told apart by .mka");
+
+    std::remove(ARCHIVE);
+    return testFailures();
+}
@@ -0,0 +1,47 @@
+// Example strategy library: quotes a bid and an ask around the mid of one product every frame.
+// Build: g++ -std=c++17 -O2 -shared -fPIC -I.. MidQuoter.cpp -o midquoter.so
+// Run:   merkelrex --strategy orderBook.csv plugins/midquoter.so ETH/BTC,0.001,0.5
+#include "StrategyApi.h"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+class MidQuoter : public Strategy
+{
+    public:
+        /** args is product,edge,size */
+        MidQuoter(const char* args) : product(-1), edge(0.001), size(0.1)
+        {
+            std::string text{args};
+            std::size_t first = text.find(',');
+            std::size_t second = first == std::string::npos ? first : text.find(',', first + 1);
+            name = text.substr(0, first);
+            if (first != std::string::npos) edge = std::atof(text.c_str() + first + 1);
+            if (second != std::string::npos) size = std::atof(text.c_str() + second + 1);
+        }
+
+        void onFrame(const FrameView& frame, OrderBuffer& out) override
+        {
+            if (product < 0)
+            {
+                for (std::size_t p = 0; p < frame.products.size; ++p)
+                {
+                    if (name == frame.products[p].name) product = static_cast<int>(p);
+                }
+                if (product < 0) return;
+            }
+            const ProductView& view = frame.products[product];
+            out.cancelAll(product);
+            if (view.mid <= 0) return;
+            out.place(product, OrderBookType::bid, view.mid * (1 - edge), size);
+            out.place(product, OrderBookType::ask, view.mid * (1 + edge), size);
+        }
+
+    private:
+        std::string name;
+        int product;
+        double edge;
+        double size;
+};
+
+MERKEL_EXPORT_STRATEGY(MidQuoter)
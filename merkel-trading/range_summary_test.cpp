@@ -0,0 +1,117 @@
+#include "CSVReader.h"
+#include "OrderBook.h"
+#include "TestCheck.h"
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const char* SHARDS = "range_summary_test.shards";
+
+    /** the lines of TEST_DATASET again as a directory of shards of three frames each */
+    void writeShards(const std::vector<std::string>& times)
+    {
+        std::filesystem::remove_all(SHARDS);
+        std::filesystem::create_directory(SHARDS);
+        std::map<std::string, std::vector<std::string>> lines;
+        std::ifstream in{TEST_DATASET};
+        std::string line;
+        while (std::getline(in, line)) lines[line.substr(0, line.find(','))].push_back(line);
+        for (std::size_t f = 0; f < times.size(); ++f)
+        {
+            std::ofstream out{std::string{SHARDS} + "/part" + std::to_string(f / 3) + ".csv", std::ios::app};
+            for (const std::string& l : lines[times[f]]) out << l << "\n";
+        }
+    }
+
+    /** the same totals by adding up every order in the range */
+    RangeSummary bruteForce(const std::vector<OrderBookEntry>& entries, OrderBookType type,
+                            const std::string& product, const std::string& from, const std::string& to)
+    {
+        RangeSummary total{0, 0, 0};
+        for (const OrderBookEntry& e : entries)
+        {
+            if (e.orderType != type || e.product != product || e.timestamp < from || e.timestamp > to) continue;
+            total.volume += e.amount;
+            total.notional += e.price * e.amount;
+            total.count++;
+        }
+        return total;
+    }
+
+    bool same(const RangeSummary& a, const RangeSummary& b)
+    {
+        return a.count == b.count && near(a.volume, b.volume) && near(a.notional, b.notional);
+    }
+
+    /** every product and side of book over [from, to] against the orders, false if any differs */
+    bool allMatch(const OrderBook& book, const std::vector<OrderBookEntry>& entries,
+                  const std::string& from, const std::string& to)
+    {
+        for (const std::string& product : book.getKnownProducts())
+        {
+            for (OrderBookType type : {OrderBookType::bid, OrderBookType::ask})
+            {
+                if (!same(book.getRangeSummary(type, product, from, to), bruteForce(entries, type, product, from, to)))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+int main()
+{
+    testTitle("Range summary");
+    std::vector<OrderBookEntry> entries = CSVReader::readCSV(TEST_DATASET);
+    OrderBook book{TEST_DATASET};
+    std::vector<std::string> times = testFrames(book);
+    writeShards(times);
+    OrderBook sharded{SHARDS};
+
+    testSection("getRangeSummary against adding up the orders");
+    std::size_t ranges = 0;
+    std::size_t failed = 0;
+    std::size_t failedSharded = 0;
+    for (std::size_t a = 0; a < times.size(); ++a)
+    {
+        for (std::size_t b = a; b < times.size(); ++b)
+        {
+            ++ranges;
+            if (!allMatch(book, entries, times[a], times[b])) ++failed;
+            if (!allMatch(sharded, entries, times[a], times[b])) ++failedSharded;
+        }
+    }
+    check(failed == 0, std::to_string(ranges) + " frame ranges, every product and side: " + std::to_string(failed) + " differ");
+    check(failedSharded == 0, "the same over shards of three frames: " + std::to_string(failedSharded) + " differ");
+    check(allMatch(book, entries, times[1] + "1", times[3] + "1") && allMatch(sharded, entries, times[1] + "1", times[3] + "1"),
+          "bounds between frames take the frames inside them");
+    RangeSummary none = book.getRangeSummary(OrderBookType::bid, "ETH/BTC", "2000/01/01", "2000/01/02");
+    check(none.count == 0 && none.volume == 0 && none.vwap() == 0, "a range before the data is empty, vwap 0");
+    check(book.getRangeSummary(OrderBookType::bid, "XRP/BTC", times.front(), times.back()).count == 0,
+          "an unknown product is empty");
+
+    testSection("getRecentSummary");
+    bool recentMatch = true;
+    for (std::size_t last = 0; last < times.size(); ++last)
+    {
+        for (unsigned int n = 1; n <= times.size() + 1; ++n)
+        {
+            const std::string& from = times[last + 1 > n ? last + 1 - n : 0];
+            for (const OrderBook* b : {&book, &sharded})
+            {
+                RangeSummary recent = b->getRecentSummary(OrderBookType::ask, "ETH/BTC", times[last], n);
+                if (!same(recent, bruteForce(entries, OrderBookType::ask, "ETH/BTC", from, times[last]))) recentMatch = false;
+            }
+        }
+    }
+    check(recentMatch, "the last n frames are the range from n frames back, in one file and over shards");
+
+    std::filesystem::remove_all(SHARDS);
+    return testFailures();
+}
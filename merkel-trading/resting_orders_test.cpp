@@ -0,0 +1,138 @@
+#include "RestingOrders.h"
+#include "TestCheck.h"
+#include <limits>
+#include <vector>
+
+/** ids of one side in the order they would be filled */
+static std::vector<unsigned int> queue(const RestingOrders& book, OrderBookType type)
+{
+    std::vector<unsigned int> ids;
+    for (const OrderBookEntry& e : book.getOrders(type, "ETH/BTC"))
+    {
+        ids.push_back(e.id);
+    }
+    return ids;
+}
+
+static double levelAmount(const RestingOrders& book, OrderBookType type, double price)
+{
+    const std::map<double, RestingLevel>* levels = book.getLevels(type, "ETH/BTC");
+    if (levels == nullptr) return 0;
+    auto it = levels->find(price);
+    return it == levels->end() ? 0 : it->second.amount;
+}
+
+int main()
+{
+    testTitle("RestingOrders");
+    RestingOrders book;
+    OrderBookEntry bid{10, 1, "2020/03/17 17:01:24.884492", "ETH/BTC", OrderBookType::bid, "simuser"};
+    unsigned int first = book.add(bid);
+    unsigned int second = book.add(bid);
+    unsigned int third = book.add(bid);
+
+    testSection("time priority on one level");
+    check(queue(book, OrderBookType::bid) == std::vector<unsigned int>{first, second, third}, "three bids at 10 queue in the order they came");
+    check(levelAmount(book, OrderBookType::bid, 10) == 3, "level 10 holds 3");
+
+    testSection("replace and queue position");
+    check(book.replace(first, 10, 0.5), "order 1 reduced to 0.5 at the same price");
+    check(queue(book, OrderBookType::bid) == std::vector<unsigned int>{first, second, third}, "a smaller amount keeps its place");
+    check(levelAmount(book, OrderBookType::bid, 10) == 2.5, "level 10 holds 2.5");
+    check(book.replace(first, 10, 2), "order 1 raised to 2");
+    check(queue(book, OrderBookType::bid) == std::vector<unsigned int>{second, third, first}, "a larger amount goes to the back");
+    check(book.replace(second, 11, 1), "order 2 moved to 11");
+    check(queue(book, OrderBookType::bid) == std::vector<unsigned int>{second, third, first}, "the better price is filled first");
+    check(levelAmount(book, OrderBookType::bid, 10) == 3 && levelAmount(book, OrderBookType::bid, 11) == 1,
+          "levels 10 and 11 hold 3 and 1");
+    check(book.replace(second, 10, 1), "order 2 moved back to 10");
+    check(queue(book, OrderBookType::bid) == std::vector<unsigned int>{third, first, second}, "a new price joins the back of the level");
+    check(book.getLevels(OrderBookType::bid, "ETH/BTC")->count(11) == 0, "the empty level 11 is gone");
+
+    testSection("replace refusals");
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    check(!book.replace(99, 10, 1), "an unknown id cannot be replaced");
+    check(!book.replace(first, 10, 0), "an amount of 0 is refused");
+    check(!book.replace(first, 10, nan), "a NaN amount is refused");
+    check(!book.replace(first, nan, 1), "a NaN price is refused");
+    check(!book.replace(first, std::numeric_limits<double>::infinity(), 1), "an infinite price is refused");
+    check(book.find(first)->amount == 2 && book.find(first)->price == 10, "a refused replace leaves the order alone");
+
+    testSection("cancel");
+    check(book.cancel(third), "order 3 cancelled");
+    check(!book.cancel(third), "cancelling it again fails");
+    check(queue(book, OrderBookType::bid) == std::vector<unsigned int>{first, second}, "the others keep their order");
+    check(levelAmount(book, OrderBookType::bid, 10) == 3, "level 10 holds 3");
+    unsigned int reused = book.add(bid);
+    check(queue(book, OrderBookType::bid) == std::vector<unsigned int>{first, second, reused}, "an order added on a reused node goes to the back");
+
+    testSection("fills and pending takers");
+    book.updateAmount(first, 0.5);
+    check(book.find(first)->amount == 0.5 && queue(book, OrderBookType::bid).front() == first, "a partly filled order keeps its place");
+    book.updateAmount(first, 0);
+    check(book.find(first) == nullptr, "a filled order is removed");
+    OrderBookEntry ioc = bid;
+    ioc.execution = OrderExecution::ioc;
+    unsigned int taker = book.add(ioc);
+    check(book.find(taker) != nullptr && levelAmount(book, OrderBookType::bid, 10) == 2, "an IOC order waits outside the levels");
+    check(!book.replace(taker, 10, 2), "a pending taker cannot be replaced");
+    book.updateAmount(taker, 0.5);
+    check(book.find(taker) == nullptr, "a taker is dropped after its match whatever is left");
+    check(book.size() == 2, "two orders left");
+
+    testSection("refused orders");
+    OrderBookEntry bad = bid;
+    bad.price = std::numeric_limits<double>::quiet_NaN();
+    check(book.add(bad) == 0, "a NaN price is refused");
+    bad.price = std::numeric_limits<double>::infinity();
+    check(book.add(bad) == 0, "an infinite price is refused");
+    bad.price = 0;
+    check(book.add(bad) == 0, "a price of 0 is refused");
+    bad = bid;
+    bad.amount = std::numeric_limits<double>::quiet_NaN();
+    check(book.add(bad) == 0, "a NaN amount is refused");
+    bad.amount = -1;
+    check(book.add(bad) == 0, "a negative amount is refused");
+    bad = bid;
+    bad.execution = OrderExecution::market;
+    bad.price = 0;
+    unsigned int market = book.add(bad);
+    check(market != 0 && book.cancel(market), "a market order's price only has to be finite");
+    check(book.size() == 2 && book.getLevels(OrderBookType::bid, "ETH/BTC")->size() == 1, "no refused order reached a level");
+
+    testSection("levels as of a time");
+    RestingOrders timed;
+    OrderBookEntry early{10, 1, "2020/03/17 17:01:24.884492", "ETH/BTC", OrderBookType::ask, "simuser"};
+    OrderBookEntry late{10, 2, "2020/03/17 17:01:30.000000", "ETH/BTC", OrderBookType::ask, "simuser"};
+    timed.add(early);
+    unsigned int lateId = timed.add(late);
+    timed.add(OrderBookEntry{11, 4, early.timestamp, "ETH/BTC", OrderBookType::ask, "simuser"});
+    check(timed.getLevelsAsOf(OrderBookType::ask, "ETH/BTC", late.timestamp) == timed.getLevels(OrderBookType::ask, "ETH/BTC"),
+          "at the newest order's time the level totals are used");
+    check(timed.getLevelsAsOf(OrderBookType::ask, "ETH/BTC", early.timestamp) == nullptr, "not before it");
+    check(sameLevels(timed.getLevels(OrderBookType::ask, "ETH/BTC", late.timestamp), {{10, 3, 2}, {11, 4, 1}}),
+          "now: 3 at 10 and 4 at 11, best first");
+    check(sameLevels(timed.getLevels(OrderBookType::ask, "ETH/BTC", early.timestamp), {{10, 1, 1}, {11, 4, 1}}),
+          "looking back leaves out the later order");
+    timed.cancel(lateId);
+    check(sameLevels(timed.getLevels(OrderBookType::ask, "ETH/BTC", early.timestamp), {{10, 1, 1}, {11, 4, 1}}),
+          "and gives the same once it is gone");
+    check(timed.getLevelsAsOf(OrderBookType::bid, "ETH/BTC", late.timestamp) == nullptr, "an empty side has no levels");
+
+    testSection("price and amount columns");
+    std::vector<double> prices, amounts;
+    timed.add(late);
+    OrderBookEntry pending = early;
+    pending.execution = OrderExecution::ioc;
+    pending.price = 12;
+    timed.add(pending);
+    timed.collect(OrderBookType::ask, "ETH/BTC", early.timestamp, prices, amounts);
+    check(prices == std::vector<double>{10, 11, 12} && amounts == std::vector<double>{1, 4, 1},
+          "the orders entered by then, the pending taker last");
+    prices.clear();
+    amounts.clear();
+    timed.collect(OrderBookType::ask, "ETH/BTC", late.timestamp, prices, amounts);
+    check(prices.size() == 4 && amounts[1] == 2, "later, the order added since as well");
+
+    return testFailures();
+}
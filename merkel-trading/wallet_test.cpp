@@ -62,6 +62,55 @@ int main()
         std::cout << "Exception caught for removeCurrency with negative amount!" << std::endl;
     }
     
+    std::cout << "\n5. Testing reservations for open orders:" << std::endl;
+    Wallet funded{};
+    funded.insertCurrency("BTC", 10);
+    OrderBookEntry first{14, 0.7, "2020/03/17 17:01:24.88492", "ETH/BTC", OrderBookType::bid, "simuser"};
+    first.id = 1;
+    std::cout << "Can bid 0.7 ETH at 14 BTC? " << (funded.canFulfillOrder(first) ? "Yes" : "No") << std::endl;
+    funded.reserve(first);
+    std::cout << "BTC reserved: " << funded.getReserved("BTC") << " available: " << funded.getAvailable("BTC") << std::endl;
+
+    OrderBookEntry second = first;
+    second.id = 2;
+    std::cout << "Can a second bid of the same size be funded? (expect No) "
+              << (funded.canFulfillOrder(second) ? "Yes" : "No") << std::endl;
+    OrderBookEntry bigger = first;
+    bigger.amount = 0.71;
+    std::cout << "Can order 1 be replaced by 0.71 ETH at 14? (expect Yes) "
+              << (funded.canFulfillOrder(bigger) ? "Yes" : "No") << std::endl;
+
+    OrderBookEntry partial = first;
+    partial.amount = 0.2;
+    funded.keepReserved({partial});
+    std::cout << "After a partial fill BTC reserved: " << funded.getReserved("BTC") << " (expect 2.8)" << std::endl;
+    funded.keepReserved({});
+    std::cout << "After the fill BTC reserved: " << funded.getReserved("BTC") << " (expect 0)" << std::endl;
+    funded.reserve(second);
+    funded.release(2);
+    std::cout << "After a cancel BTC reserved: " << funded.getReserved("BTC") << " (expect 0)" << std::endl;
+
+    OrderBookEntry overdraw{14, 0.8, "2020/03/17 17:01:24.88492", "ETH/BTC", OrderBookType::bidsale, "simuser"};
+    bool paid = funded.processSale(overdraw);
+    std::cout << "Buying 0.8 ETH for 11.2 BTC with 10 held processed? (expect No) " << (paid ? "Yes" : "No") << std::endl;
+    std::cout << "Wallet contents: " << funded.toString() << std::endl;
+
+    std::cout << "\n6. Testing realized profit:" << std::endl;
+    Wallet valued{};
+    valued.insertCurrency("BTC", 10);
+    valued.setReferenceCurrency("BTC");
+    std::cout << "Marking ETH/BTC at 0.02 split as ETH, BTC priced? (expect Yes) "
+              << (valued.markPrice("ETH", "BTC", 0.02) ? "Yes" : "No") << std::endl;
+    OrderBookEntry buy{0.02, 100, "2020/03/17 17:01:24.88492", "ETH/BTC", OrderBookType::bidsale, "simuser"};
+    valued.processSale(buy);
+    OrderBookEntry sell{0.03, 100, "2020/03/17 17:01:30.88492", "ETH/BTC", OrderBookType::asksale, "simuser"};
+    valued.processSale(sell);
+    std::cout << "Bought 100 ETH at 0.02, sold at 0.03, realized: " << valued.getValuation().realized
+              << " (expect 1)" << std::endl;
+    OrderBookEntry empty{0.03, 1e-13, "2020/03/17 17:01:36.88492", "ETH/BTC", OrderBookType::asksale, "simuser"};
+    std::cout << "Selling ETH with none left processed? (expect No) " << (valued.processSale(empty) ? "Yes" : "No")
+              << ", realized: " << valued.getValuation().realized << " (expect 1)" << std::endl;
+
     std::cout << "\nFinal wallet state:" << std::endl;
     std::cout << myWallet.toString() << std::endl;
     